@@ -18,6 +18,7 @@ unix|mac {
 
 INCLUDEPATH = \
 	../externals/minizip/src \
+	../externals/zlib/src \
 	../externals/IBK/src \
 	../externals/IBKMK/src \
 	../externals/TiCPP/src
@@ -30,10 +31,15 @@ LIBS += -L../externals/lib \
 	-lz
 
 SOURCES += \
+	src/MSIM_AbstractAlgorithm.cpp \
 	src/MSIM_AlgorithmGaussJacobi.cpp \
 	src/MSIM_AlgorithmGaussSeidel.cpp \
 	src/MSIM_AlgorithmNewton.cpp \
 	src/MSIM_ArgParser.cpp \
+	src/MSIM_BinaryResults.cpp \
+	src/MSIM_CheckpointWriter.cpp \
+	src/MSIM_ChunkStore.cpp \
+	src/MSIM_CompressedResults.cpp \
 	src/MSIM_Constants.cpp \
 	src/MSIM_FMIType.cpp \
 	src/MSIM_FMIVariable.cpp \
@@ -43,9 +49,16 @@ SOURCES += \
 	src/MSIM_FileReaderSlave.cpp \
 	src/MSIM_MasterSim.cpp \
 	src/MSIM_ModelDescription.cpp \
+	src/MSIM_OutputAggregator.cpp \
+	src/MSIM_OutputFilter.cpp \
+	src/MSIM_OutputQueue.cpp \
 	src/MSIM_OutputWriter.cpp \
 	src/MSIM_ProgressFeedback.cpp \
-	src/MSIM_Project.cpp
+	src/MSIM_Project.cpp \
+	src/MSIM_RowFormatter.cpp \
+	src/MSIM_SlaveGraph.cpp \
+	src/MSIM_SnapshotBuffer.cpp \
+	src/MSIM_ThreadPool.cpp
 
 HEADERS += \
 	src/MSIM_AbstractAlgorithm.h \
@@ -54,6 +67,10 @@ HEADERS += \
 	src/MSIM_AlgorithmGaussSeidel.h \
 	src/MSIM_AlgorithmNewton.h \
 	src/MSIM_ArgParser.h \
+	src/MSIM_BinaryResults.h \
+	src/MSIM_CheckpointWriter.h \
+	src/MSIM_ChunkStore.h \
+	src/MSIM_CompressedResults.h \
 	src/MSIM_Constants.h \
 	src/MSIM_FMIType.h \
 	src/MSIM_FMIVariable.h \
@@ -63,9 +80,16 @@ HEADERS += \
 	src/MSIM_FileReaderSlave.h \
 	src/MSIM_MasterSim.h \
 	src/MSIM_ModelDescription.h \
+	src/MSIM_OutputAggregator.h \
+	src/MSIM_OutputFilter.h \
+	src/MSIM_OutputQueue.h \
 	src/MSIM_OutputWriter.h \
 	src/MSIM_ProgressFeedback.h \
 	src/MSIM_Project.h \
+	src/MSIM_RowFormatter.h \
+	src/MSIM_SlaveGraph.h \
+	src/MSIM_SnapshotBuffer.h \
+	src/MSIM_ThreadPool.h \
 	src/fmi/fmi2FunctionTypes.h \
 	src/fmi/fmi2Functions.h \
 	src/fmi/fmi2TypesPlatform.h \
@@ -0,0 +1,65 @@
+#include "MSIM_AbstractAlgorithm.h"
+
+#include "MSIM_MasterSim.h"
+#include "MSIM_AbstractSlave.h"
+
+namespace MASTER_SIM {
+
+void AbstractAlgorithm::init() {
+	m_slaveTimers.resize(m_master->m_slaves.size());
+}
+
+
+AbstractAlgorithm::Result AbstractAlgorithm::evaluateCycles() {
+	unsigned int nCycles = (unsigned int)m_master->m_cycles.size();
+	if (m_master->m_threadPool.threadCount() < 2 || nCycles < 2) {
+		// sequential evaluation, stop at first failed cycle
+		for (unsigned int c=0; c<nCycles; ++c) {
+			Result res = doCycle(c);
+			if (res != R_CONVERGED)
+				return res;
+		}
+		return R_CONVERGED;
+	}
+
+	// Parallel evaluation of independent cycles.
+	// When a cycle fails, cycles with higher index are not started anymore (they would be skipped in sequential
+	// evaluation as well), but cycles with lower index are completed. Hence, the returned result is the same
+	// as in sequential evaluation.
+	std::vector<Result> results(nCycles, R_CONVERGED);
+	std::atomic<unsigned int> firstFailedCycle(nCycles);
+	m_master->m_threadPool.runTaskGraph(m_master->m_cycleSuccessors, [&](unsigned int c) {
+		if (c > firstFailedCycle)
+			return; // skip cycle
+		results[c] = doCycle(c);
+		if (results[c] != R_CONVERGED) {
+			unsigned int failed = firstFailedCycle;
+			while (c < failed && !firstFailedCycle.compare_exchange_weak(failed, c))
+				;
+		}
+	});
+
+	for (unsigned int c=0; c<nCycles; ++c)
+		if (results[c] != R_CONVERGED)
+			return results[c];
+	return R_CONVERGED;
+}
+
+
+void AbstractAlgorithm::rollBackSlave(AbstractSlave * slave) {
+	// slaves with cheap roll-back only reset their time
+	if (slave->supportsCheapRollback()) {
+		slave->setState(m_master->m_t, nullptr);
+		m_master->invalidateInputCache(slave);
+		return;
+	}
+	// mind: we use a timer per slave here, since cycles may be processed in parallel
+	IBK::StopWatch & timer = m_slaveTimers[slave->m_slaveIndex];
+	timer.start();
+	slave->setState(m_master->m_t, m_master->m_iterationStates[slave->m_slaveIndex]);
+	m_master->invalidateInputCache(slave);
+	m_master->m_statRollBackTimes[slave->m_slaveIndex] += 1e-3*timer.stop(); // add elapsed time in seconds
+	++m_master->m_statRollBackCounters[slave->m_slaveIndex];
+}
+
+} // namespace MASTER_SIM
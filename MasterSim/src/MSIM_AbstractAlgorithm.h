@@ -1,11 +1,15 @@
 #ifndef MSIM_ABSTRACTALGORITHM_H
 #define MSIM_ABSTRACTALGORITHM_H
 
+#include <vector>
+#include <atomic>
+
 #include <IBK_StopWatch.h>
 
 namespace MASTER_SIM {
 
 class MasterSim;
+class AbstractSlave;
 
 /*! Abstract base class for implementation of master algorithms.
 */
@@ -23,18 +27,39 @@ public:
 		m_master(master),
 		m_nIterations(0),
 		m_nIterationLimitExceeded(0),
-		m_nFMUErrors(0)
+		m_nFMUErrors(0),
+		m_nJacobianGenerations(0),
+		m_nJacobianUpdates(0)
 	{}
 
 	/*! Virtual d'tor. */
 	virtual ~AbstractAlgorithm() {}
 
-	/*! Initialization function, called once all slaves have been set up. */
-	virtual void init() {}
+	/*! Initialization function, called once all slaves have been set up.
+		Default implementation creates the per-slave timers; re-implementations must call this function.
+	*/
+	virtual void init();
 
 	/*! Main stepper function for master algorithm. */
 	virtual Result doStep() = 0;
 
+	/*! Discards all data that the algorithm carries over from one step to the next (e.g. Jacobian matrices
+		reused across steps). Called when parameters have been changed. Default implementation does nothing.
+	*/
+	virtual void discardStepHistory() {}
+
+	/*! Stores all data that the algorithm carries over from one step to the next in a byte array.
+		Called when the master state is stored (checkpoints and snapshots), so that a simulation continued
+		from a stored state takes the same steps as the original simulation.
+		Default implementation stores nothing.
+	*/
+	virtual void serializeStepHistory(std::vector<char> & data) const { data.clear(); }
+
+	/*! Restores data stored with serializeStepHistory(), throws an exception if data does not match
+		the current setup. Default implementation does nothing.
+	*/
+	virtual void deserializeStepHistory(const std::vector<char> & data) { (void)data; }
+
 	/*! Returns collected statistics. */
 	void stats(unsigned int	& nIterations, unsigned int & nIterationLimitExceeded, unsigned int & nFMUErrors) {
 		nIterations = m_nIterations;
@@ -42,19 +67,65 @@ public:
 		nFMUErrors = m_nFMUErrors;
 	}
 
+	/*! Returns collected statistics about Jacobian matrix generations and updates (only Newton algorithm). */
+	void jacobianStats(unsigned int & nJacobianGenerations, unsigned int & nJacobianUpdates) {
+		nJacobianGenerations = m_nJacobianGenerations;
+		nJacobianUpdates = m_nJacobianUpdates;
+	}
+
+	/*! Sets collected statistics, used when restarting from a checkpoint. */
+	void restoreStats(unsigned int nIterations, unsigned int nIterationLimitExceeded, unsigned int nFMUErrors,
+					  unsigned int nJacobianGenerations, unsigned int nJacobianUpdates)
+	{
+		m_nIterations = nIterations;
+		m_nIterationLimitExceeded = nIterationLimitExceeded;
+		m_nFMUErrors = nFMUErrors;
+		m_nJacobianGenerations = nJacobianGenerations;
+		m_nJacobianUpdates = nJacobianUpdates;
+	}
+
 protected:
+	/*! Processes a single cycle (evaluates all slaves of the cycle, iterates until converged).
+		Called from evaluateCycles(), possibly in parallel for independent cycles.
+		Default implementation does nothing and returns R_CONVERGED.
+		\param c Cycle index.
+	*/
+	virtual Result doCycle(unsigned int c) { (void)c; return R_CONVERGED; }
+
+	/*! Calls doCycle() for all cycles of the master.
+		When the master's thread pool is running, cycles that do not exchange any variables with each other
+		are processed in parallel (see MasterSim::m_cycleSuccessors). Otherwise, cycles are processed in sequence.
+		In both cases, the results are the same.
+		\return Returns result of failed cycle with lowest index, or R_CONVERGED if all cycles have converged.
+	*/
+	Result evaluateCycles();
+
+	/*! Rolls back a slave to the state stored in MasterSim::m_iterationStates at the begin of the current step and
+		updates the roll-back statistics. Slaves with cheap roll-back (see AbstractSlave::supportsCheapRollback())
+		only reset their time.
+		Can be called concurrently for different slaves.
+	*/
+	void rollBackSlave(AbstractSlave * slave);
+
 	/*! Cached pointer to master data structure (not owned). */
 	MasterSim		*m_master;
 
 	/*! Timer to use for instrumenting calls to FMUs. */
 	IBK::StopWatch	m_timer;
 
+	/*! One timer per slave (index matches m_slaveIndex), so that timing works with parallel evaluation. */
+	std::vector<IBK::StopWatch>		m_slaveTimers;
+
 	/*! Number of iterations. */
-	unsigned int	m_nIterations;
+	std::atomic<unsigned int>	m_nIterations;
 	/*! Number of iteration limits exceeded. */
-	unsigned int	m_nIterationLimitExceeded;
+	std::atomic<unsigned int>	m_nIterationLimitExceeded;
 	/*! Number of times the algorithm has to be repeated because of FMU errors. */
-	unsigned int	m_nFMUErrors;
+	std::atomic<unsigned int>	m_nFMUErrors;
+	/*! Number of Jacobian matrix generations (with DQ approximation). */
+	std::atomic<unsigned int>	m_nJacobianGenerations;
+	/*! Number of Broyden updates of Jacobian matrixes. */
+	std::atomic<unsigned int>	m_nJacobianUpdates;
 };
 
 } // namespace MASTER_SIM
@@ -22,7 +22,7 @@ namespace MASTER_SIM {
 class AbstractSlave {
 public:
 	/*! Constructor. */
-	AbstractSlave(const std::string & name) : m_name(name), m_t(0) {}
+	AbstractSlave(const std::string & name) : m_name(name), m_stateless(false), m_t(0) {}
 
 	/*! Destructor. */
 	virtual ~AbstractSlave() {}
@@ -49,12 +49,39 @@ public:
 	/*! Call getFMUState() function in fmu and retrieves current state as pointer. */
 	virtual void currentState(fmi2FMUstate * state) const = 0;
 
-	/*! Sets the state of the FMU (roll-back to recorded state). */
+	/*! Sets the state of the FMU (roll-back to recorded state).
+		For stateless slaves (isStateless() returns true) only the time is reset and slaveState is ignored.
+	*/
 	virtual void setState(double t, fmi2FMUstate slaveState) = 0;
 
-	/*! Retrieve all output quantities from slave and store in local vectors. */
+	/*! Releases a state obtained via currentState() and sets it to nullptr.
+		Mind: states passed to currentState() that are not nullptr are updated in place, so a state
+		needs only be released when it is no longer used.
+	*/
+	virtual void freeState(fmi2FMUstate * state) = 0;
+
+	/*! Retrieve output quantities from slave and store in local vectors.
+		Slaves may skip output quantities that are not needed for connections, these are retrieved
+		in cacheRecordedOutputs() when needed.
+	*/
 	virtual void cacheOutputs() = 0;
 
+	/*! Retrieve output quantities skipped in cacheOutputs(), called before outputs are written.
+		Default implementation does nothing (for slaves that retrieve all outputs in cacheOutputs()).
+	*/
+	virtual void cacheRecordedOutputs() {}
+
+	/*! Serializes the current state of the slave into a byte array (used for checkpoint files).
+		Throws an exception if the slave does not support serialization of its state.
+	*/
+	virtual void serializeCurrentState(std::vector<char> & data) const = 0;
+
+	/*! Restores the slave state from data created by serializeCurrentState() and updates the cached outputs.
+		\param t Simulation time point of the serialized state.
+		\param data Serialized state.
+	*/
+	virtual void restoreSerializedState(double t, const std::vector<char> & data) = 0;
+
 	/*! Sets an input variable of type real in the slave.
 		This is essentially a wrapper function around fmiSetReal or fmi2SetReal, depending on the
 		standard supported by the FMU.
@@ -79,18 +106,73 @@ public:
 	*/
 	virtual void setString(unsigned int valueReference, const std::string & str) = 0;
 
+	/*! Sets several input variables of type real in the slave with a single call.
+		This is essentially a wrapper function around fmiSetReal or fmi2SetReal, depending on the
+		standard supported by the FMU.
+		\param valueReferences Array with value references of the input variables.
+		\param values Array with values to set.
+		\param count Number of variables in both arrays.
+	*/
+	virtual void setReals(const unsigned int * valueReferences, const double * values, unsigned int count) = 0;
+
+	/*! Sets several input variables of type int in the slave with a single call.
+		This is essentially a wrapper function around fmiSetInteger or fmi2SetInteger, depending on the
+		standard supported by the FMU.
+	*/
+	virtual void setIntegers(const unsigned int * valueReferences, const int * values, unsigned int count) = 0;
+
+	/*! Sets several input variables of type bool in the slave with a single call.
+		This is essentially a wrapper function around fmiSetBoolean or fmi2SetBoolean, depending on the
+		standard supported by the FMU.
+	*/
+	virtual void setBooleans(const unsigned int * valueReferences, const fmi2Boolean * values, unsigned int count) = 0;
+
+	/*! Returns true, if the slave can compute directional derivatives of real outputs with respect to real inputs. */
+	virtual bool providesDirectionalDerivatives() const = 0;
+
+	/*! Computes directional derivatives of real outputs with respect to real inputs at the current time point.
+		This is essentially a wrapper function around fmi2GetDirectionalDerivative.
+		\param outputIndexes Indexes of the real output variables (in m_doubleOutputs).
+		\param nOutputs Number of output variables.
+		\param inputValueReferences Value references of the real input variables.
+		\param nInputs Number of input variables.
+		\param seed Seed vector (direction of input change), size nInputs.
+		\param derivatives Computed derivatives of outputs, size nOutputs.
+		\return Returns an fmi2Status value, fmi2OK on success.
+	*/
+	virtual int getDirectionalDerivatives(const unsigned int * outputIndexes, unsigned int nOutputs,
+										  const unsigned int * inputValueReferences, unsigned int nInputs,
+										  const double * seed, double * derivatives) = 0;
+
 	/*! Convenience function for setting a variable of type defined by FMIVariable.
 		\param var The variable holding type and value reference.
 		\param value The value as string, will be decoded into the corresponding type.
 	*/
 	virtual void setValue(const FMIVariable & var, const std::string & value) = 0;
 
+	/*! Returns true, if the slave has no internal state that changes over time (outputs depend only on inputs,
+		parameters and time). Default implementation returns m_stateless.
+	*/
+	virtual bool isStateless() const { return m_stateless; }
+
+	/*! Returns true, if the slave can be rolled back without retrieving and setting a state, i.e. setState() called
+		with a nullptr state is sufficient and cheap. The master does not store states of such slaves and resets them
+		without bookkeeping (timers and roll-back counters). Default implementation returns isStateless().
+	*/
+	virtual bool supportsCheapRollback() const { return isStateless(); }
+
 	/*! Simulator/slave ID name. */
 	std::string					m_name;
 
 	/*! Index of this slave in global slave vector of master. */
 	unsigned int				m_slaveIndex;
 
+	/*! If true, the slave has been declared stateless in the project file (outputs depend only on inputs,
+		parameters and time). The master never retrieves the state of such a slave, a roll-back only resets the slave time.
+		Mind: use isStateless() to query the property, slave implementations may be stateless by design.
+	*/
+	bool						m_stateless;
+
 	/*! Cached output variables of type bool, updated at end of doStep(). */
 	std::vector<fmi2Boolean>	m_boolOutputs;
 	/*! Cached output variables of type int, updated at end of doStep(). */
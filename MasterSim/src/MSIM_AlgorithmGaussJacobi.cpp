@@ -11,12 +11,18 @@ void AlgorithmGaussJacobi::init() {
 	// check for valid parameters
 	if (m_master->m_project.m_maxIterations > 1)
 		throw IBK::Exception("Gauss-Jacobi-Algorithm is always used without iteration. The maxIterations parameter must be set to 1.", FUNC_ID);
+
+	AbstractAlgorithm::init();
+
+	// collect slaves of all cycles, since in Gauss-Jacobi all slaves can be evaluated independently
+	for (unsigned int c=0; c<m_master->m_cycles.size(); ++c) {
+		const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+		m_slaves.insert(m_slaves.end(), cycle.m_slaves.begin(), cycle.m_slaves.end());
+	}
 }
 
 
 AbstractAlgorithm::Result AlgorithmGaussJacobi::doStep() {
-	const char * const FUNC_ID = "[AlgorithmGaussJacobi::doStep]";
-
 	// to make things simpler, let's just use fmi2status variables
 	IBK_STATIC_ASSERT((int)fmiOK == (int)fmi2OK);
 
@@ -30,39 +36,45 @@ AbstractAlgorithm::Result AlgorithmGaussJacobi::doStep() {
 
 	// ** algorithm start **
 
-	// loop over all cycles
-	for (unsigned int c=0; c<m_master->m_cycles.size(); ++c) {
-		const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	// one iteration per cycle
+	m_nIterations += (unsigned int)m_master->m_cycles.size();
 
-		++m_nIterations; // add one iteration
+	// Evaluate all slaves, possibly in parallel. This is safe because:
+	// - all slaves read only from m_xxxyt vectors (constant during step)
+	// - each slave writes only to its own slots in the m_xxxytNext vectors
+	// - statistics are stored per slave
+	// The thread pool returns after all slaves have completed, and rethrows any exception
+	// raised while evaluating a slave.
+	m_master->m_threadPool.parallelFor((unsigned int)m_slaves.size(), [this](unsigned int i) {
+		evaluateSlave(m_slaves[i]);
+	});
 
-		// loop over all slaves
-		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
-			AbstractSlave * slave = cycle.m_slaves[s];
+	// ** algorithm end **
 
-			// update input variables in all slaves, using variables from time t
-			m_master->updateSlaveInputs(slave, m_master->m_realyt, m_master->m_intyt, m_master->m_boolyt, m_master->m_stringyt, false);
+	// m_XXXyt     -> still values at time point t
+	// m_XXXytNext -> values at time point t + h
+	return R_CONVERGED; // no other option since we don't iterate
+}
 
-			// advance slave
-			m_timer.start();
-			int res = slave->doStep(m_master->m_h, true);
-			m_master->m_statSlaveEvalTimes[slave->m_slaveIndex] += 1e-3*m_timer.stop(); // add elapsed time in seconds
-			++m_master->m_statSlaveEvalCounters[slave->m_slaveIndex];
-			if (res != fmi2OK)
-				throw IBK::Exception(IBK::FormatString("Error in doStep() call of FMU slave '%1'").arg(slave->m_name), FUNC_ID);
 
+void AlgorithmGaussJacobi::evaluateSlave(AbstractSlave * slave) {
+	const char * const FUNC_ID = "[AlgorithmGaussJacobi::evaluateSlave]";
 
-			// slave is now at time level t + h and its outputs are updated accordingly
-			// sync results into vector with newly computed quantities
-			m_master->syncSlaveOutputs(slave, m_master->m_realytNext, m_master->m_intytNext, m_master->m_boolytNext, m_master->m_stringytNext, false);
-		}
-	}
+	// update input variables in all slaves, using variables from time t
+	m_master->updateSlaveInputs(slave, m_master->m_realyt, m_master->m_intyt, m_master->m_boolyt, m_master->m_stringyt, false);
 
-	// ** algorithm end **
+	// advance slave, mind: we use a timer per slave here, since we may run in parallel
+	IBK::StopWatch & timer = m_slaveTimers[slave->m_slaveIndex];
+	timer.start();
+	int res = slave->doStep(m_master->m_h, true);
+	m_master->m_statSlaveEvalTimes[slave->m_slaveIndex] += 1e-3*timer.stop(); // add elapsed time in seconds
+	++m_master->m_statSlaveEvalCounters[slave->m_slaveIndex];
+	if (res != fmi2OK)
+		throw IBK::Exception(IBK::FormatString("Error in doStep() call of FMU slave '%1'").arg(slave->m_name), FUNC_ID);
 
-	// m_XXXyt     -> still values at time point t
-	// m_XXXytNext -> values at time point t + h
-	return R_CONVERGED; // no other option since we don't iterate
+	// slave is now at time level t + h and its outputs are updated accordingly
+	// sync results into vector with newly computed quantities
+	m_master->syncSlaveOutputs(slave, m_master->m_realytNext, m_master->m_intytNext, m_master->m_boolytNext, m_master->m_stringytNext, false);
 }
 
 
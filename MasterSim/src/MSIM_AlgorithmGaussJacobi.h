@@ -1,14 +1,22 @@
 #ifndef MSIM_ALGORITHMGAUSSJACOBI_H
 #define MSIM_ALGORITHMGAUSSJACOBI_H
 
+#include <vector>
+
 #include "MSIM_AbstractAlgorithm.h"
 
 namespace MASTER_SIM {
 
+class AbstractSlave;
+
 /*! Implementation class for Gauss-Jacobi algorithm.
 
 	This algorithm does not do any state-setting or state-getting, and is
 	compatible with FMI for CoSim v1.
+
+	Since all slaves only use inputs from time level t, they are independent of each other
+	within a step. When the master's thread pool is running (threadCount > 1), all slaves
+	are evaluated concurrently.
 */
 class AlgorithmGaussJacobi : public AbstractAlgorithm {
 public:
@@ -22,6 +30,16 @@ public:
 		Will throw an exception if any of the FMUs fails in unrecoverable manner.
 	*/
 	Result doStep();
+
+private:
+	/*! Evaluates a single slave: updates inputs from time level t, advances slave and syncs outputs
+		into time level t + h vectors.
+		Function is thread-safe for different slaves.
+	*/
+	void evaluateSlave(AbstractSlave * slave);
+
+	/*! All slaves of all cycles in evaluation order, used as task list for parallel evaluation. */
+	std::vector<AbstractSlave*>		m_slaves;
 };
 
 } // namespace MASTER_SIM
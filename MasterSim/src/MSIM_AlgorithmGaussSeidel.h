@@ -2,6 +2,7 @@
 #define MSIM_ALGORITHMGAUSSSEIDEL_H
 
 #include "MSIM_AbstractAlgorithm.h"
+#include "MSIM_MasterSim.h"
 
 namespace MASTER_SIM {
 
@@ -9,6 +10,9 @@ namespace MASTER_SIM {
 
 	If run in non-iterative mode (m_maxIterations parameter == 1),
 	this algorithm does not do any state-setting or state-getting, and is compatible with FMI for CoSim v1.
+
+	Cycles that do not exchange variables with each other are processed in parallel when the master's
+	thread pool is running.
 */
 class AlgorithmGaussSeidel : public AbstractAlgorithm {
 public:
@@ -20,10 +24,20 @@ public:
 	*/
 	Result doStep();
 
-	/*! Performs convergence test by comparing values in m_ytNext and m_ytNextIter.
+	/*! Performs convergence test by comparing values in m_ytNext and m_ytNextIter (only outputs of given cycle).
 		\return Returns true if test has passed.
 	*/
-	bool doConvergenceTest();
+	bool doConvergenceTest(const MasterSim::Cycle & cycle);
+
+protected:
+	/*! Evaluates all slaves of cycle c and iterates until converged (when iteration is enabled).
+		Thread-safe for cycles that do not exchange variables with each other.
+	*/
+	Result doCycle(unsigned int c) override;
+
+private:
+	/*! Copies values of all output variables of the cycle from m_xxxytNext to m_xxxytNextIter. */
+	void copyCycleOutputs(const MasterSim::Cycle & cycle);
 
 };
 
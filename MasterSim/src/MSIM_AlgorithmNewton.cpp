@@ -1,23 +1,69 @@
 #include "MSIM_AlgorithmNewton.h"
 
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cmath>
+
 #include <IBK_assert.h>
 #include <IBK_messages.h>
+#include <IBK_InputOutput.h>
 
 #include "MSIM_MasterSim.h"
 #include "MSIM_AbstractSlave.h"
+#include "MSIM_FMUSlave.h"
 
 namespace MASTER_SIM {
 
+/*! Jacobian is regenerated (with m_reuseJacobian) when step size is larger/smaller by this factor than
+	step size used for generating the Jacobian.
+*/
+const double JACOBIAN_STEPSIZE_CHANGE_LIMIT = 2;
+/*! Jacobian is regenerated (with m_reuseJacobian) when the residual norm of an iteration is larger than
+	this factor times the residual norm of the previous iteration.
+*/
+const double JACOBIAN_CONVERGENCE_RATE_LIMIT = 0.5;
+/*! Maximum number of Broyden updates of a Jacobian before it is regenerated. */
+const unsigned int JACOBIAN_MAX_UPDATES = 20;
+
+
+/*! Releases states and instances of slave copies and clears the vector. */
+static void releaseSlaveCopies(std::vector<AlgorithmNewton::SlaveCopy> & copies) {
+	for (AlgorithmNewton::SlaveCopy & sc : copies) {
+		if (sc.m_slave == nullptr)
+			continue;
+		sc.m_slave->freeState(&sc.m_state);
+		delete sc.m_slave;
+	}
+	copies.clear();
+}
+
+
+AlgorithmNewton::~AlgorithmNewton() {
+	m_jacobianThreadPool.stop();
+	freeSlaveCopies();
+}
+
+
 void AlgorithmNewton::init() {
+	const char * const FUNC_ID = "[AlgorithmNewton::init]";
+	AbstractAlgorithm::init();
+
 	// resize matrix and variable index mapping vectors
 	size_t nCycles = m_master->m_cycles.size();
 	m_jacobianMatrix.resize(nCycles);
+	m_sparseJacobianMatrix.resize(nCycles);
+	m_columnGroups.resize(nCycles);
+	m_columnRows.resize(nCycles);
+	m_deltas.resize(nCycles);
+	m_unperturbedValues.resize(nCycles);
+	m_jacobianReuseData.clear();
+	m_jacobianReuseData.resize(nCycles);
+	m_derivativeSlaves.resize(nCycles);
+	m_directionalDerivativesFailed.assign(m_master->m_slaves.size(), 0);
 	m_variableIdxMapping.resize(nCycles);
 	m_res.resize(m_master->m_realyt.size());
-	// Note: typically, rhs will be smaller than res with more than one cycle is used
-	//       however, since we need continuous memory mapping we have to copy values anyway and
-	//       we can just reuse the array for all cycles - so we make it as big as the possible maximum (all values)
-	m_rhs.resize(m_master->m_realyt.size());
+	m_rhs.resize(nCycles);
 
 	// now process each cycle
 	for (size_t c=0; c<nCycles; ++c) {
@@ -43,25 +89,380 @@ void AlgorithmNewton::init() {
 			}
 		}
 
-		// finally resize DenseMatrix
 		size_t dim = m_variableIdxMapping[c].size();
-		if (dim != 0)
-			m_jacobianMatrix[c].resize((unsigned int)dim);
+		m_rhs[c].resize(dim);
+		m_jacobianReuseData[c].m_lastRhs.resize(dim);
+		m_jacobianReuseData[c].m_lastDelta.resize(dim);
+		m_deltas[c].resize(dim);
+		m_unperturbedValues[c].resize(dim);
 		// Note: dim == 0 means there are no outputs of the slaves in the current cycle connected
 		//       to any of the inputs. Therefore we do not need to iterate in this cycle and can
 		//       just accept the results from the first doStep() calculations.
+		if (dim == 0)
+			continue;
+
+		// determine sparsity pattern and column groups
+		setupJacobianPattern((unsigned int)c);
+
+		// count non-zeros of pattern including fill-in, and decide whether we use a sparse or a dense matrix
+		std::vector<unsigned int> ia, ja;
+		computeFilledPattern((unsigned int)c, ia, ja);
+		unsigned int nnz = (unsigned int)ja.size();
+		// use sparse matrix if at least half of the matrix elements are zero
+		if (2*nnz <= dim*dim)
+			m_sparseJacobianMatrix[c].resize((unsigned int)dim, nnz, &ia[0], &ja[0]);
+		else
+			m_jacobianMatrix[c].resize((unsigned int)dim);
+
+		IBK::IBK_Message(IBK::FormatString("Cycle %1: %2 coupled variables, %3 column groups, %4 Jacobian with %5 non-zeros\n")
+						 .arg(c+1).arg(dim).arg(m_columnGroups[c].size())
+						 .arg(m_sparseJacobianMatrix[c].n() != 0 ? "sparse" : "dense").arg(nnz),
+						 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+		for (const DerivativeSlave & ds : m_derivativeSlaves[c])
+			IBK::IBK_Message(IBK::FormatString("  Slave '%1' provides directional derivatives\n").arg(ds.m_slave->m_name),
+							 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
 	}
+
+	// create slave copies for concurrent DQ approximation
+	createSlaveCopies();
 }
 
 
-AlgorithmNewton::Result AlgorithmNewton::doStep() {
-	const char * const FUNC_ID = "[AlgorithmNewton::doStep]";
+void AlgorithmNewton::createSlaveCopies() {
+	const char * const FUNC_ID = "[AlgorithmNewton::createSlaveCopies]";
+	freeSlaveCopies();
+	unsigned int nCopies = m_master->m_project.m_jacobianSlaveCopies;
+	if (nCopies == 0)
+		return;
 
+	size_t nCycles = m_master->m_cycles.size();
+	m_slaveCopies.resize(m_master->m_slaves.size());
+	m_serializedStates.resize(m_master->m_slaves.size());
+	m_copyPerturbations.resize(nCycles);
+	for (size_t c=0; c<nCycles; ++c) {
+		if (m_variableIdxMapping[c].empty())
+			continue; // no Jacobian needed
+		const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+			AbstractSlave * slave = cycle.m_slaves[s];
+			if (m_master->m_slaveConnections[slave->m_slaveIndex].m_realInputs.empty())
+				continue; // slave is never evaluated during DQ approximation
+			if (slave->isStateless()) {
+				// copies of stateless slaves cannot be synchronized via FMU state (parameters would be missing)
+				IBK::IBK_Message(IBK::FormatString("Slave '%1' is stateless and is not copied, Jacobian of cycle %2 is computed "
+												   "with original slaves.\n").arg(slave->m_name).arg(c+1),
+								 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+				continue;
+			}
+			FMUSlave * fmuSlave = dynamic_cast<FMUSlave*>(slave);
+			if (fmuSlave == nullptr || !fmuSlave->canBeCopied()) {
+				IBK::IBK_Message(IBK::FormatString("Slave '%1' cannot be copied (requires FMI 2 with serializable FMU state), "
+												   "Jacobian of cycle %2 is computed with original slaves.\n").arg(slave->m_name).arg(c+1),
+								 IBK::MSG_WARNING, FUNC_ID, IBK::VL_STANDARD);
+				continue;
+			}
+			std::vector<SlaveCopy> & copies = m_slaveCopies[slave->m_slaveIndex];
+			try {
+				for (unsigned int k=0; k<nCopies; ++k) {
+					copies.push_back(SlaveCopy());
+					copies.back().m_slave = new FMUSlave(const_cast<FMU*>(fmuSlave->fmu()),
+														 IBK::FormatString("%1_copy%2").arg(slave->m_name).arg(k+1).str());
+					FMUSlave * copy = copies.back().m_slave;
+					copy->m_slaveIndex = slave->m_slaveIndex;
+					copy->selectOutputs(*fmuSlave);
+					copy->instantiate();
+					// bring copy into the same mode as the original slave, the actual state is set later via FMU state
+					copy->setupExperiment(m_master->m_project.m_relTol, m_master->m_project.m_tStart.value, m_master->m_project.m_tEnd.value);
+					copy->enterInitializationMode();
+					copy->exitInitializationMode();
+				}
+			}
+			catch (IBK::Exception & ex) {
+				ex.writeMsgStackToError();
+				IBK::IBK_Message(IBK::FormatString("Error creating copies of slave '%1', Jacobian of cycle %2 is computed with original slaves.\n")
+								 .arg(slave->m_name).arg(c+1), IBK::MSG_WARNING, FUNC_ID, IBK::VL_STANDARD);
+				releaseSlaveCopies(copies);
+			}
+		}
+		m_copyPerturbations[c].assign(nCopies, std::vector<double>(m_master->m_realyt.size(), 0));
+	}
+
+	// do not use more threads than configured for the master, even if there are more copies
+	m_jacobianThreadPool.start(std::min(nCopies, m_master->m_project.m_threadCount));
+}
+
+
+void AlgorithmNewton::freeSlaveCopies() {
+	for (std::vector<SlaveCopy> & copies : m_slaveCopies)
+		releaseSlaveCopies(copies);
+	m_slaveCopies.clear();
+	m_serializedStates.clear();
+	m_copyPerturbations.clear();
+}
+
+
+bool AlgorithmNewton::addDirectionalDerivatives(unsigned int c) {
+	const char * const FUNC_ID = "[AlgorithmNewton::addDirectionalDerivatives]";
+	IBKMK::SparseMatrixCSR & sparseMat = m_sparseJacobianMatrix[c];
+	IBKMK::DenseMatrix & denseMat = m_jacobianMatrix[c];
+	bool sparse = (sparseMat.n() != 0);
+
+	for (DerivativeSlave & ds : m_derivativeSlaves[c]) {
+		// one call per column, seed holds the scale factors of all inputs connected to the column variable
+		for (unsigned int col : ds.m_columns) {
+			for (unsigned int k=0; k<ds.m_inputColumns.size(); ++k)
+				ds.m_seed[k] = (ds.m_inputColumns[k] == col) ? ds.m_inputScaleFactors[k] : 0;
+			int res = ds.m_slave->getDirectionalDerivatives(&ds.m_outputIndexes[0], (unsigned int)ds.m_outputIndexes.size(),
+															&ds.m_inputValueRefs[0], (unsigned int)ds.m_inputValueRefs.size(),
+															&ds.m_seed[0], &ds.m_derivatives[0]);
+			if (res != fmi2OK) {
+				IBK::IBK_Message(IBK::FormatString("Computing directional derivatives of slave '%1' failed, using "
+												   "difference-quotient approximation instead.\n").arg(ds.m_slave->m_name),
+								 IBK::MSG_WARNING, FUNC_ID, IBK::VL_STANDARD);
+				m_directionalDerivativesFailed[ds.m_slave->m_slaveIndex] = 1;
+				return false;
+			}
+			for (unsigned int r=0; r<ds.m_rows.size(); ++r) {
+				if (sparse)
+					sparseMat(ds.m_rows[r], col) -= ds.m_derivatives[r];
+				else
+					denseMat(ds.m_rows[r], col) -= ds.m_derivatives[r];
+			}
+		}
+	}
+	return true;
+}
+
+
+void AlgorithmNewton::backsolve(unsigned int c, double * b) {
+	JacobianReuseData & reuseData = m_jacobianReuseData[c];
+	unsigned int n = (unsigned int)m_rhs[c].size();
+	// H*b = (LU)^-1*b + sum_k u_k (v_k^T b), compute dot products with original b first
+	unsigned int nUpdates = (unsigned int)reuseData.m_u.size();
+	reuseData.m_dots.resize(nUpdates);
+	for (unsigned int k=0; k<nUpdates; ++k) {
+		const std::vector<double> & v = reuseData.m_v[k];
+		double dot = 0;
+		for (unsigned int i=0; i<n; ++i)
+			dot += v[i]*b[i];
+		reuseData.m_dots[k] = dot;
+	}
+
+	if (m_sparseJacobianMatrix[c].n() != 0)
+		m_sparseJacobianMatrix[c].backsolveILU(b);
+	else
+		m_jacobianMatrix[c].backsolve(b);
+
+	for (unsigned int k=0; k<nUpdates; ++k) {
+		const std::vector<double> & u = reuseData.m_u[k];
+		double dot = reuseData.m_dots[k];
+		for (unsigned int i=0; i<n; ++i)
+			b[i] += u[i]*dot;
+	}
+}
+
+
+void AlgorithmNewton::broydenUpdate(unsigned int c, const std::vector<double> & rhs) {
+	JacobianReuseData & reuseData = m_jacobianReuseData[c];
+	if (reuseData.m_u.size() >= JACOBIAN_MAX_UPDATES) {
+		// too many updates, rather generate a new Jacobian in the next step
+		reuseData.m_valid = false;
+		return;
+	}
+	unsigned int n = (unsigned int)rhs.size();
+
+	// We use the inverse ("second") Broyden update, which only requires solving with the current inverse:
+	//   H+ = H + (s - H y) y^T / (y^T y)
+	// with s = delta of last iteration and y = F(y_i) - F(y_{i-1}) = rhs_{i-1} - rhs_i, since rhs = -F.
+	std::vector<double> v(n);
+	double yy = 0;
+	for (unsigned int i=0; i<n; ++i) {
+		v[i] = reuseData.m_lastRhs[i] - rhs[i];
+		yy += v[i]*v[i];
+	}
+	if (yy == 0)
+		return; // no change in residuals, no information for an update
+
+	std::vector<double> u(v);
+	backsolve(c, &u[0]); // u = H y
+	for (unsigned int i=0; i<n; ++i) {
+		u[i] = reuseData.m_lastDelta[i] - u[i];
+		v[i] /= yy;
+	}
+	reuseData.m_u.push_back(u);
+	reuseData.m_v.push_back(v);
+	++m_nJacobianUpdates;
+}
+
+
+void AlgorithmNewton::setupJacobianPattern(unsigned int c) {
+	const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	const std::vector<unsigned int> & varIdxMapping = m_variableIdxMapping[c];
+	unsigned int dim = (unsigned int)varIdxMapping.size();
+
+	// lookup map for matrix index of global variable index
+	std::map<unsigned int, unsigned int> matrixIdx;
+	for (unsigned int i=0; i<dim; ++i)
+		matrixIdx[varIdxMapping[i]] = i;
+
+	// Column i (variable i) affects all slaves with an input connected to variable i, and thus the
+	// coupled outputs (rows) of these slaves.
+	std::vector< std::set<unsigned int> > columnSlaves(dim); // slave indexes affected by each column (DQ only)
+	std::vector< std::vector<unsigned int> > & columnRows = m_columnRows[c];
+	columnRows.clear();
+	columnRows.resize(dim);
+	std::vector<DerivativeSlave> & derivativeSlaves = m_derivativeSlaves[c];
+	derivativeSlaves.clear();
+	for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+		AbstractSlave * slave = cycle.m_slaves[s];
+		const MasterSim::SlaveConnections & conn = m_master->m_slaveConnections[slave->m_slaveIndex];
+		// coupled outputs of this slave
+		std::vector<unsigned int> rows;
+		std::vector<unsigned int> outputIndexes;
+		for (const MasterSim::OutputConnection & o : conn.m_realOutputs) {
+			std::map<unsigned int, unsigned int>::const_iterator it = matrixIdx.find(o.m_variableIndex);
+			if (it != matrixIdx.end()) {
+				rows.push_back(it->second);
+				outputIndexes.push_back(o.m_outputLocalIndex);
+			}
+		}
+
+		// slaves providing directional derivatives are not included in DQ approximation
+		if (m_master->m_project.m_useDirectionalDerivatives && slave->providesDirectionalDerivatives() &&
+			!m_directionalDerivativesFailed[slave->m_slaveIndex])
+		{
+			DerivativeSlave ds;
+			ds.m_slave = slave;
+			ds.m_rows = rows;
+			ds.m_outputIndexes = outputIndexes;
+			for (unsigned int i=0; i<conn.m_realInputs.size(); ++i) {
+				const MasterSim::InputConnection & inp = conn.m_realInputs[i];
+				std::map<unsigned int, unsigned int>::const_iterator it = matrixIdx.find(inp.m_variableIndex);
+				if (it == matrixIdx.end())
+					continue;
+				ds.m_inputValueRefs.push_back(conn.m_realInputValueRefs[i]);
+				ds.m_inputColumns.push_back(it->second);
+				ds.m_inputScaleFactors.push_back(inp.m_scaleFactor);
+			}
+			if (ds.m_rows.empty() || ds.m_inputColumns.empty())
+				continue; // slave does not contribute to the Jacobian
+			ds.m_columns = ds.m_inputColumns;
+			std::sort(ds.m_columns.begin(), ds.m_columns.end());
+			ds.m_columns.erase(std::unique(ds.m_columns.begin(), ds.m_columns.end()), ds.m_columns.end());
+			ds.m_seed.resize(ds.m_inputColumns.size());
+			ds.m_derivatives.resize(ds.m_rows.size());
+			derivativeSlaves.push_back(ds);
+			continue;
+		}
+
+		for (const MasterSim::InputConnection & inp : conn.m_realInputs) {
+			std::map<unsigned int, unsigned int>::const_iterator it = matrixIdx.find(inp.m_variableIndex);
+			if (it == matrixIdx.end())
+				continue;
+			unsigned int col = it->second;
+			if (!columnSlaves[col].insert(slave->m_slaveIndex).second)
+				continue; // slave has several inputs connected to the same variable
+			columnRows[col].insert(columnRows[col].end(), rows.begin(), rows.end());
+		}
+	}
+	for (std::vector<unsigned int> & rows : columnRows) {
+		std::sort(rows.begin(), rows.end());
+		rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+	}
+
+	// greedy coloring: columns can be perturbed together, if they do not affect the same slave
+	std::vector< std::set<unsigned int> > groupSlaves;
+	std::vector<ColumnGroup> & groups = m_columnGroups[c];
+	groups.clear();
+	for (unsigned int col=0; col<dim; ++col) {
+		if (columnSlaves[col].empty())
+			continue; // no DQ approximation needed for this column
+		unsigned int g=0;
+		for (; g<groups.size(); ++g) {
+			bool conflict = false;
+			for (unsigned int slaveIdx : columnSlaves[col]) {
+				if (groupSlaves[g].find(slaveIdx) != groupSlaves[g].end()) {
+					conflict = true;
+					break;
+				}
+			}
+			if (!conflict)
+				break;
+		}
+		if (g == groups.size()) {
+			groups.push_back(ColumnGroup());
+			groupSlaves.push_back(std::set<unsigned int>());
+		}
+		groups[g].m_columns.push_back(col);
+		groupSlaves[g].insert(columnSlaves[col].begin(), columnSlaves[col].end());
+	}
+
+	// store affected slaves of each group in evaluation order of cycle
+	for (unsigned int g=0; g<groups.size(); ++g) {
+		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+			AbstractSlave * slave = cycle.m_slaves[s];
+			if (groupSlaves[g].find(slave->m_slaveIndex) != groupSlaves[g].end())
+				groups[g].m_slaves.push_back(slave);
+		}
+	}
+}
+
+
+void AlgorithmNewton::computeFilledPattern(unsigned int c, std::vector<unsigned int> & ia, std::vector<unsigned int> & ja) const {
+	const std::vector< std::vector<unsigned int> > & columnRows = m_columnRows[c];
+	unsigned int dim = (unsigned int)columnRows.size();
+
+	// symmetric pattern (without diagonal), composed of DQ approximated and analytical parts
+	std::vector< std::set<unsigned int> > adjacency(dim);
+	for (unsigned int col=0; col<dim; ++col) {
+		for (unsigned int row : columnRows[col]) {
+			if (row == col)
+				continue;
+			adjacency[row].insert(col);
+			adjacency[col].insert(row);
+		}
+	}
+	for (const DerivativeSlave & ds : m_derivativeSlaves[c]) {
+		for (unsigned int col : ds.m_columns) {
+			for (unsigned int row : ds.m_rows) {
+				if (row == col)
+					continue;
+				adjacency[row].insert(col);
+				adjacency[col].insert(row);
+			}
+		}
+	}
+
+	// symbolic elimination without pivoting: when eliminating k, all neighbors of k with higher index
+	// become connected with each other
+	for (unsigned int k=0; k<dim; ++k) {
+		std::set<unsigned int>::const_iterator first = adjacency[k].upper_bound(k);
+		for (std::set<unsigned int>::const_iterator it = first; it != adjacency[k].end(); ++it) {
+			std::set<unsigned int>::const_iterator it2 = it;
+			for (++it2; it2 != adjacency[k].end(); ++it2) {
+				adjacency[*it].insert(*it2);
+				adjacency[*it2].insert(*it);
+			}
+		}
+	}
+
+	// compose CSR index vectors, including diagonal
+	ia.resize(dim+1);
+	ja.clear();
+	for (unsigned int i=0; i<dim; ++i) {
+		ia[i] = (unsigned int)ja.size();
+		adjacency[i].insert(i);
+		ja.insert(ja.end(), adjacency[i].begin(), adjacency[i].end());
+	}
+	ia[dim] = (unsigned int)ja.size();
+}
+
+
+AlgorithmNewton::Result AlgorithmNewton::doStep() {
 	// to make things simpler, let's just use fmi2status variables
 	IBK_STATIC_ASSERT((int)fmiOK == (int)fmi2OK);
 
 	// master and FMUs are expected to be at current time point t
-	double t = m_master->m_t;
 
 	// all slave output variables are expected to be in sync with internal states of slaves
 	// i.e. cacheOutputs() has been called successfully on all slaves
@@ -91,104 +492,281 @@ AlgorithmNewton::Result AlgorithmNewton::doStep() {
 	MasterSim::copyVector(m_master->m_boolyt, m_master->m_boolytNext);
 	std::copy(m_master->m_stringyt.begin(), m_master->m_stringyt.end(), m_master->m_stringytNext.begin());
 
-	// loop over all cycles
-	for (unsigned int c=0; c<m_master->m_cycles.size(); ++c) {
-		const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	// m_realytNextIter is kept in sync with m_realytNext for all variables except the outputs of the cycle
+	// currently being processed
+	MasterSim::copyVector(m_master->m_realytNext, m_master->m_realytNextIter);
 
-		unsigned int iteration = 0; // iteration counter in current cycle
-		while (++iteration <= m_master->m_project.m_maxIterations) {
-			++m_nIterations;
-
-			// copy current estimates to y_{t+h} to NextIter vectors, they will be used to update ytNext vectors once cycle
-			// is complete
-			MasterSim::copyVector(m_master->m_realytNext, m_master->m_realytNextIter);
-			MasterSim::copyVector(m_master->m_intytNext, m_master->m_intytNextIter);
-			MasterSim::copyVector(m_master->m_boolytNext, m_master->m_boolytNextIter);
-			std::copy(m_master->m_stringytNext.begin(), m_master->m_stringytNext.end(), m_master->m_stringytNextIter.begin());
-
-			if (iteration > 1) {
-				// except for the first iteration, roll-back all slaves in this cycle
-				for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
-					AbstractSlave * slave = cycle.m_slaves[s];
-					slave->setState(t, m_master->m_iterationStates[slave->m_slaveIndex]);
-				}
+	// process all cycles, independent cycles possibly in parallel
+	Result res = evaluateCycles();
+
+	// ** algorithm end **
+
+	// m_XXXyt     -> still values at time point t
+	// m_XXXytNext -> values at time point t + h
+	return res;
+}
+
+
+void AlgorithmNewton::discardStepHistory() {
+	for (JacobianReuseData & reuseData : m_jacobianReuseData) {
+		reuseData.m_valid = false;
+		reuseData.m_u.clear();
+		reuseData.m_v.clear();
+	}
+}
+
+
+void AlgorithmNewton::serializeStepHistory(std::vector<char> & data) const {
+	// Memory layout per cycle:
+	//   1 char = valid flag, only with valid Jacobian:
+	//   1 double = step size for which the Jacobian has been generated
+	//   1 uint32_t = number of Broyden updates, followed by all u and v vectors
+	//   factorized Jacobian matrix (sparse or dense)
+	size_t dataSize = 0;
+	for (unsigned int c=0; c<m_jacobianReuseData.size(); ++c) {
+		const JacobianReuseData & reuseData = m_jacobianReuseData[c];
+		dataSize += sizeof(char);
+		if (!reuseData.m_valid)
+			continue;
+		dataSize += sizeof(double) + sizeof(uint32_t);
+		dataSize += 2*reuseData.m_u.size()*(sizeof(uint32_t) + m_rhs[c].size()*sizeof(double));
+		if (m_sparseJacobianMatrix[c].n() != 0)
+			dataSize += m_sparseJacobianMatrix[c].serializationSize();
+		else
+			dataSize += m_jacobianMatrix[c].serializationSize();
+	}
+	data.resize(dataSize);
+	if (dataSize == 0)
+		return;
+
+	void * dataPtr = &data[0];
+	for (unsigned int c=0; c<m_jacobianReuseData.size(); ++c) {
+		const JacobianReuseData & reuseData = m_jacobianReuseData[c];
+		*(char*)dataPtr = reuseData.m_valid ? 1 : 0;
+		dataPtr = (char*)dataPtr + sizeof(char);
+		if (!reuseData.m_valid)
+			continue;
+		*(double*)dataPtr = reuseData.m_h;
+		dataPtr = (char*)dataPtr + sizeof(double);
+		*(uint32_t*)dataPtr = (uint32_t)reuseData.m_u.size();
+		dataPtr = (char*)dataPtr + sizeof(uint32_t);
+		for (unsigned int k=0; k<reuseData.m_u.size(); ++k) {
+			IBK::serialize_vector(dataPtr, reuseData.m_u[k]);
+			IBK::serialize_vector(dataPtr, reuseData.m_v[k]);
+		}
+		if (m_sparseJacobianMatrix[c].n() != 0)
+			m_sparseJacobianMatrix[c].serialize(dataPtr);
+		else
+			m_jacobianMatrix[c].serialize(dataPtr);
+	}
+	IBK_ASSERT((char*)dataPtr == data.data() + data.size());
+}
+
+
+void AlgorithmNewton::deserializeStepHistory(const std::vector<char> & data) {
+	const char * const FUNC_ID = "[AlgorithmNewton::deserializeStepHistory]";
+
+	// Mind: the IBK/IBKMK deserialization functions do not know the size of the buffer, hence we check
+	//       that enough data is left before each read
+	const char * const dataEnd = data.data() + data.size();
+	void * dataPtr = const_cast<char*>(data.data());
+	auto checkSize = [&](size_t n) {
+		if (n > (size_t)(dataEnd - (const char*)dataPtr))
+			throw IBK::Exception("Jacobian data does not match current simulation setup.", FUNC_ID);
+	};
+
+	for (unsigned int c=0; c<m_jacobianReuseData.size(); ++c) {
+		JacobianReuseData & reuseData = m_jacobianReuseData[c];
+		size_t n = m_rhs[c].size();
+		checkSize(sizeof(char));
+		reuseData.m_valid = (*(const char*)dataPtr != 0);
+		dataPtr = (char*)dataPtr + sizeof(char);
+		reuseData.m_u.clear();
+		reuseData.m_v.clear();
+		if (!reuseData.m_valid)
+			continue;
+		checkSize(sizeof(double) + sizeof(uint32_t));
+		reuseData.m_h = *(const double*)dataPtr;
+		dataPtr = (char*)dataPtr + sizeof(double);
+		unsigned int nUpdates = *(const uint32_t*)dataPtr;
+		dataPtr = (char*)dataPtr + sizeof(uint32_t);
+		if (nUpdates > JACOBIAN_MAX_UPDATES)
+			throw IBK::Exception("Jacobian data does not match current simulation setup.", FUNC_ID);
+		checkSize(2*nUpdates*(sizeof(uint32_t) + n*sizeof(double)));
+		// Mind: deserialize_vector() checks the vector sizes
+		reuseData.m_u.resize(nUpdates, std::vector<double>(n));
+		reuseData.m_v.resize(nUpdates, std::vector<double>(n));
+		for (unsigned int k=0; k<nUpdates; ++k) {
+			IBK::deserialize_vector(dataPtr, reuseData.m_u[k]);
+			IBK::deserialize_vector(dataPtr, reuseData.m_v[k]);
+		}
+		if (m_sparseJacobianMatrix[c].n() != 0) {
+			// sparse matrix pattern is set up in init(), deserialize() checks the dimensions
+			checkSize(m_sparseJacobianMatrix[c].serializationSize());
+			m_sparseJacobianMatrix[c].deserialize(dataPtr);
+		}
+		else {
+			// pivots of dense matrix are only allocated once the matrix has been factorized, hence we
+			// use recreate() after checking the stored dimension (type, n, data and pivot vectors)
+			checkSize(sizeof(char) + 3*sizeof(uint32_t) + n*n*sizeof(double) + n*sizeof(unsigned int));
+			if (*(const uint32_t*)((const char*)dataPtr + sizeof(char)) != n)
+				throw IBK::Exception("Jacobian data does not match current simulation setup.", FUNC_ID);
+			m_jacobianMatrix[c].recreate(dataPtr);
+		}
+	}
+	if ((const char*)dataPtr != dataEnd)
+		throw IBK::Exception("Jacobian data does not match current simulation setup.", FUNC_ID);
+}
+
+
+AbstractAlgorithm::Result AlgorithmNewton::doCycle(unsigned int c) {
+	const char * const FUNC_ID = "[AlgorithmNewton::doCycle]";
+
+	// master and FMUs are expected to be at current time point t
+	const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	std::vector<double> & rhs = m_rhs[c];
+	const bool reuseJacobian = m_master->m_project.m_reuseJacobian;
+	JacobianReuseData & reuseData = m_jacobianReuseData[c];
+	bool jacobianGenerated = false; // true, if Jacobian has been generated in this step
+	double lastResNorm = 0;
+
+	unsigned int iteration = 0; // iteration counter in current cycle
+	while (++iteration <= m_master->m_project.m_maxIterations) {
+		++m_nIterations;
+
+		// copy current estimates to y_{t+h} to NextIter vectors, they will be used to update ytNext vectors once cycle
+		// is complete; only outputs of this cycle can differ
+		for (unsigned int i : cycle.m_realOutputs)
+			m_master->m_realytNextIter[i] = m_master->m_realytNext[i];
+
+		if (iteration > 1) {
+			// except for the first iteration, roll-back all slaves in this cycle
+			for (unsigned int s=0; s<cycle.m_slaves.size(); ++s)
+				rollBackSlave(cycle.m_slaves[s]);
+		}
+
+		// loop over all slaves and compute S(y_{t+h}^i)
+		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+			AbstractSlave * slave = cycle.m_slaves[s];
+			Result res = evaluateSlave(slave, m_master->m_realytNext, m_res);
+			if (res != R_CONVERGED) {
+				++m_nFMUErrors;
+				return res;
 			}
+		}
 
-			// loop over all slaves and compute S(y_{t+h}^i)
-			for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
-				AbstractSlave * slave = cycle.m_slaves[s];
-				Result res = evaluateSlave(slave, m_master->m_realytNext, m_res);
+		// m_res now holds Sy and m_realytNext holds y_{t+h}^i (last iteration step)
+
+		size_t varCount = m_variableIdxMapping[c].size();
+		if (varCount == 0) {
+			// if we do not have any variables connected in this cycle, we can move on to the next cycle
+			break;
+		}
+
+		// TODO : We may add here a convergence test already and stop if we are fulfilling
+		//        the tolerance criterion.
+
+		// compute difference of all variables connected in current cycle and store in vector rhs
+		for (unsigned int i=0; i<varCount; ++i) {
+			unsigned int varIdx = m_variableIdxMapping[c][i]; // global index of variable
+			rhs[i] = m_res[varIdx] - m_master->m_realytNext[varIdx]; // = - (y - Sy)
+		}
+
+		if (!reuseJacobian) {
+			if (iteration == 1) {
+				// in first iteration generate Jacobian matrix
+				Result res = generateJacobian(c);
 				if (res != R_CONVERGED) {
 					++m_nFMUErrors;
 					return res;
 				}
 			}
-
-			// m_res now holds Sy and m_realytNext holds y_{t+h}^i (last iteration step)
-
-			size_t varCount = m_variableIdxMapping[c].size();
-			if (varCount == 0) {
-				// if we do not have any variables connected in this cycle, we can move on to the next cycle
-				break;
-			}
-
-			// TODO : We may add here a convergence test already and stop if we are fulfilling
-			//        the tolerance criterion.
-
-			// compute difference of all variables connected in current cycle and store in vector m_res
+		}
+		else {
+			// WRMS norm of residuals
+			double resNorm = 0;
 			for (unsigned int i=0; i<varCount; ++i) {
 				unsigned int varIdx = m_variableIdxMapping[c][i]; // global index of variable
-				m_rhs[i] = m_res[varIdx] - m_master->m_realytNext[varIdx]; // = - (y - Sy)
+				double weight = std::fabs(m_master->m_realytNextIter[varIdx])*m_master->m_project.m_relTol + m_master->m_project.m_absTol;
+				resNorm += (rhs[i]/weight)*(rhs[i]/weight);
 			}
+			resNorm = std::sqrt(resNorm/varCount);
 
-			if (iteration == 1) {
-				// in first iteration generate Jacobian matrix, if dimension is 0, this is a NOOP
-				generateJacobian(c);
+			// decide whether we need a new Jacobian
+			bool generate = !reuseData.m_valid;
+			if (!generate && iteration == 1) {
+				double hRatio = m_master->m_h/reuseData.m_h;
+				if (hRatio > JACOBIAN_STEPSIZE_CHANGE_LIMIT || hRatio < 1/JACOBIAN_STEPSIZE_CHANGE_LIMIT)
+					generate = true;
 			}
+			if (!generate && iteration > 1 && !jacobianGenerated && resNorm > JACOBIAN_CONVERGENCE_RATE_LIMIT*lastResNorm)
+				generate = true;
 
-			// backsolve with Jacobian, we use only the first m_variableIdxMapping[c].size() values of m_res
-			m_jacobianMatrix[c].backsolve(&m_rhs[0]);
-			// m_rhs contains now delta_y^{i+1}
-
-			// do convergence test with WRMS norm of
-			double norm = 0;
-			for (unsigned int i=0; i<varCount; ++i) {
-				unsigned int varIdx = m_variableIdxMapping[c][i]; // global index of variable
-				double delta = m_rhs[i];
-				double absValue = std::fabs(m_master->m_realytNextIter[varIdx]);
-				double weight = absValue*m_master->m_project.m_relTol + m_master->m_project.m_absTol;
-				delta /= weight;
-				norm += delta*delta;
-				// also update next iterative guess
-				m_master->m_realytNext[varIdx] = m_master->m_realytNextIter[varIdx] + m_rhs[i];
+			if (generate) {
+				// Mind: generateJacobian() uses the current iterate and residuals, so we can call it in any iteration
+				Result res = generateJacobian(c);
+				if (res != R_CONVERGED) {
+					++m_nFMUErrors;
+					reuseData.m_valid = false;
+					return res;
+				}
+				reuseData.m_h = m_master->m_h;
+				reuseData.m_valid = true;
+				reuseData.m_u.clear();
+				reuseData.m_v.clear();
+				jacobianGenerated = true;
 			}
-			norm = std::sqrt(norm/varCount);
-			IBK_FastMessage(IBK::VL_DETAILED)(IBK::FormatString("  NEWTON: WRMS norm = %1\n").arg(norm, 12, 'f', 0), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_DETAILED);
-			if (norm < 1)
-				break; // break iteration loop
-		} // while (++iteration <= m_master->m_project.m_maxIterations)
-
-		if (iteration > m_master->m_project.m_maxIterations) {
-			++m_nIterationLimitExceeded;
-			return R_ITERATION_LIMIT_EXCEEDED;
+			else if (iteration > 1) {
+				broydenUpdate(c, rhs);
+			}
+			lastResNorm = resNorm;
+			std::copy(rhs.begin(), rhs.end(), reuseData.m_lastRhs.begin());
 		}
 
-		// cycle done, also sync variables of other types with global variable array ytNext so that the results
-		// of the current cycle are available in the next cycle
-		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
-			AbstractSlave * slave = cycle.m_slaves[s];
-			// Note: when we have converged, m_master->m_realytNext holds corrected solution (with delta added), when
-			//       we now sync again with the last state of the slaves, we actually get the last iterative value
-			//       stored in the slave. However, the difference should be within the error limit.
-			m_master->syncSlaveOutputs(slave, m_master->m_realytNext, m_master->m_intytNext, m_master->m_boolytNext, m_master->m_stringytNext, false);
+		// backsolve with Jacobian
+		backsolve(c, &rhs[0]);
+		// rhs contains now delta_y^{i+1}
+		if (reuseJacobian)
+			std::copy(rhs.begin(), rhs.end(), reuseData.m_lastDelta.begin());
+
+		// do convergence test with WRMS norm of
+		double norm = 0;
+		for (unsigned int i=0; i<varCount; ++i) {
+			unsigned int varIdx = m_variableIdxMapping[c][i]; // global index of variable
+			double delta = rhs[i];
+			double absValue = std::fabs(m_master->m_realytNextIter[varIdx]);
+			double weight = absValue*m_master->m_project.m_relTol + m_master->m_project.m_absTol;
+			delta /= weight;
+			norm += delta*delta;
+			// also update next iterative guess
+			m_master->m_realytNext[varIdx] = m_master->m_realytNextIter[varIdx] + rhs[i];
 		}
+		norm = std::sqrt(norm/varCount);
+		IBK_FastMessage(IBK::VL_DETAILED)(IBK::FormatString("  NEWTON: WRMS norm = %1\n").arg(norm, 12, 'f', 0), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_DETAILED);
+		if (norm < 1)
+			break; // break iteration loop
+	} // while (++iteration <= m_master->m_project.m_maxIterations)
 
-	} // cycles
+	if (iteration > m_master->m_project.m_maxIterations) {
+		++m_nIterationLimitExceeded;
+		// do not reuse a Jacobian that failed to converge
+		reuseData.m_valid = false;
+		return R_ITERATION_LIMIT_EXCEEDED;
+	}
 
-	// ** algorithm end **
+	// cycle done, also sync variables of other types with global variable array ytNext so that the results
+	// of the current cycle are available in the next cycle
+	for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+		AbstractSlave * slave = cycle.m_slaves[s];
+		// Note: when we have converged, m_master->m_realytNext holds corrected solution (with delta added), when
+		//       we now sync again with the last state of the slaves, we actually get the last iterative value
+		//       stored in the slave. However, the difference should be within the error limit.
+		m_master->syncSlaveOutputs(slave, m_master->m_realytNext, m_master->m_intytNext, m_master->m_boolytNext, m_master->m_stringytNext, false);
+	}
+	// restore sync between m_realytNextIter and m_realytNext for outputs of this cycle
+	for (unsigned int i : cycle.m_realOutputs)
+		m_master->m_realytNextIter[i] = m_master->m_realytNext[i];
 
-	// m_XXXyt     -> still values at time point t
-	// m_XXXytNext -> values at time point t + h
 	return R_CONVERGED;
 }
 
@@ -198,10 +776,11 @@ AbstractAlgorithm::Result AlgorithmNewton::evaluateSlave(AbstractSlave * slave,
 	// update input variables in all slaves, using variables from time t
 	m_master->updateSlaveInputs(slave, xi, m_master->m_intyt, m_master->m_boolyt, m_master->m_stringyt, true);
 
-	// advance slave
-	m_timer.start();
+	// advance slave, mind: we use a timer per slave here, since cycles may be processed in parallel
+	IBK::StopWatch & timer = m_slaveTimers[slave->m_slaveIndex];
+	timer.start();
 	int res = slave->doStep(m_master->m_h, true);
-	m_master->m_statSlaveEvalTimes[slave->m_slaveIndex] += 1e-3*m_timer.stop(); // add elapsed time in seconds
+	m_master->m_statSlaveEvalTimes[slave->m_slaveIndex] += 1e-3*timer.stop(); // add elapsed time in seconds
 	++m_master->m_statSlaveEvalCounters[slave->m_slaveIndex];
 	switch (res) {
 		case fmi2Discard	:
@@ -222,58 +801,291 @@ AbstractAlgorithm::Result AlgorithmNewton::evaluateSlave(AbstractSlave * slave,
 }
 
 
-void AlgorithmNewton::generateJacobian(unsigned int c) {
+AbstractAlgorithm::Result AlgorithmNewton::generateJacobian(unsigned int c) {
 	const char * const FUNC_ID = "[AlgorithmNewton::generateJacobian]";
-	if (m_jacobianMatrix[c].n() == 0)
-		return;
+	unsigned int varCount = (unsigned int)m_variableIdxMapping[c].size();
+	if (varCount == 0)
+		return R_CONVERGED;
+
+	++m_nJacobianGenerations;
 
-	MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	IBKMK::SparseMatrixCSR & sparseMat = m_sparseJacobianMatrix[c];
+	IBKMK::DenseMatrix & denseMat = m_jacobianMatrix[c];
+	bool sparse = (sparseMat.n() != 0);
+	std::vector<double> & deltas = m_deltas[c];
+	std::vector<double> & unperturbedValues = m_unperturbedValues[c];
 
 	// m_realyt holds y_{t} = y_{t+h}^0
 	// m_realytNextIter holds also y_{t+h}^0
 
-	MasterSim::copyVector(m_res, m_master->m_realytNext);
-	// m_realytNext now holds Sy=S(y_{t+h}^0)
+	for (unsigned int i : cycle.m_realOutputs)
+		m_master->m_realytNext[i] = m_res[i];
+	// m_realytNext now holds Sy=S(y_{t+h}^0) for all outputs of this cycle
 
-	// We now modify values of m_realyt, evaluate slaves, compute DQ approximations and
-	// restore values in m_realyt
-
-	// loop all variables in this cycle
-	size_t varCount = m_variableIdxMapping[c].size();
-	for (unsigned int i=0; i<(unsigned int)varCount; ++i) {
-		unsigned int varIdx = m_variableIdxMapping[c][i]; // global index of variable
-		// modify variable
-		double delta = std::fabs(m_master->m_realytNext[varIdx])*m_master->m_project.m_relTol + 0.01*m_master->m_project.m_absTol;
-		m_master->m_realytNextIter[varIdx] += delta;
-		// evaluate all slaves in cycle
-		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
-			AbstractSlave * slave = cycle.m_slaves[s];
-			// reset slave
-			slave->setState(m_master->m_t, m_master->m_iterationStates[slave->m_slaveIndex]);
-			// then evaluate slave
-			evaluateSlave(slave, m_master->m_realytNextIter, m_res);
+	// Jacobian is I - dS/dy, start with unit matrix (mind: also the fill-in elements must be zero) and
+	// add derivatives of slaves providing directional derivatives; if any of these fails, the slave is
+	// switched to DQ approximation and we start over
+	bool derivativesDone = false;
+	while (!derivativesDone) {
+		if (sparse) {
+			std::fill(sparseMat.data(), sparseMat.data() + sparseMat.dataSize(), 0);
+			for (unsigned int i=0; i<varCount; ++i)
+				sparseMat(i,i) = 1;
+		}
+		else {
+			denseMat.setZero();
+			for (unsigned int i=0; i<varCount; ++i)
+				denseMat(i,i) = 1;
 		}
-		// restore original values
-		m_master->m_realytNextIter[varIdx] -= delta;
-		// compute dS/dy = (Sy(y+delta) - Sy(y))/delta
+		derivativesDone = addDirectionalDerivatives(c);
+		if (!derivativesDone)
+			setupJacobianPattern(c);
+	}
+
+	// use slave copies if all slaves that need to be evaluated have copies
+	bool useCopies = !m_copyPerturbations.empty() && !m_copyPerturbations[c].empty();
+	for (unsigned int g=0; useCopies && g<m_columnGroups[c].size(); ++g) {
+		for (AbstractSlave * slave : m_columnGroups[c][g].m_slaves)
+			if (m_slaveCopies[slave->m_slaveIndex].empty())
+				useCopies = false;
+	}
+	if (useCopies)
+		useCopies = synchronizeSlaveCopies(c);
+	if (useCopies) {
+		Result res = generateJacobianColumnsWithCopies(c);
+		if (res != R_CONVERGED)
+			return res;
+	}
+
+	// Without copies, we now modify values of m_realytNextIter, evaluate slaves, compute DQ approximations and
+	// restore values in m_realytNextIter
 
-		for (unsigned int j=0; j<varCount; ++j) {
-			unsigned int colVarIdx = m_variableIdxMapping[c][j]; // global index of variable
-			// process column i, row j
-			double dq = -(m_res[colVarIdx] - m_master->m_realytNext[colVarIdx])/delta;
-			// add unit matrix
-			if (j == i)
-				dq += 1;
-			// store in Jacobian matrix column
-			m_jacobianMatrix[c](i,j) = dq;
+	// loop all column groups in this cycle
+	for (unsigned int g=0; !useCopies && g<m_columnGroups[c].size(); ++g) {
+		const ColumnGroup & group = m_columnGroups[c][g];
+		// modify all variables of this group
+		for (unsigned int col : group.m_columns) {
+			unsigned int varIdx = m_variableIdxMapping[c][col]; // global index of variable
+			deltas[col] = std::fabs(m_master->m_realytNext[varIdx])*m_master->m_project.m_relTol + 0.01*m_master->m_project.m_absTol;
+			unperturbedValues[col] = m_master->m_realytNextIter[varIdx];
+			m_master->m_realytNextIter[varIdx] += deltas[col];
 		}
+		// evaluate all slaves affected by these variables
+		Result res = R_CONVERGED;
+		for (AbstractSlave * slave : group.m_slaves) {
+			// reset slave, then evaluate slave
+			rollBackSlave(slave);
+			res = evaluateSlave(slave, m_master->m_realytNextIter, m_res);
+			if (res != R_CONVERGED)
+				break;
+		}
+		// restore original values and compute dS/dy = (Sy(y+delta) - Sy(y))/delta
+		for (unsigned int col : group.m_columns) {
+			unsigned int varIdx = m_variableIdxMapping[c][col]; // global index of variable
+			m_master->m_realytNextIter[varIdx] = unperturbedValues[col]; // (y + delta) - delta may differ from y
+			if (res != R_CONVERGED)
+				continue; // outputs of failed slave evaluation must not enter the Jacobian
+			// process all rows affected by this column, since columns of a group affect disjoint sets of
+			// slaves, each of these rows is only affected by this column
+			for (unsigned int row : m_columnRows[c][col]) {
+				unsigned int rowVarIdx = m_variableIdxMapping[c][row]; // global index of variable
+				double dq = -(m_res[rowVarIdx] - m_master->m_realytNext[rowVarIdx])/deltas[col];
+				if (sparse)
+					sparseMat(row,col) += dq;
+				else
+					denseMat(row,col) += dq;
+			}
+		}
+		if (res != R_CONVERGED)
+			return res;
+	}
 
+	// the DQ approximation left the original slaves with the outputs and states of a perturbed evaluation, re-evaluate
+	// them with the unperturbed values, so that the iteration continues as if the slaves had not been touched (as when
+	// slave copies are used)
+	for (unsigned int s=0; !useCopies && s<cycle.m_slaves.size(); ++s) {
+		AbstractSlave * slave = cycle.m_slaves[s];
+		bool perturbed = false;
+		for (unsigned int g=0; !perturbed && g<m_columnGroups[c].size(); ++g) {
+			const std::vector<AbstractSlave*> & groupSlaves = m_columnGroups[c][g].m_slaves;
+			perturbed = std::find(groupSlaves.begin(), groupSlaves.end(), slave) != groupSlaves.end();
+		}
+		if (!perturbed)
+			continue;
+		rollBackSlave(slave);
+		Result res = evaluateSlave(slave, m_master->m_realytNextIter, m_res);
+		if (res != R_CONVERGED)
+			return res;
 	}
 
 	// factorize matrix
-	if (m_jacobianMatrix[c].lu() != 0)
-		throw IBK::Exception("Error during LU factorization of matrix.", FUNC_ID);
+	if (sparse) {
+		// pattern includes fill-in, so this is a complete LU factorization (without pivoting)
+		sparseMat.ilu();
+		for (unsigned int i=0; i<varCount; ++i) {
+			double diag = sparseMat.value(i,i);
+			if (diag == 0 || !std::isfinite(diag))
+				throw IBK::Exception("Error during LU factorization of sparse matrix.", FUNC_ID);
+		}
+	}
+	else {
+		if (denseMat.lu() != 0)
+			throw IBK::Exception("Error during LU factorization of matrix.", FUNC_ID);
+	}
+	return R_CONVERGED;
+}
+
+
+bool AlgorithmNewton::synchronizeSlaveCopies(unsigned int c) {
+	const char * const FUNC_ID = "[AlgorithmNewton::synchronizeSlaveCopies]";
+	const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	const unsigned int nCopies = (unsigned int)m_copyPerturbations[c].size();
+
+	try {
+		// serialize iteration states of all original slaves with copies
+		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+			unsigned int slaveIdx = cycle.m_slaves[s]->m_slaveIndex;
+			if (m_slaveCopies[slaveIdx].empty())
+				continue;
+			// only FMUSlaves have copies
+			const FMUSlave * slave = static_cast<const FMUSlave*>(cycle.m_slaves[s]);
+			slave->serializeState(m_master->m_iterationStates[slaveIdx], m_serializedStates[slaveIdx]);
+		}
+
+		// de-serialize states in copies, copy k only touches its own instances
+		std::function<void(unsigned int)> task = [&](unsigned int k) {
+			for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+				unsigned int slaveIdx = cycle.m_slaves[s]->m_slaveIndex;
+				if (m_slaveCopies[slaveIdx].empty())
+					continue;
+				SlaveCopy & sc = m_slaveCopies[slaveIdx][k];
+				sc.m_slave->deserializeState(m_serializedStates[slaveIdx], &sc.m_state);
+			}
+		};
+		std::unique_lock<std::mutex> lock(m_jacobianThreadPoolMutex, std::try_to_lock);
+		if (lock.owns_lock())
+			m_jacobianThreadPool.parallelFor(nCopies, task);
+		else
+			for (unsigned int k=0; k<nCopies; ++k)
+				task(k);
+	}
+	catch (IBK::Exception & ex) {
+		// FMU does not support transferring states between instances, do not use copies in this cycle anymore
+		ex.writeMsgStackToError();
+		IBK::IBK_Message(IBK::FormatString("Cannot synchronize slave copies, Jacobian of cycle %1 is computed with original slaves.\n")
+						 .arg(c+1), IBK::MSG_WARNING, FUNC_ID, IBK::VL_STANDARD);
+		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s)
+			releaseSlaveCopies(m_slaveCopies[cycle.m_slaves[s]->m_slaveIndex]);
+		m_copyPerturbations[c].clear();
+		return false;
+	}
+	return true;
 }
 
 
+AbstractAlgorithm::Result AlgorithmNewton::generateJacobianColumnsWithCopies(unsigned int c) {
+	const char * const FUNC_ID = "[AlgorithmNewton::generateJacobianColumnsWithCopies]";
+	const MasterSim::Cycle & cycle = m_master->m_cycles[c];
+	const std::vector<ColumnGroup> & groups = m_columnGroups[c];
+	const std::vector<unsigned int> & varIdxMapping = m_variableIdxMapping[c];
+	IBKMK::SparseMatrixCSR & sparseMat = m_sparseJacobianMatrix[c];
+	IBKMK::DenseMatrix & denseMat = m_jacobianMatrix[c];
+	bool sparse = (sparseMat.n() != 0);
+	std::vector<double> & deltas = m_deltas[c];
+	const double t = m_master->m_t;
+	const unsigned int nCopies = (unsigned int)m_copyPerturbations[c].size();
+
+	// perturbations, same as without copies (m_realytNext holds Sy)
+	for (const ColumnGroup & group : groups) {
+		for (unsigned int col : group.m_columns) {
+			unsigned int varIdx = varIdxMapping[col]; // global index of variable
+			deltas[col] = std::fabs(m_master->m_realytNext[varIdx])*m_master->m_project.m_relTol + 0.01*m_master->m_project.m_absTol;
+		}
+	}
+
+	// set by copy k, if an evaluation of one of its slaves failed (recoverable error)
+	std::vector<char> copyFailed(nCopies, false);
+
+	// copy k processes column groups k, k + nCopies, k + 2*nCopies, ..., so that the results do not depend
+	// on the number of threads or on the scheduling of the tasks
+	std::function<void(unsigned int)> task = [&](unsigned int k) {
+		std::vector<double> & perturbations = m_copyPerturbations[c][k];
+		IBK::StopWatch timer;
+		for (unsigned int g=k; g<groups.size(); g += nCopies) {
+			const ColumnGroup & group = groups[g];
+			for (unsigned int col : group.m_columns)
+				perturbations[varIdxMapping[col]] = deltas[col];
+
+			// evaluate copies of all slaves affected by these variables
+			for (AbstractSlave * slave : group.m_slaves) {
+				SlaveCopy & sc = m_slaveCopies[slave->m_slaveIndex][k];
+				sc.m_slave->setState(t, sc.m_state);
+				// set all real inputs, since the copy may have been used with other perturbations before
+				const MasterSim::SlaveConnections & conn = m_master->m_slaveConnections[slave->m_slaveIndex];
+				sc.m_inputValues.resize(conn.m_realInputs.size());
+				for (unsigned int i=0; i<conn.m_realInputs.size(); ++i) {
+					const MasterSim::InputConnection & inp = conn.m_realInputs[i];
+					double value = m_master->m_realytNextIter[inp.m_variableIndex] + perturbations[inp.m_variableIndex];
+					sc.m_inputValues[i] = inp.m_offset + inp.m_scaleFactor*value;
+				}
+				sc.m_slave->setReals(&conn.m_realInputValueRefs[0], &sc.m_inputValues[0], (unsigned int)sc.m_inputValues.size());
+				timer.start();
+				int res = sc.m_slave->doStep(m_master->m_h, true);
+				sc.m_evalTime += 1e-3*timer.stop();
+				++sc.m_evalCount;
+				if (res == fmi2Fatal || res == fmi2Pending)
+					throw IBK::Exception(IBK::FormatString("Error in doStep() call of slave '%1'").arg(sc.m_slave->m_name), FUNC_ID);
+				if (res == fmi2Error || res == fmi2Discard) {
+					// same as with original slaves, the master step is repeated, outputs of the copy are not used
+					copyFailed[k] = true;
+					for (unsigned int col : group.m_columns)
+						perturbations[varIdxMapping[col]] = 0;
+					return;
+				}
+			}
+
+			// compute dS/dy = (Sy(y+delta) - Sy(y))/delta, rows of the group's columns are coupled outputs of the
+			// evaluated slaves
+			for (unsigned int col : group.m_columns) {
+				perturbations[varIdxMapping[col]] = 0;
+				for (unsigned int row : m_columnRows[c][col]) {
+					unsigned int rowVarIdx = varIdxMapping[row]; // global index of variable
+					const MasterSim::VariableMapping & varMap = m_master->m_realVariableMapping[rowVarIdx];
+					const FMUSlave * copy = m_slaveCopies[varMap.m_outputSlave->m_slaveIndex][k].m_slave;
+					double dq = -(copy->m_doubleOutputs[varMap.m_outputLocalIndex] - m_master->m_realytNext[rowVarIdx])/deltas[col];
+					if (sparse)
+						sparseMat(row,col) += dq;
+					else
+						denseMat(row,col) += dq;
+				}
+			}
+		}
+	};
+
+	// only one cycle at a time may use the thread pool, other cycles evaluate their copies sequentially
+	std::unique_lock<std::mutex> lock(m_jacobianThreadPoolMutex, std::try_to_lock);
+	if (lock.owns_lock())
+		m_jacobianThreadPool.parallelFor(nCopies, task);
+	else
+		for (unsigned int k=0; k<nCopies; ++k)
+			task(k);
+
+	// transfer statistics of copies to original slaves
+	for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+		unsigned int slaveIdx = cycle.m_slaves[s]->m_slaveIndex;
+		for (SlaveCopy & sc : m_slaveCopies[slaveIdx]) {
+			m_master->m_statSlaveEvalTimes[slaveIdx] += sc.m_evalTime;
+			m_master->m_statSlaveEvalCounters[slaveIdx] += sc.m_evalCount;
+			sc.m_evalTime = 0;
+			sc.m_evalCount = 0;
+		}
+	}
+
+	for (unsigned int k=0; k<nCopies; ++k)
+		if (copyFailed[k])
+			return R_RETRY;
+	return R_CONVERGED;
+}
+
 } // namespace MASTER_SIM
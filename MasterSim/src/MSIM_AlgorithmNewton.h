@@ -2,25 +2,53 @@
 #define MSIM_ALGORITHMNEWTON_H
 
 #include <vector>
+#include <mutex>
 
 #include <IBKMK_DenseMatrix.h>
+#include <IBKMK_SparseMatrixCSR.h>
 
 #include "MSIM_AbstractAlgorithm.h"
+#include "MSIM_ThreadPool.h"
+#include "fmi/fmi2Functions.h"
 
 namespace MASTER_SIM {
 
 class AbstractSlave;
+class FMUSlave;
 
 /*! Implementation class for Newton algorithm.
 
-	This algorithm uses a difference-quotient approximation to the Jacobi matrix which is
-	treated as dense matrix.
+	This algorithm uses a difference-quotient approximation to the Jacobi matrix. The sparsity pattern
+	of the Jacobian is derived from the connection graph. Structurally independent columns (columns whose
+	perturbations affect disjoint sets of slaves) are grouped by a greedy coloring and perturbed together,
+	so that the number of slave evaluations depends on the number of column groups instead of the
+	number of coupled variables. Sparse Jacobians are stored and factorized as IBKMK::SparseMatrixCSR,
+	otherwise a dense matrix is used.
+
+	With Project::m_useDirectionalDerivatives, the blocks of slaves that provide directional derivatives are
+	computed with fmi2GetDirectionalDerivative, only the remaining slaves are handled with DQ approximation.
+
+	With Project::m_reuseJacobian, the factorized Jacobian is kept across master steps (modified Newton) and
+	improved with rank-one Broyden updates of its inverse. It is regenerated when the residual of an
+	iteration is not reduced sufficiently, when the step size has changed by more than a factor of 2, when too
+	many updates have been accumulated, or after an iteration failure.
+
+	With Project::m_jacobianSlaveCopies, additional instances of the slaves are created. Before the DQ columns
+	are computed, the copies are synchronized with the iteration state of the original slaves via serialized
+	FMU states, and the column groups are distributed over the copies and evaluated concurrently (with at most
+	Project::m_threadCount threads). The original slaves are not touched while generating the Jacobian.
+
+	Cycles that do not exchange variables with each other are processed in parallel when the master's
+	thread pool is running.
 */
 class AlgorithmNewton : public AbstractAlgorithm {
 public:
 	/*! Default constructor. */
 	AlgorithmNewton(MasterSim * master) : AbstractAlgorithm(master) {}
 
+	/*! Destructor, releases slave copies. */
+	~AlgorithmNewton() override;
+
 	/*! Initializes Jacobian matrix and auxilliary structures. */
 	void init();
 
@@ -29,18 +57,195 @@ public:
 	*/
 	Result doStep();
 
+	/*! Invalidates reused Jacobians and discards Broyden updates of all cycles. */
+	void discardStepHistory() override;
+
+	/*! Stores reused Jacobians (factorized) and Broyden updates of all cycles. */
+	void serializeStepHistory(std::vector<char> & data) const override;
+
+	/*! Restores reused Jacobians and Broyden updates of all cycles. */
+	void deserializeStepHistory(const std::vector<char> & data) override;
+
 	/*! Advances slave using xi as inputs and updates xi1 (only real values). */
 	Result evaluateSlave(MASTER_SIM::AbstractSlave * slave, const std::vector<double> & xi, std::vector<double> & xi1);
 
 	/*! Computes Jacobian using DQ approximation and factorizes it.
 		\param c Cycle index.
+		\return Returns R_RETRY if a slave evaluation failed (fmi2Error or fmi2Discard), the Jacobian is incomplete in this case.
+	*/
+	Result generateJacobian(unsigned int c);
+
+	/*! Transfers the iteration states of the slaves in cycle c to their copies via serialized FMU states.
+		\param c Cycle index.
+		\return Returns false, if the states cannot be transferred. In this case, the copies of the cycle are
+			released and the Jacobian is computed with the original slaves.
+	*/
+	bool synchronizeSlaveCopies(unsigned int c);
+
+	/*! Computes the DQ columns of the Jacobian of cycle c with the slave copies (concurrently, if the
+		Jacobian thread pool is not used by another cycle at the same time). Copies must have been synchronized
+		with synchronizeSlaveCopies() before.
+		\param c Cycle index.
+		\return Returns R_RETRY if the evaluation of a slave copy failed (fmi2Error or fmi2Discard), the remaining
+			column groups of this copy are skipped.
+	*/
+	Result generateJacobianColumnsWithCopies(unsigned int c);
+
+	/*! Creates Project::m_jacobianSlaveCopies copies of all slaves in Newton cycles that support copying. */
+	void createSlaveCopies();
+
+	/*! Releases all slave copies and their states. */
+	void freeSlaveCopies();
+
+	/*! Adds analytical derivatives of all slaves that provide directional derivatives to the Jacobian of cycle c.
+		\param c Cycle index.
+		\return Returns false, if the computation of directional derivatives failed for a slave. In this case,
+			the slave is marked to be handled by DQ approximation in the future.
+	*/
+	bool addDirectionalDerivatives(unsigned int c);
+
+	/*! Solves J x = b with the factorized Jacobian of cycle c (including Broyden updates, if any).
+		\param c Cycle index.
+		\param b Right-hand-side vector, overwritten with solution x.
+	*/
+	void backsolve(unsigned int c, double * b);
+
+	/*! Adds a Broyden update to the inverse Jacobian of cycle c based on the Newton step and residual change
+		of the last iteration.
+		\param c Cycle index.
+		\param rhs Residual S(y)-y of current iteration.
+	*/
+	void broydenUpdate(unsigned int c, const std::vector<double> & rhs);
+
+	/*! Determines the sparsity pattern of the Jacobian (m_columnRows and m_derivativeSlaves) and groups
+		structurally independent columns (m_columnGroups).
+		\param c Cycle index.
 	*/
-	void generateJacobian(unsigned int c);
+	void setupJacobianPattern(unsigned int c);
 
+	/*! Computes the symmetric CSR pattern of the Jacobian of cycle c, including diagonal and fill-in
+		generated by the LU factorization.
+		\param c Cycle index.
+		\param ia Row index vector (size n+1).
+		\param ja Column index vector (size nnz).
+	*/
+	void computeFilledPattern(unsigned int c, std::vector<unsigned int> & ia, std::vector<unsigned int> & ja) const;
+
+
+	/*! Group of Jacobian columns that are perturbed together in one slave evaluation. */
+	struct ColumnGroup {
+		/*! Matrix indexes of columns in this group. */
+		std::vector<unsigned int>	m_columns;
+		/*! Slaves with inputs connected to any of the columns in this group (in evaluation order of the cycle). */
+		std::vector<AbstractSlave*>	m_slaves;
+	};
 
-	/*! Jacobian matrixes for each cycle, can be empty in case of only one slave per cycle. */
+	/*! Jacobian matrixes for each cycle, can be empty in case of only one slave per cycle or when
+		a sparse matrix is used for the cycle.
+	*/
 	std::vector<IBKMK::DenseMatrix>				m_jacobianMatrix;
 
+	/*! Sparse Jacobian matrixes for each cycle, only used (n() != 0) if the Jacobian is sparse enough.
+		The matrix pattern is symmetric and includes the fill-in of the factorization, so that ilu()
+		computes the complete LU factorization.
+	*/
+	std::vector<IBKMK::SparseMatrixCSR>			m_sparseJacobianMatrix;
+
+	/*! Column groups for each cycle, all columns of a group are perturbed together. */
+	std::vector< std::vector<ColumnGroup> >		m_columnGroups;
+
+	/*! Matrix indexes of structurally non-zero rows of dS/dy that are computed with DQ approximation, for each
+		cycle and column. These are the coupled outputs of slaves with inputs connected to the column variable.
+	*/
+	std::vector< std::vector< std::vector<unsigned int> > >	m_columnRows;
+
+	/*! Data of a slave whose Jacobian block is computed with directional derivatives. */
+	struct DerivativeSlave {
+		AbstractSlave				*m_slave;
+		/*! Indexes of coupled real outputs in the slave's output vector. */
+		std::vector<unsigned int>	m_outputIndexes;
+		/*! Matrix rows corresponding to m_outputIndexes. */
+		std::vector<unsigned int>	m_rows;
+		/*! Value references of real inputs connected to coupled variables. */
+		std::vector<unsigned int>	m_inputValueRefs;
+		/*! Matrix columns of the variables connected to the inputs in m_inputValueRefs. */
+		std::vector<unsigned int>	m_inputColumns;
+		/*! Scale factors of the connections to the inputs in m_inputValueRefs. */
+		std::vector<double>			m_inputScaleFactors;
+		/*! Distinct matrix columns affecting this slave (sorted). */
+		std::vector<unsigned int>	m_columns;
+		/*! Seed vector (size of m_inputValueRefs). */
+		std::vector<double>			m_seed;
+		/*! Computed derivatives (size of m_rows). */
+		std::vector<double>			m_derivatives;
+	};
+
+	/*! Slaves using directional derivatives for each cycle (only with Project::m_useDirectionalDerivatives). */
+	std::vector< std::vector<DerivativeSlave> >	m_derivativeSlaves;
+
+	/*! Set to 1 for slaves (index matches m_slaveIndex) where computing directional derivatives has failed. */
+	std::vector<int>							m_directionalDerivativesFailed;
+
+	/*! Additional instance of a slave used for concurrent DQ approximation. */
+	struct SlaveCopy {
+		/*! The slave instance (owned). */
+		FMUSlave		*m_slave = nullptr;
+		/*! State of the copy, synchronized with the iteration state of the original slave. */
+		fmi2FMUstate	m_state = nullptr;
+		/*! Evaluation time in seconds, accumulated since last transfer to master statistics. */
+		double			m_evalTime = 0;
+		/*! Number of evaluations since last transfer to master statistics. */
+		unsigned int	m_evalCount = 0;
+		/*! Buffer for input values passed to the copy. */
+		std::vector<double>	m_inputValues;
+	};
+
+	/*! Copies of each slave (index matches m_slaveIndex), empty for slaves without copies. */
+	std::vector< std::vector<SlaveCopy> >		m_slaveCopies;
+
+	/*! Serialized iteration states of slaves with copies (index matches m_slaveIndex). */
+	std::vector< std::vector<char> >			m_serializedStates;
+
+	/*! Input variable perturbations for each cycle and slave copy (full vector size with all real variables),
+		each copy only modifies the entries of the columns it is currently processing.
+	*/
+	std::vector< std::vector< std::vector<double> > >	m_copyPerturbations;
+
+	/*! Thread pool for concurrent evaluation of slave copies (one thread per copy, at most Project::m_threadCount threads). */
+	ThreadPool									m_jacobianThreadPool;
+	/*! Guards m_jacobianThreadPool, when several cycles generate their Jacobian at the same time, only
+		one cycle uses the thread pool and the others evaluate their copies sequentially.
+	*/
+	std::mutex									m_jacobianThreadPoolMutex;
+
+	/*! Perturbations used in DQ approximation for each cycle and column. */
+	std::vector< std::vector<double> >			m_deltas;
+	/*! Values of perturbed variables, used to restore m_realytNextIter exactly after DQ approximation
+		with original slaves.
+	*/
+	std::vector< std::vector<double> >			m_unperturbedValues;
+
+	/*! Data needed to reuse the Jacobian of a cycle across steps (only used with Project::m_reuseJacobian). */
+	struct JacobianReuseData {
+		/*! Step size for which the Jacobian has been generated. */
+		double								m_h = 0;
+		/*! If false, the Jacobian must be generated anew. */
+		bool								m_valid = false;
+		/*! Broyden update vectors, the inverse Jacobian is H = (LU)^-1 + sum_k u_k v_k^T. */
+		std::vector< std::vector<double> >	m_u;
+		/*! Broyden update vectors, see m_u. */
+		std::vector< std::vector<double> >	m_v;
+		/*! Residual of last iteration. */
+		std::vector<double>					m_lastRhs;
+		/*! Newton step of last iteration. */
+		std::vector<double>					m_lastDelta;
+		/*! Work vector for dot products with update vectors. */
+		std::vector<double>					m_dots;
+	};
+
+	/*! Jacobian reuse data for each cycle. */
+	std::vector<JacobianReuseData>				m_jacobianReuseData;
+
 	/*! Maps the index of a variable in the matrix to the index of the corresponding variable in
 		the global index array. First index is the cycle, second index the matrix index.
 		\code
@@ -49,10 +254,20 @@ public:
 	*/
 	std::vector< std::vector<unsigned int> >	m_variableIdxMapping;
 
-	/*! Residuals of Newton equation (full vector size with all real variables). */
+	/*! Residuals of Newton equation (full vector size with all real variables).
+		Each cycle only writes to the values of its own output variables.
+	*/
 	std::vector<double>							m_res;
-	/*! Right-hand-side of Newton equation system (size matches dimension of Jacobian matrix/only coupled variables). */
-	std::vector<double>							m_rhs;
+	/*! Right-hand-side of Newton equation system for each cycle (size matches dimension of Jacobian matrix/only
+		coupled variables).
+	*/
+	std::vector< std::vector<double> >			m_rhs;
+
+protected:
+	/*! Evaluates all slaves of cycle c and iterates until converged.
+		Thread-safe for cycles that do not exchange variables with each other.
+	*/
+	Result doCycle(unsigned int c) override;
 };
 
 } // namespace MASTER_SIM
@@ -27,6 +27,10 @@ ArgParser::ArgParser() : m_verbosityLevel(1) {
 	addOption('v', "version", "Show version info.", "<true|false>", "false");
 	addOption('x', "close-on-exit", "Close console window after finishing simulation.", "<true|false>", "false");
 	addOption('t', "test-init", "Run the initialization and stop right afterwards.", "<true|false>", "false");
+	addOption(0, "restart", "Resume simulation from the last checkpoint written in the working directory.", "<true|false>", "false");
+	addOption(0, "convert-results", "Convert binary result file 'values.bin' or compressed result file 'values.csv.gz' into 'values.csv' (in the same directory) and exit.", "result-file", "");
+	addOption(0, "test-rewind", "Simulate until the end time, rewind to the latest in-memory snapshot at or before the given time and simulate until the end time again (test of snapshots, results must not change).", "time in s", "");
+	addOption(0, "test-stop", "Stop the simulation after the first step reaching the given time, without writing final outputs (test of restarts, resume with --restart).", "time in s", "");
 	addOption(0, "skip-unzip", "Do not unzip FMUs and expect them to be unzipped in extraction directories.", "<true|false>", "false");
 	addOption(0, "verbosity-level", "Level of output detail (0-3).", "0..3", "1");
 	addOption(0, "working-dir", "Working directory for master, where FMUs are extracted to and simulation results/log files are written.", "working-directory", "Project file path without extension.");
@@ -0,0 +1,317 @@
+#include "MSIM_BinaryResults.h"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+#include <IBK_FileUtils.h>
+
+#include "MSIM_RowFormatter.h"
+
+namespace MASTER_SIM {
+
+/*! Identifier at begin of binary result files. */
+static const char BINARY_RESULT_MAGIC[8] = { 'M', 'S', 'I', 'M', 'B', 'R', 'E', 'S' };
+/*! Current version of binary result file format. */
+static const uint32_t BINARY_RESULT_VERSION = 1;
+/*! Size of write buffer in bytes. */
+static const size_t WRITE_BUFFER_SIZE = 4*1024*1024;
+
+
+/*! Appends a value as raw bytes to a byte array. */
+template <typename T>
+static void appendBytes(std::vector<char> & data, const T & val) {
+	const char * p = reinterpret_cast<const char *>(&val);
+	data.insert(data.end(), p, p + sizeof(T));
+}
+
+
+/*! Appends a string with leading length to a byte array. */
+static void appendString(std::vector<char> & data, const std::string & str) {
+	appendBytes(data, (uint32_t)str.size());
+	data.insert(data.end(), str.begin(), str.end());
+}
+
+
+// *** BinaryResultWriter ***
+
+BinaryResultWriter::BinaryResultWriter() :
+	m_file(nullptr),
+	m_columnCount(0),
+	m_fileSize(0)
+{
+}
+
+
+BinaryResultWriter::~BinaryResultWriter() {
+	if (m_file != nullptr)
+		std::fclose(m_file);
+}
+
+
+void BinaryResultWriter::create(const IBK::Path & fname, const std::vector<BinaryResultColumn> & columns) {
+	// compose header
+	std::vector<char> header(BINARY_RESULT_MAGIC, BINARY_RESULT_MAGIC + 8);
+	appendBytes(header, BINARY_RESULT_VERSION);
+	appendBytes(header, (uint32_t)columns.size());
+	size_t offsetPos = header.size();
+	appendBytes(header, (uint64_t)0); // updated below
+	for (const BinaryResultColumn & col : columns) {
+		appendBytes(header, (uint32_t)col.m_type);
+		appendString(header, col.m_name);
+		appendString(header, col.m_unit);
+	}
+	// pad to multiple of 8 bytes, so that values are aligned in the mapped file
+	header.resize((header.size() + 7) & ~(size_t)7, 0);
+	uint64_t dataOffset = header.size();
+	std::memcpy(&header[offsetPos], &dataOffset, sizeof(uint64_t));
+
+	openFile(fname, "wb");
+	m_columnCount = (unsigned int)columns.size();
+	if (std::fwrite(header.data(), 1, header.size(), m_file) != header.size())
+		writeError();
+	m_fileSize = (int64_t)header.size();
+}
+
+
+void BinaryResultWriter::reopen(const IBK::Path & fname, const std::vector<BinaryResultColumn> & columns) {
+	const char * const FUNC_ID = "[BinaryResultWriter::reopen]";
+	std::vector<BinaryResultColumn> existingColumns;
+	BinaryResultReader::readHeader(fname, existingColumns);
+	bool match = (existingColumns.size() == columns.size());
+	for (unsigned int i=0; match && i<columns.size(); ++i)
+		match = (existingColumns[i].m_type == columns[i].m_type && existingColumns[i].m_name == columns[i].m_name &&
+				 existingColumns[i].m_unit == columns[i].m_unit);
+	if (!match)
+		throw IBK::Exception(IBK::FormatString("Columns in result file '%1' do not match the outputs of the simulation.").arg(fname), FUNC_ID);
+
+	m_fileSize = fname.fileSize();
+	openFile(fname, "ab");
+	m_columnCount = (unsigned int)columns.size();
+}
+
+
+void BinaryResultWriter::flush() {
+	if (m_file != nullptr && std::fflush(m_file) != 0)
+		writeError();
+}
+
+
+void BinaryResultWriter::close() {
+	if (m_file != nullptr) {
+		int res = std::fclose(m_file);
+		m_file = nullptr;
+		if (res != 0)
+			writeError();
+	}
+}
+
+
+void BinaryResultWriter::openFile(const IBK::Path & fname, const char * mode) {
+	const char * const FUNC_ID = "[BinaryResultWriter::openFile]";
+	close();
+	m_fname = fname;
+#if defined(_WIN32)
+	std::wstring wmode(mode, mode + std::strlen(mode));
+	m_file = _wfopen(fname.wstrOS().c_str(), wmode.c_str());
+#else
+	m_file = std::fopen(fname.str().c_str(), mode);
+#endif
+	if (m_file == nullptr)
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1' for writing.").arg(fname), FUNC_ID);
+	m_buffer.resize(WRITE_BUFFER_SIZE);
+	std::setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+}
+
+
+void BinaryResultWriter::writeError() const {
+	throw IBK::Exception(IBK::FormatString("Error writing result file '%1'.").arg(m_fname), "[BinaryResultWriter::appendRow]");
+}
+
+
+
+// *** BinaryResultReader ***
+
+BinaryResultReader::BinaryResultReader() :
+	m_rowCount(0),
+	m_mappedData(nullptr),
+	m_mappedSize(0),
+	m_data(nullptr)
+#if defined(_WIN32)
+	,
+	m_fileHandle(INVALID_HANDLE_VALUE),
+	m_mappingHandle(nullptr)
+#endif
+{
+}
+
+
+BinaryResultReader::~BinaryResultReader() {
+	close();
+}
+
+
+uint64_t BinaryResultReader::readHeader(const IBK::Path & fname, std::vector<BinaryResultColumn> & columns) {
+	const char * const FUNC_ID = "[BinaryResultReader::readHeader]";
+	std::ifstream in;
+	if (!IBK::open_ifstream(in, fname, std::ios_base::in | std::ios_base::binary))
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(fname), FUNC_ID);
+
+	char magic[8];
+	uint32_t version, columnCount;
+	uint64_t dataOffset;
+	if (!in.read(magic, 8) || std::memcmp(magic, BINARY_RESULT_MAGIC, 8) != 0 ||
+		!in.read(reinterpret_cast<char*>(&version), sizeof(uint32_t)) ||
+		!in.read(reinterpret_cast<char*>(&columnCount), sizeof(uint32_t)) ||
+		!in.read(reinterpret_cast<char*>(&dataOffset), sizeof(uint64_t)))
+	{
+		throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+	}
+	if (version != BINARY_RESULT_VERSION)
+		throw IBK::Exception(IBK::FormatString("Unsupported version %1 of result file '%2'.").arg(version).arg(fname), FUNC_ID);
+
+	columns.resize(columnCount);
+	for (BinaryResultColumn & col : columns) {
+		uint32_t type, len;
+		if (!in.read(reinterpret_cast<char*>(&type), sizeof(uint32_t)) || type >= BinaryResultColumn::NUM_CT)
+			throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+		col.m_type = (BinaryResultColumn::ColumnType)type;
+		std::string * strings[2] = { &col.m_name, &col.m_unit };
+		for (std::string * str : strings) {
+			if (!in.read(reinterpret_cast<char*>(&len), sizeof(uint32_t)) || len > dataOffset)
+				throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+			str->resize(len);
+			if (len != 0 && !in.read(&(*str)[0], len))
+				throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+		}
+	}
+	if ((uint64_t)in.tellg() > dataOffset || dataOffset % 8 != 0)
+		throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+	return dataOffset;
+}
+
+
+void BinaryResultReader::open(const IBK::Path & fname) {
+	const char * const FUNC_ID = "[BinaryResultReader::open]";
+	close();
+	uint64_t dataOffset = readHeader(fname, m_columns);
+	if (m_columns.empty())
+		throw IBK::Exception(IBK::FormatString("Result file '%1' does not contain any columns.").arg(fname), FUNC_ID);
+
+	// map file into memory
+	int64_t fileSize = fname.fileSize();
+	if (fileSize < (int64_t)dataOffset)
+		throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+	m_mappedSize = (size_t)fileSize;
+#if defined(_WIN32)
+	HANDLE file = CreateFileW(fname.wstrOS().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+							  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(fname), FUNC_ID);
+	m_fileHandle = file;
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		close();
+		throw IBK::Exception(IBK::FormatString("Cannot map result file '%1' into memory.").arg(fname), FUNC_ID);
+	}
+	m_mappingHandle = mapping;
+	m_mappedData = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, m_mappedSize));
+	if (m_mappedData == nullptr) {
+		close();
+		throw IBK::Exception(IBK::FormatString("Cannot map result file '%1' into memory.").arg(fname), FUNC_ID);
+	}
+#else
+	int fd = ::open(fname.str().c_str(), O_RDONLY);
+	if (fd == -1)
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(fname), FUNC_ID);
+	void * p = mmap(nullptr, m_mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd); // mapping remains valid
+	if (p == MAP_FAILED) {
+		m_mappedSize = 0;
+		throw IBK::Exception(IBK::FormatString("Cannot map result file '%1' into memory.").arg(fname), FUNC_ID);
+	}
+	m_mappedData = static_cast<const char *>(p);
+#endif
+	m_data = reinterpret_cast<const double *>(m_mappedData + dataOffset);
+	m_rowCount = (size_t)((m_mappedSize - dataOffset)/(m_columns.size()*sizeof(double)));
+}
+
+
+void BinaryResultReader::close() {
+#if defined(_WIN32)
+	if (m_mappedData != nullptr)
+		UnmapViewOfFile(m_mappedData);
+	if (m_mappingHandle != nullptr)
+		CloseHandle(m_mappingHandle);
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(m_fileHandle);
+	m_mappingHandle = nullptr;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (m_mappedData != nullptr)
+		munmap(const_cast<char *>(m_mappedData), m_mappedSize);
+#endif
+	m_mappedData = nullptr;
+	m_mappedSize = 0;
+	m_data = nullptr;
+	m_rowCount = 0;
+	m_columns.clear();
+}
+
+
+void BinaryResultReader::column(unsigned int c, std::vector<double> & values) const {
+	values.resize(m_rowCount);
+	for (size_t i=0; i<m_rowCount; ++i)
+		values[i] = value(i, c);
+}
+
+
+void BinaryResultReader::writeCSV(const IBK::Path & csvFile) const {
+	const char * const FUNC_ID = "[BinaryResultReader::writeCSV]";
+	std::ofstream out;
+	if (!IBK::open_ofstream(out, csvFile))
+		throw IBK::Exception(IBK::FormatString("Cannot create file '%1'.").arg(csvFile), FUNC_ID);
+
+	// header, same format as written by OutputWriter
+	for (unsigned int c=0; c<m_columns.size(); ++c) {
+		if (c > 0)
+			out << " \t";
+		out << m_columns[c].m_name << " [" << m_columns[c].m_unit << "]";
+	}
+	out << '\n';
+
+	// values, booleans and integers are written as integer numbers
+	RowFormatter line;
+	for (size_t i=0; i<m_rowCount; ++i) {
+		const double * values = row(i);
+		line.clear();
+		for (unsigned int c=0; c<m_columns.size(); ++c) {
+			if (c > 0)
+				line.appendChar('\t');
+			switch (m_columns[c].m_type) {
+				case BinaryResultColumn::CT_BOOL :
+				case BinaryResultColumn::CT_INT :
+					line.appendInt((int)values[c]);
+				break;
+				default :
+					line.appendDouble(values[c], 14);
+			}
+		}
+		line.appendChar('\n');
+		line.writeTo(out);
+	}
+	if (!out)
+		throw IBK::Exception(IBK::FormatString("Error writing file '%1'.").arg(csvFile), FUNC_ID);
+}
+
+} // namespace MASTER_SIM
@@ -0,0 +1,190 @@
+#ifndef MSIM_BINARYRESULTS_H
+#define MSIM_BINARYRESULTS_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+#include <IBK_Path.h>
+
+namespace MASTER_SIM {
+
+/*! Describes a column of a binary result file. */
+struct BinaryResultColumn {
+	/*! Data type of column, determines formatting when converting to csv. */
+	enum ColumnType {
+		CT_TIME,
+		CT_BOOL,
+		CT_INT,
+		CT_REAL,
+		NUM_CT
+	};
+
+	/*! Default constructor. */
+	BinaryResultColumn() : m_type(CT_REAL) {}
+	/*! Initializing constructor. */
+	BinaryResultColumn(ColumnType type, const std::string & name, const std::string & unit) :
+		m_type(type), m_name(name), m_unit(unit)
+	{}
+
+	/*! Data type. */
+	ColumnType		m_type;
+	/*! Column name (flat variable name 'slave.variable', or 'Time' for the time column). */
+	std::string		m_name;
+	/*! Unit of values in column. */
+	std::string		m_unit;
+};
+
+
+/*! Writes result file 'values.bin', a binary columnar alternative to 'values.csv'.
+
+	The file starts with a header describing all columns, followed by the output rows. Each row holds
+	one double value per column (including the time column), so that rows have a fixed size and row i
+	is located at dataOffset + i*columnCount*8. Booleans and integers are stored as doubles as well (exact).
+
+	File format (all numbers in native byte order):
+	\code
+	char[8]   magic header 'MSIMBRES'
+	uint32    format version
+	uint32    number of columns (including time column)
+	uint64    offset of first row in bytes (multiple of 8)
+	per column:
+	  uint32  column type (see BinaryResultColumn::ColumnType)
+	  uint32  length of name, followed by name (utf8, not null-terminated)
+	  uint32  length of unit, followed by unit
+	...       zero padding up to offset of first row
+	double[number of columns] for each row
+	\endcode
+
+	Rows are written through a large stdio buffer, the file is only flushed when the buffer is full,
+	or when flush() is called (e.g. when creating checkpoints).
+*/
+class BinaryResultWriter {
+public:
+	/*! Constructor. */
+	BinaryResultWriter();
+	/*! Destructor, closes file. */
+	~BinaryResultWriter();
+
+	/*! Creates a new result file and writes the header.
+		\param fname Result file path.
+		\param columns Column definitions, first column is the time column.
+	*/
+	void create(const IBK::Path & fname, const std::vector<BinaryResultColumn> & columns);
+
+	/*! Re-opens an existing result file for appending rows (when restarting a simulation).
+		Throws an exception if the columns in the file do not match the given column definitions.
+	*/
+	void reopen(const IBK::Path & fname, const std::vector<BinaryResultColumn> & columns);
+
+	/*! Appends a row, values must hold one value per column. */
+	void appendRow(const double * values) {
+		if (std::fwrite(values, sizeof(double), m_columnCount, m_file) != m_columnCount)
+			writeError();
+		m_fileSize += m_columnCount*sizeof(double);
+	}
+
+	/*! Flushes buffered rows to file. */
+	void flush();
+
+	/*! Closes the file. */
+	void close();
+
+	/*! Size of file including buffered data in bytes. */
+	int64_t fileSize() const { return m_fileSize; }
+
+	/*! Number of columns (values per row). */
+	unsigned int columnCount() const { return m_columnCount; }
+
+private:
+	/*! Opens the file with the given mode and sets up the write buffer. */
+	void openFile(const IBK::Path & fname, const char * mode);
+	/*! Throws an exception about a failed write operation. */
+	void writeError() const;
+
+	/*! File handle. */
+	std::FILE			*m_file;
+	/*! File path. */
+	IBK::Path			m_fname;
+	/*! Number of columns (values per row). */
+	unsigned int		m_columnCount;
+	/*! Size of file including buffered data in bytes. */
+	int64_t				m_fileSize;
+	/*! Write buffer passed to setvbuf(). */
+	std::vector<char>	m_buffer;
+};
+
+
+/*! Reads result files written by BinaryResultWriter.
+
+	The file is memory-mapped, so that opening even large files is fast and values are only read from disk
+	when accessed. A partially written last row (e.g. when the simulation was aborted) is ignored.
+
+	\code
+	BinaryResultReader reader;
+	reader.open(IBK::Path("results/values.bin"));
+	for (size_t i=0; i<reader.rowCount(); ++i)
+		std::cout << reader.value(i, 0) << std::endl; // time points
+	\endcode
+*/
+class BinaryResultReader {
+public:
+	/*! Constructor. */
+	BinaryResultReader();
+	/*! Destructor, unmaps the file. */
+	~BinaryResultReader();
+
+	/*! Opens a result file, reads the header and maps the file into memory. */
+	void open(const IBK::Path & fname);
+
+	/*! Unmaps the file. */
+	void close();
+
+	/*! Column definitions, first column is the time column. */
+	const std::vector<BinaryResultColumn> & columns() const { return m_columns; }
+
+	/*! Number of complete rows in file. */
+	size_t rowCount() const { return m_rowCount; }
+
+	/*! Returns pointer to the values of row i (one value per column). */
+	const double * row(size_t i) const { return m_data + i*m_columns.size(); }
+
+	/*! Returns value in row i and column c. */
+	double value(size_t i, unsigned int c) const { return m_data[i*m_columns.size() + c]; }
+
+	/*! Extracts all values of column c. */
+	void column(unsigned int c, std::vector<double> & values) const;
+
+	/*! Writes content in the format of 'values.csv' as written by MasterSim (tab-separated, precision 14).
+		The created file is identical to the 'values.csv' file written by MasterSim for the same simulation.
+	*/
+	void writeCSV(const IBK::Path & csvFile) const;
+
+	/*! Reads only the column definitions from the header of a result file.
+		\return Returns offset of first row in bytes.
+	*/
+	static uint64_t readHeader(const IBK::Path & fname, std::vector<BinaryResultColumn> & columns);
+
+private:
+	/*! Column definitions. */
+	std::vector<BinaryResultColumn>	m_columns;
+	/*! Number of complete rows. */
+	size_t							m_rowCount;
+	/*! Start of mapped file. */
+	const char						*m_mappedData;
+	/*! Size of mapped file in bytes. */
+	size_t							m_mappedSize;
+	/*! Pointer to first value of first row. */
+	const double					*m_data;
+#if defined(_WIN32)
+	/*! File handle. */
+	void							*m_fileHandle;
+	/*! File mapping handle. */
+	void							*m_mappingHandle;
+#endif
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_BINARYRESULTS_H
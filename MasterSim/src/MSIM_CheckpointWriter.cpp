@@ -0,0 +1,538 @@
+#include "MSIM_CheckpointWriter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <unordered_set>
+
+#if defined(_WIN32)
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <fcntl.h>
+#endif
+
+#include <zlib.h>
+
+#include <IBK_Exception.h>
+#include <IBK_FormatString.h>
+#include <IBK_FileUtils.h>
+#include <IBK_StringUtils.h>
+
+namespace MASTER_SIM {
+
+/*! Identifier at begin of checkpoint files. */
+static const char CHECKPOINT_MAGIC[8] = { 'M', 'S', 'I', 'M', 'C', 'H', 'K', 'P' };
+
+/*! Size of chunks passed to zlib in one call. */
+static const size_t ZLIB_CHUNK_SIZE = 1024*1024;
+
+/*! Pack files smaller than this size (in bytes) are not compacted. */
+static const int64_t MIN_COMPACTION_SIZE = 4*1024*1024;
+
+/*! Size of a chunk entry in the chunk list of the checkpoint file in bytes. */
+static const size_t CHUNK_ENTRY_SIZE = 2*sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+
+CheckpointWriter::CheckpointWriter() :
+	m_pending(false),
+	m_shutdown(false),
+	m_version(0),
+	m_packNumber(0),
+	m_checkpointScanned(false)
+{
+}
+
+
+CheckpointWriter::~CheckpointWriter() {
+	if (!m_thread.joinable())
+		return;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_writeDone.wait(lock, [this]() { return !m_pending; });
+		m_shutdown = true;
+	}
+	m_dataAvailable.notify_one();
+	m_thread.join();
+}
+
+
+void CheckpointWriter::write(const IBK::Path & checkpointFile, unsigned int version, std::vector<char> & data,
+							 const std::function<void(std::vector<char> &)> & completeData)
+{
+	waitForCompletion();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_checkpointFile = checkpointFile;
+		m_version = version;
+		m_data.swap(data);
+		data.clear();
+		m_completeData = completeData;
+		m_pending = true;
+	}
+	if (!m_thread.joinable())
+		m_thread = std::thread(&CheckpointWriter::writerLoop, this);
+	m_dataAvailable.notify_one();
+}
+
+
+void CheckpointWriter::waitForCompletion() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_writeDone.wait(lock, [this]() { return !m_pending; });
+	if (m_exception != nullptr) {
+		std::exception_ptr ex = m_exception;
+		m_exception = nullptr;
+		lock.unlock();
+		std::rethrow_exception(ex);
+	}
+}
+
+
+void CheckpointWriter::read(const IBK::Path & checkpointFile, unsigned int version, std::vector<char> & data) {
+	const char * const FUNC_ID = "[CheckpointWriter::read]";
+
+	// read list of chunks
+	uint64_t size;
+	uint32_t packNumber;
+	std::vector<ChunkId> recipe;
+	std::vector<PackedChunk> packedChunks;
+	readRecipe(checkpointFile, version, size, packNumber, recipe, packedChunks);
+
+	// assemble data from chunks
+	IBK::Path pack = packFile(checkpointFile, packNumber);
+	std::ifstream in;
+	if (!pack.exists() || !IBK::open_ifstream(in, pack, std::ios_base::in | std::ios_base::binary))
+		throw IBK::Exception(IBK::FormatString("Cannot read checkpoint pack file '%1'.").arg(pack), FUNC_ID);
+	data.resize((size_t)size);
+	size_t pos = 0;
+	std::vector<char> compressed;
+	for (size_t i=0; i<recipe.size(); ++i) {
+		if (recipe[i].m_size > data.size() - pos)
+			throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' is corrupt or truncated.").arg(checkpointFile), FUNC_ID);
+		if (!readChunk(in, recipe[i], packedChunks[i], compressed, data.data() + pos))
+			throw IBK::Exception(IBK::FormatString("Checkpoint pack file '%1' is corrupt or truncated.").arg(pack), FUNC_ID);
+		pos += recipe[i].m_size;
+	}
+	if (pos != data.size())
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' is corrupt or truncated.").arg(checkpointFile), FUNC_ID);
+}
+
+
+void CheckpointWriter::readRecipe(const IBK::Path & checkpointFile, unsigned int version, uint64_t & size, uint32_t & packNumber,
+								  std::vector<ChunkId> & recipe, std::vector<PackedChunk> & packedChunks)
+{
+	const char * const FUNC_ID = "[CheckpointWriter::readRecipe]";
+
+	std::vector<char> recipeData;
+	readFile(checkpointFile, version, recipeData);
+	const size_t headerSize = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint64_t);
+	uint64_t count;
+	if (recipeData.size() < headerSize)
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' is corrupt or truncated.").arg(checkpointFile), FUNC_ID);
+	std::memcpy(&size, &recipeData[0], sizeof(uint64_t));
+	std::memcpy(&packNumber, &recipeData[sizeof(uint64_t)], sizeof(uint32_t));
+	std::memcpy(&count, &recipeData[sizeof(uint64_t) + sizeof(uint32_t)], sizeof(uint64_t));
+	if (recipeData.size() != headerSize + count*CHUNK_ENTRY_SIZE)
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' is corrupt or truncated.").arg(checkpointFile), FUNC_ID);
+
+	recipe.resize((size_t)count);
+	packedChunks.resize((size_t)count);
+	for (size_t i=0; i<recipe.size(); ++i) {
+		const char * p = &recipeData[headerSize + i*CHUNK_ENTRY_SIZE];
+		std::memcpy(&recipe[i].m_hash[0], p, 2*sizeof(uint64_t));
+		p += 2*sizeof(uint64_t);
+		std::memcpy(&recipe[i].m_size, p, sizeof(uint32_t));
+		p += sizeof(uint32_t);
+		std::memcpy(&packedChunks[i].m_offset, p, sizeof(uint64_t));
+		p += sizeof(uint64_t);
+		std::memcpy(&packedChunks[i].m_compressedSize, p, sizeof(uint32_t));
+	}
+}
+
+
+bool CheckpointWriter::readChunk(std::istream & pack, const ChunkId & id, const PackedChunk & packedChunk,
+								 std::vector<char> & compressed, char * data)
+{
+	compressed.resize(packedChunk.m_compressedSize);
+	pack.clear();
+	if (!pack.seekg((std::streamoff)packedChunk.m_offset) ||
+		(!compressed.empty() && !pack.read(&compressed[0], (std::streamsize)compressed.size())))
+	{
+		return false;
+	}
+	uLongf chunkSize = id.m_size;
+	return uncompress(reinterpret_cast<Bytef*>(data), &chunkSize,
+					  reinterpret_cast<const Bytef*>(compressed.data()), (uLong)compressed.size()) == Z_OK &&
+		   chunkSize == id.m_size && ChunkStore::chunkId(data, id.m_size) == id;
+}
+
+
+IBK::Path CheckpointWriter::packFile(const IBK::Path & checkpointFile, uint32_t packNumber) {
+	return checkpointFile.parentPath() / ("chunks_" + IBK::val2string(packNumber) + ".pack");
+}
+
+
+void CheckpointWriter::readFile(const IBK::Path & checkpointFile, unsigned int version, std::vector<char> & data) {
+	const char * const FUNC_ID = "[CheckpointWriter::readFile]";
+
+	if (!checkpointFile.exists())
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' does not exist.").arg(checkpointFile), FUNC_ID);
+	std::vector<char> compressed((size_t)checkpointFile.fileSize());
+	{
+		std::ifstream in;
+		if (!IBK::open_ifstream(in, checkpointFile, std::ios_base::in | std::ios_base::binary) ||
+			(!compressed.empty() && !in.read(&compressed[0], (std::streamsize)compressed.size())))
+		{
+			throw IBK::Exception(IBK::FormatString("Cannot read checkpoint file '%1'.").arg(checkpointFile), FUNC_ID);
+		}
+	}
+
+	// check header
+	const size_t headerSize = sizeof(CHECKPOINT_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t);
+	if (compressed.size() < headerSize || std::memcmp(&compressed[0], CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+		throw IBK::Exception(IBK::FormatString("Invalid format of checkpoint file '%1'.").arg(checkpointFile), FUNC_ID);
+	uint32_t fileVersion;
+	std::memcpy(&fileVersion, &compressed[sizeof(CHECKPOINT_MAGIC)], sizeof(uint32_t));
+	if (fileVersion != version)
+		throw IBK::Exception(IBK::FormatString("Unsupported version %1 of checkpoint file '%2'.").arg(fileVersion).arg(checkpointFile), FUNC_ID);
+	uint64_t size;
+	std::memcpy(&size, &compressed[sizeof(CHECKPOINT_MAGIC) + sizeof(uint32_t)], sizeof(uint64_t));
+
+	// decompress data
+	data.resize((size_t)size);
+	z_stream strm;
+	std::memset(&strm, 0, sizeof(strm));
+	if (inflateInit(&strm) != Z_OK)
+		throw IBK::Exception("Cannot initialize zlib.", FUNC_ID);
+	strm.next_in = reinterpret_cast<Bytef*>(&compressed[headerSize]);
+	size_t inRemaining = compressed.size() - headerSize;
+	size_t outPos = 0;
+	int res = Z_OK;
+	while (res == Z_OK) {
+		if (strm.avail_in == 0) {
+			strm.avail_in = (uInt)std::min(inRemaining, ZLIB_CHUNK_SIZE);
+			inRemaining -= strm.avail_in;
+		}
+		strm.next_out = reinterpret_cast<Bytef*>(data.data() + outPos);
+		strm.avail_out = (uInt)std::min(data.size() - outPos, ZLIB_CHUNK_SIZE);
+		uInt availOut = strm.avail_out;
+		res = inflate(&strm, Z_NO_FLUSH);
+		outPos += availOut - strm.avail_out;
+		if (res == Z_BUF_ERROR) {
+			// no progress possible: either input is exhausted or output is full -> data is truncated or corrupt
+			if ((strm.avail_in == 0 && inRemaining == 0) || outPos == data.size())
+				break;
+			res = Z_OK;
+		}
+	}
+	inflateEnd(&strm);
+	if (res != Z_STREAM_END || outPos != data.size())
+		throw IBK::Exception(IBK::FormatString("Checkpoint file '%1' is corrupt or truncated.").arg(checkpointFile), FUNC_ID);
+}
+
+
+void CheckpointWriter::writerLoop() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_dataAvailable.wait(lock, [this]() { return m_shutdown || m_pending; });
+		if (m_shutdown)
+			return;
+
+		// data and target file are not modified by the master while a checkpoint is pending
+		lock.unlock();
+		std::exception_ptr ex = nullptr;
+		try {
+			if (m_completeData)
+				m_completeData(m_data);
+			writeCheckpoint(m_checkpointFile, m_version, m_data);
+		}
+		catch (...) {
+			ex = std::current_exception();
+		}
+		lock.lock();
+
+		m_exception = ex;
+		m_data.clear();
+		m_completeData = nullptr;
+		m_pending = false;
+		m_writeDone.notify_all();
+	}
+}
+
+
+/*! Writes bytes to file, throws an exception on error. */
+static void writeBytes(std::FILE * f, const void * data, size_t size, const IBK::Path & fname) {
+	if (size != 0 && std::fwrite(data, 1, size, f) != size)
+		throw IBK::Exception(IBK::FormatString("Error writing file '%1'.").arg(fname), "[CheckpointWriter::writeFile]");
+}
+
+
+/*! Opens a file for binary writing, existing files are either truncated or appended to. */
+static std::FILE * openFile(const IBK::Path & fname, bool append = false) {
+#if defined(_WIN32)
+	return _wfopen(fname.wstrOS().c_str(), append ? L"ab" : L"wb");
+#else
+	return std::fopen(fname.str().c_str(), append ? "ab" : "wb");
+#endif
+}
+
+
+/*! Flushes file content to disk, returns false on error. */
+static bool syncFile(std::FILE * f) {
+	if (std::fflush(f) != 0)
+		return false;
+#if defined(_WIN32)
+	return _commit(_fileno(f)) == 0;
+#else
+	return fsync(fileno(f)) == 0;
+#endif
+}
+
+
+/*! Flushes directory entries to disk, so that renamed/created files survive a system crash (no-op on Windows). */
+static void syncDirectory(const IBK::Path & dir) {
+#if !defined(_WIN32)
+	int dirFd = open(dir.str().c_str(), O_RDONLY);
+	if (dirFd != -1) {
+		fsync(dirFd);
+		close(dirFd);
+	}
+#else
+	(void)dir;
+#endif
+}
+
+
+/*! Renames a file, replacing an existing target file.
+	Note: std::rename() is used, since IBK::Path::move() rejects targets within the current working directory
+*/
+static void replaceFile(const IBK::Path & source, const IBK::Path & target) {
+#if defined(_WIN32)
+	if (target.exists())
+		IBK::Path::remove(target);
+#endif
+	if (std::rename(source.str().c_str(), target.str().c_str()) != 0)
+		throw IBK::Exception(IBK::FormatString("Cannot rename file '%1' to '%2'.").arg(source).arg(target), "[CheckpointWriter::writeFile]");
+}
+
+
+void CheckpointWriter::writeCheckpoint(const IBK::Path & checkpointFile, unsigned int version, const std::vector<char> & data) {
+	const char * const FUNC_ID = "[CheckpointWriter::writeCheckpoint]";
+
+	if (!m_checkpointScanned) {
+		// re-use chunks of previous checkpoint (when restarting)
+		scanExistingCheckpoint(checkpointFile, version);
+		m_checkpointScanned = true;
+	}
+
+	std::vector<ChunkId> recipe;
+	ChunkStore::split(data.data(), data.size(), recipe);
+
+	// compact pack file when chunks not referenced by the new checkpoint dominate
+	IBK::Path pack = packFile(checkpointFile, m_packNumber);
+	int64_t packSize = pack.exists() ? pack.fileSize() : 0;
+	int64_t referencedSize = 0;
+	std::unordered_set<ChunkId, ChunkIdHash> reusedChunks;
+	for (const ChunkId & id : recipe) {
+		std::unordered_map<ChunkId, PackedChunk, ChunkIdHash>::const_iterator it = m_diskChunks.find(id);
+		if (it != m_diskChunks.end() && reusedChunks.insert(id).second)
+			referencedSize += it->second.m_compressedSize;
+	}
+	uint32_t previousPackNumber = m_packNumber;
+	bool compact = packSize >= MIN_COMPACTION_SIZE && packSize - referencedSize > referencedSize;
+	if (compact) {
+		// chunks of the new checkpoint are written to a new pack file, the current pack file remains valid
+		// until the new checkpoint file is in place
+		m_diskChunks.clear();
+		++m_packNumber;
+		pack = packFile(checkpointFile, m_packNumber);
+		packSize = 0;
+	}
+
+	// append all chunks that are not yet on disk to the pack file
+	std::FILE * f = nullptr;
+	bool newPack = !pack.exists();
+	try {
+		std::vector<Bytef> compressed;
+		size_t pos = 0;
+		for (const ChunkId & id : recipe) {
+			if (m_diskChunks.find(id) == m_diskChunks.end()) {
+				if (f == nullptr) {
+					f = openFile(pack, !compact);
+					if (f == nullptr)
+						throw IBK::Exception(IBK::FormatString("Cannot open file '%1'.").arg(pack), FUNC_ID);
+				}
+				// fastest compression level, chunks are compressed independently
+				uLongf compressedSize = compressBound((uLong)id.m_size);
+				compressed.resize(compressedSize);
+				if (compress2(&compressed[0], &compressedSize, reinterpret_cast<const Bytef*>(data.data() + pos),
+							  (uLong)id.m_size, Z_BEST_SPEED) != Z_OK)
+				{
+					throw IBK::Exception("Error compressing checkpoint data.", FUNC_ID);
+				}
+				writeBytes(f, &compressed[0], compressedSize, pack);
+				PackedChunk packedChunk;
+				packedChunk.m_offset = (uint64_t)packSize;
+				packedChunk.m_compressedSize = (uint32_t)compressedSize;
+				m_diskChunks[id] = packedChunk;
+				packSize += (int64_t)compressedSize;
+			}
+			pos += id.m_size;
+		}
+		// all new chunks must be on disk before the checkpoint file referencing them is renamed
+		if (f != nullptr && !syncFile(f))
+			throw IBK::Exception(IBK::FormatString("Error flushing file '%1' to disk.").arg(pack), FUNC_ID);
+	}
+	catch (...) {
+		if (f != nullptr)
+			std::fclose(f);
+		// offsets of chunks written so far are still valid, but a partially written chunk is not
+		m_diskChunks.clear();
+		throw;
+	}
+	if (f != nullptr) {
+		if (std::fclose(f) != 0) {
+			m_diskChunks.clear();
+			throw IBK::Exception(IBK::FormatString("Error writing file '%1'.").arg(pack), FUNC_ID);
+		}
+		if (newPack)
+			syncDirectory(checkpointFile.parentPath());
+	}
+
+	// checkpoint file holds the list of chunks
+	std::vector<char> recipeData;
+	uint64_t size = data.size();
+	uint64_t count = recipe.size();
+	recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&size), reinterpret_cast<const char*>(&size) + sizeof(uint64_t));
+	recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&m_packNumber), reinterpret_cast<const char*>(&m_packNumber) + sizeof(uint32_t));
+	recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&count), reinterpret_cast<const char*>(&count) + sizeof(uint64_t));
+	for (const ChunkId & id : recipe) {
+		const PackedChunk & packedChunk = m_diskChunks[id];
+		recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&id.m_hash[0]), reinterpret_cast<const char*>(&id.m_hash[0]) + 2*sizeof(uint64_t));
+		recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&id.m_size), reinterpret_cast<const char*>(&id.m_size) + sizeof(uint32_t));
+		recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&packedChunk.m_offset), reinterpret_cast<const char*>(&packedChunk.m_offset) + sizeof(uint64_t));
+		recipeData.insert(recipeData.end(), reinterpret_cast<const char*>(&packedChunk.m_compressedSize), reinterpret_cast<const char*>(&packedChunk.m_compressedSize) + sizeof(uint32_t));
+	}
+	writeFile(checkpointFile, version, recipeData);
+
+	// new checkpoint is complete, previous pack file is no longer needed after compaction
+	if (compact)
+		IBK::Path::remove(packFile(checkpointFile, previousPackNumber), true);
+}
+
+
+void CheckpointWriter::scanExistingCheckpoint(const IBK::Path & checkpointFile, unsigned int version) {
+	IBK::Path checkpointDir = checkpointFile.parentPath();
+	if (!checkpointDir.exists()) {
+		if (!IBK::Path::makePath(checkpointDir))
+			throw IBK::Exception(IBK::FormatString("Cannot create directory '%1'.").arg(checkpointDir), "[CheckpointWriter::scanExistingCheckpoint]");
+		return;
+	}
+
+	// read chunk list of existing checkpoint, if any
+	bool haveRecipe = false;
+	std::vector<ChunkId> recipe;
+	std::vector<PackedChunk> packedChunks;
+	if (checkpointFile.exists()) {
+		try {
+			uint64_t size;
+			readRecipe(checkpointFile, version, size, m_packNumber, recipe, packedChunks);
+			haveRecipe = true;
+		}
+		catch (IBK::Exception &) {
+			// checkpoint of a different version or corrupt checkpoint, start with a new pack file
+			m_packNumber = 0;
+		}
+	}
+
+	// remove pack files not referenced by the checkpoint (left over from an interrupted compaction)
+	std::vector<std::string> fileNames;
+	IBK::Path::files(checkpointDir, fileNames);
+	std::string currentPack = packFile(checkpointFile, m_packNumber).filename().str();
+	for (const std::string & fname : fileNames) {
+		if (fname.find("chunks_") == 0 && fname.size() > 5 && fname.rfind(".pack") == fname.size() - 5 &&
+			(!haveRecipe || fname != currentPack))
+		{
+			IBK::Path::remove(checkpointDir / fname, true);
+		}
+	}
+	if (!haveRecipe)
+		return;
+
+	// verify chunks, only chunks with correct content are re-used, all others are written again
+	IBK::Path pack = packFile(checkpointFile, m_packNumber);
+	std::ifstream in;
+	if (!pack.exists() || !IBK::open_ifstream(in, pack, std::ios_base::in | std::ios_base::binary))
+		return;
+	std::vector<char> compressed;
+	std::vector<char> chunkData;
+	for (size_t i=0; i<recipe.size(); ++i) {
+		if (m_diskChunks.find(recipe[i]) != m_diskChunks.end())
+			continue;
+		chunkData.resize(recipe[i].m_size);
+		if (readChunk(in, recipe[i], packedChunks[i], compressed, chunkData.data()))
+			m_diskChunks[recipe[i]] = packedChunks[i];
+	}
+}
+
+
+void CheckpointWriter::writeFile(const IBK::Path & checkpointFile, unsigned int version, const std::vector<char> & data) {
+	const char * const FUNC_ID = "[CheckpointWriter::writeFile]";
+
+	IBK::Path tmpFile(checkpointFile.str() + ".tmp");
+	std::FILE * f = openFile(tmpFile);
+	if (f == nullptr)
+		throw IBK::Exception(IBK::FormatString("Cannot create file '%1'.").arg(tmpFile), FUNC_ID);
+
+	z_stream strm;
+	std::memset(&strm, 0, sizeof(strm));
+	try {
+		// header
+		writeBytes(f, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), tmpFile);
+		uint32_t fileVersion = version;
+		writeBytes(f, &fileVersion, sizeof(fileVersion), tmpFile);
+		uint64_t size = data.size();
+		writeBytes(f, &size, sizeof(size), tmpFile);
+
+		// compressed data, fastest compression level since serialized states may be large
+		if (deflateInit(&strm, Z_BEST_SPEED) != Z_OK)
+			throw IBK::Exception("Cannot initialize zlib.", FUNC_ID);
+		std::vector<Bytef> outBuffer(ZLIB_CHUNK_SIZE);
+		size_t inPos = 0;
+		int flush = Z_NO_FLUSH;
+		do {
+			size_t chunk = std::min(data.size() - inPos, ZLIB_CHUNK_SIZE);
+			strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data() + inPos));
+			strm.avail_in = (uInt)chunk;
+			inPos += chunk;
+			flush = (inPos == data.size()) ? Z_FINISH : Z_NO_FLUSH;
+			do {
+				strm.next_out = &outBuffer[0];
+				strm.avail_out = (uInt)outBuffer.size();
+				if (deflate(&strm, flush) == Z_STREAM_ERROR)
+					throw IBK::Exception("Error compressing checkpoint data.", FUNC_ID);
+				writeBytes(f, &outBuffer[0], outBuffer.size() - strm.avail_out, tmpFile);
+			} while (strm.avail_out == 0);
+		} while (flush != Z_FINISH);
+		deflateEnd(&strm);
+
+		// make sure the data is on disk before the file is renamed
+		if (!syncFile(f))
+			throw IBK::Exception(IBK::FormatString("Error flushing file '%1' to disk.").arg(tmpFile), FUNC_ID);
+	}
+	catch (...) {
+		deflateEnd(&strm);
+		std::fclose(f);
+		IBK::Path::remove(tmpFile, true);
+		throw;
+	}
+	if (std::fclose(f) != 0)
+		throw IBK::Exception(IBK::FormatString("Error writing file '%1'.").arg(tmpFile), FUNC_ID);
+
+	// replace previous checkpoint, also flush directory entry so that the renamed file survives a system crash
+	replaceFile(tmpFile, checkpointFile);
+	syncDirectory(checkpointFile.parentPath());
+}
+
+} // namespace MASTER_SIM
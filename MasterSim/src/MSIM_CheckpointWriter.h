@@ -0,0 +1,167 @@
+#ifndef MSIM_CHECKPOINTWRITER_H
+#define MSIM_CHECKPOINTWRITER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <unordered_map>
+#include <functional>
+#include <istream>
+
+#include <IBK_Path.h>
+
+#include "MSIM_ChunkStore.h"
+
+namespace MASTER_SIM {
+
+/*! Writes checkpoint files in a background thread.
+
+	The master captures the checkpoint data (serialized slave states and master state) in memory and
+	hands the buffer over to the writer via write(). The background thread splits the data into
+	content-defined chunks (see ChunkStore) and appends each chunk that is not yet on disk zlib-compressed
+	to the pack file 'chunks_<n>.pack' next to the checkpoint file. Since FMU states typically change
+	only partially between checkpoints, most chunks are re-used from previous checkpoints. The pack file is
+	flushed to disk once per checkpoint.
+	The checkpoint file itself only contains the list of chunks with their positions in the pack file. It is
+	written to a temporary file, flushed to disk and finally renamed to the checkpoint file name. Thus, the
+	checkpoint file is always either the complete previous or the complete new checkpoint. Since data is only
+	appended to the pack file, chunks of the previous checkpoint remain valid until the new checkpoint file is
+	in place.
+
+	When chunks no longer referenced by the current checkpoint make up more than half of the pack file,
+	the pack file is compacted: the chunks of the new checkpoint are written to a new pack file with the
+	next number, which is referenced by the new checkpoint file. The old pack file is removed afterwards.
+
+	When a simulation is restarted, the chunks of the existing checkpoint are read back and verified
+	before they are re-used, chunks that are corrupt are written again.
+
+	Only one checkpoint is processed at a time: write() blocks until the previous checkpoint
+	has been written completely.
+
+	File format:
+	\code
+	char[8]   magic header 'MSIMCHKP'
+	uint32    format version
+	uint64    size of uncompressed data
+	...       zlib stream with chunk list:
+	          uint64    size of checkpoint data
+	          uint32    number of pack file
+	          uint64    number of chunks
+	          per chunk: uint64[2] hash, uint32 size, uint64 position in pack file, uint32 compressed size
+	\endcode
+*/
+class CheckpointWriter {
+public:
+	/*! Constructor, the background thread is created in the first call to write(). */
+	CheckpointWriter();
+	/*! Destructor, waits for a pending checkpoint to be written and stops the background thread. */
+	~CheckpointWriter();
+
+	/*! Hands over checkpoint data to the background thread.
+		If the previous checkpoint is still being written, the function waits until it has been completed.
+		\param checkpointFile Target file path.
+		\param version Version number of checkpoint data format, written to file header.
+		\param data Checkpoint data, content is moved into writer (vector is empty afterwards).
+		\param completeData Optional function called by the background thread before writing, may append data
+			that is not available yet when the checkpoint is handed over (e.g. output file sizes).
+		Throws an exception if writing of the previous checkpoint has failed.
+	*/
+	void write(const IBK::Path & checkpointFile, unsigned int version, std::vector<char> & data,
+			   const std::function<void(std::vector<char> &)> & completeData = nullptr);
+
+	/*! Waits until a pending checkpoint has been written.
+		Throws an exception if writing of the checkpoint has failed.
+	*/
+	void waitForCompletion();
+
+	/*! Reads a checkpoint file written by write() and returns the re-assembled checkpoint data.
+		\param checkpointFile Checkpoint file path.
+		\param version Expected version number of checkpoint data format.
+		\param data Uncompressed checkpoint data.
+	*/
+	static void read(const IBK::Path & checkpointFile, unsigned int version, std::vector<char> & data);
+
+private:
+	/*! Position of a compressed chunk in the pack file. */
+	struct PackedChunk {
+		/*! Position in pack file in bytes. */
+		uint64_t	m_offset;
+		/*! Size of compressed chunk in bytes. */
+		uint32_t	m_compressedSize;
+	};
+
+	/*! Main loop of background thread. */
+	void writerLoop();
+
+	/*! Writes new chunks and checkpoint file, compacts the pack file if needed (called from background thread). */
+	void writeCheckpoint(const IBK::Path & checkpointFile, unsigned int version, const std::vector<char> & data);
+
+	/*! Reads the chunks of an existing checkpoint file and keeps all valid chunks for re-use,
+		removes pack files not referenced by the checkpoint (called before the first checkpoint is written).
+	*/
+	void scanExistingCheckpoint(const IBK::Path & checkpointFile, unsigned int version);
+
+	/*! Returns path of the pack file with the given number. */
+	static IBK::Path packFile(const IBK::Path & checkpointFile, uint32_t packNumber);
+
+	/*! Reads the chunk list from a checkpoint file.
+		\param checkpointFile Checkpoint file path.
+		\param version Expected version number of checkpoint data format.
+		\param size Returns size of checkpoint data.
+		\param packNumber Returns number of pack file holding the chunks.
+		\param recipe Returns ids of all chunks (in order of data).
+		\param packedChunks Returns positions of all chunks in pack file.
+	*/
+	static void readRecipe(const IBK::Path & checkpointFile, unsigned int version, uint64_t & size, uint32_t & packNumber,
+						   std::vector<ChunkId> & recipe, std::vector<PackedChunk> & packedChunks);
+
+	/*! Reads a chunk from the pack file, decompresses it into data (id.m_size bytes) and checks its hash.
+		\return Returns false if the chunk cannot be read or does not match its id.
+	*/
+	static bool readChunk(std::istream & pack, const ChunkId & id, const PackedChunk & packedChunk,
+						  std::vector<char> & compressed, char * data);
+
+	/*! Compresses data and writes file with header. */
+	static void writeFile(const IBK::Path & checkpointFile, unsigned int version, const std::vector<char> & data);
+
+	/*! Reads a file written by writeFile() and returns uncompressed data. */
+	static void readFile(const IBK::Path & checkpointFile, unsigned int version, std::vector<char> & data);
+
+	/*! Background thread. */
+	std::thread					m_thread;
+
+	/*! Mutex guarding all members below. */
+	std::mutex					m_mutex;
+	/*! Signals background thread that new data is available (or that the writer shuts down). */
+	std::condition_variable		m_dataAvailable;
+	/*! Signals that a pending checkpoint has been written. */
+	std::condition_variable		m_writeDone;
+
+	/*! Set when data is waiting to be written or being written. */
+	bool						m_pending;
+	/*! Set to true to let background thread exit its loop. */
+	bool						m_shutdown;
+	/*! Target file of pending checkpoint. */
+	IBK::Path					m_checkpointFile;
+	/*! Format version of pending checkpoint. */
+	unsigned int				m_version;
+	/*! Data of pending checkpoint. */
+	std::vector<char>			m_data;
+	/*! Function completing data of pending checkpoint (may be empty). */
+	std::function<void(std::vector<char> &)>	m_completeData;
+	/*! Exception caught while writing last checkpoint (nullptr if none). */
+	std::exception_ptr			m_exception;
+
+	/*! Chunks present in current pack file (only accessed by background thread). */
+	std::unordered_map<ChunkId, PackedChunk, ChunkIdHash>	m_diskChunks;
+	/*! Number of current pack file. */
+	uint32_t					m_packNumber;
+	/*! Set when an existing checkpoint of a previous run has been scanned for re-usable chunks. */
+	bool						m_checkpointScanned;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_CHECKPOINTWRITER_H
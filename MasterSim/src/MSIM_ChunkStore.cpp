@@ -0,0 +1,179 @@
+#include "MSIM_ChunkStore.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include <IBK_Exception.h>
+#include <IBK_assert.h>
+
+namespace MASTER_SIM {
+
+/*! Minimum chunk size in bytes (no boundaries are searched within the first bytes of a chunk). */
+static const size_t MIN_CHUNK_SIZE = 2*1024;
+/*! Maximum chunk size in bytes. */
+static const size_t MAX_CHUNK_SIZE = 64*1024;
+/*! A chunk boundary is placed where the 13 upper bits of the rolling hash are zero,
+	resulting in an average chunk size of about MIN_CHUNK_SIZE + 8 kB.
+*/
+static const uint64_t BOUNDARY_MASK = 0xFFF8000000000000ull;
+
+
+/*! Returns table with random numbers for the rolling (gear) hash used to find chunk boundaries. */
+static const uint64_t * gearTable() {
+	struct Table {
+		Table() {
+			// splitmix64 generator with fixed seed, table must be identical in all program runs
+			uint64_t x = 0x4d534d43484b5031ull;
+			for (unsigned int i=0; i<256; ++i) {
+				uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				m_values[i] = z ^ (z >> 31);
+			}
+		}
+		uint64_t m_values[256];
+	};
+	static const Table table;
+	return table.m_values;
+}
+
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+
+static inline uint64_t fmix64(uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdull;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ull;
+	k ^= k >> 33;
+	return k;
+}
+
+
+ChunkId ChunkStore::chunkId(const char * data, size_t size) {
+	// 128-bit hash with the structure of MurmurHash3, processing 8-byte words in two independent lanes
+	const uint64_t c1 = 0x87c37b91114253d5ull;
+	const uint64_t c2 = 0x4cf5ad432745937full;
+	uint64_t h1 = 0x9E3779B97F4A7C15ull ^ size;
+	uint64_t h2 = 0xC2B2AE3D27D4EB4Full ^ size;
+	size_t nWords = size/8;
+	for (size_t i=0; i<nWords; ++i) {
+		uint64_t w;
+		std::memcpy(&w, data + i*8, 8);
+		uint64_t k1 = rotl64(w*c1, 31)*c2;
+		h1 ^= k1;
+		h1 = rotl64(h1, 27)*5 + 0x52dce729;
+		uint64_t k2 = rotl64(w*c2, 33)*c1;
+		h2 ^= k2;
+		h2 = rotl64(h2, 31)*5 + 0x38495ab5;
+	}
+	// remaining bytes
+	if (size % 8 != 0) {
+		uint64_t w = 0;
+		std::memcpy(&w, data + nWords*8, size % 8);
+		h1 ^= rotl64(w*c1, 31)*c2;
+		h2 ^= rotl64(w*c2, 33)*c1;
+	}
+	h1 += h2;
+	h2 += h1;
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+	h1 += h2;
+	h2 += h1;
+
+	ChunkId id;
+	id.m_hash[0] = h1;
+	id.m_hash[1] = h2;
+	id.m_size = (uint32_t)size;
+	return id;
+}
+
+
+void ChunkStore::split(const char * data, size_t size, std::vector<ChunkId> & ids) {
+	const uint64_t * gear = gearTable();
+	ids.clear();
+	size_t pos = 0;
+	while (pos < size) {
+		size_t remaining = size - pos;
+		size_t len = remaining;
+		if (remaining > MIN_CHUNK_SIZE) {
+			// search chunk boundary with rolling hash, the hash depends only on the last 64 bytes
+			size_t end = std::min(remaining, MAX_CHUNK_SIZE);
+			const unsigned char * p = reinterpret_cast<const unsigned char *>(data + pos);
+			uint64_t fp = 0;
+			len = MIN_CHUNK_SIZE;
+			for (; len<end; ++len) {
+				fp = (fp << 1) + gear[p[len]];
+				if ((fp & BOUNDARY_MASK) == 0) {
+					++len;
+					break;
+				}
+			}
+		}
+		ids.push_back(chunkId(data + pos, len));
+		pos += len;
+	}
+}
+
+
+void ChunkStore::add(const std::vector<char> & data, std::vector<ChunkId> & recipe) {
+	const char * const FUNC_ID = "[ChunkStore::add]";
+	split(data.data(), data.size(), recipe);
+	size_t pos = 0;
+	for (const ChunkId & id : recipe) {
+		const char * p = data.data() + pos;
+		std::unordered_map<ChunkId, Chunk, ChunkIdHash>::iterator it = m_chunks.find(id);
+		if (it == m_chunks.end()) {
+			Chunk & chunk = m_chunks[id];
+			chunk.m_data.assign(p, p + id.m_size);
+			chunk.m_refCount = 1;
+			m_memoryUsage += id.m_size;
+		}
+		else {
+			// identical hashes of different data are practically impossible, but would silently corrupt restored states
+			if (std::memcmp(it->second.m_data.data(), p, id.m_size) != 0)
+				throw IBK::Exception("Hash collision in chunk store.", FUNC_ID);
+			++it->second.m_refCount;
+		}
+		pos += id.m_size;
+	}
+}
+
+
+void ChunkStore::release(const std::vector<ChunkId> & recipe) {
+	for (const ChunkId & id : recipe) {
+		std::unordered_map<ChunkId, Chunk, ChunkIdHash>::iterator it = m_chunks.find(id);
+		IBK_ASSERT(it != m_chunks.end());
+		if (--it->second.m_refCount == 0) {
+			m_memoryUsage -= id.m_size;
+			m_chunks.erase(it);
+		}
+	}
+}
+
+
+void ChunkStore::assemble(const std::vector<ChunkId> & recipe, std::vector<char> & data) const {
+	size_t size = 0;
+	for (const ChunkId & id : recipe)
+		size += id.m_size;
+	data.resize(size);
+	size_t pos = 0;
+	for (const ChunkId & id : recipe) {
+		std::unordered_map<ChunkId, Chunk, ChunkIdHash>::const_iterator it = m_chunks.find(id);
+		IBK_ASSERT(it != m_chunks.end());
+		if (id.m_size != 0)
+			std::memcpy(&data[pos], it->second.m_data.data(), id.m_size);
+		pos += id.m_size;
+	}
+}
+
+
+void ChunkStore::clear() {
+	m_chunks.clear();
+	m_memoryUsage = 0;
+}
+
+} // namespace MASTER_SIM
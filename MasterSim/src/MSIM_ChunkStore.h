@@ -0,0 +1,89 @@
+#ifndef MSIM_CHUNKSTORE_H
+#define MSIM_CHUNKSTORE_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace MASTER_SIM {
+
+/*! Identifies a chunk of data by a 128-bit hash of its content and its size. */
+struct ChunkId {
+	/*! Comparison operator. */
+	bool operator==(const ChunkId & other) const {
+		return m_hash[0] == other.m_hash[0] && m_hash[1] == other.m_hash[1] && m_size == other.m_size;
+	}
+
+	/*! Hash value of chunk content. */
+	uint64_t	m_hash[2];
+	/*! Size of chunk in bytes. */
+	uint32_t	m_size;
+};
+
+/*! Hash functor for using ChunkId as key in unordered containers. */
+struct ChunkIdHash {
+	size_t operator()(const ChunkId & id) const { return (size_t)id.m_hash[0]; }
+};
+
+
+/*! Content-addressed in-memory store for chunks of serialized data.
+
+	Serialized FMU states of consecutive checkpoints/snapshots typically differ only in a small fraction of
+	their bytes. Data added to the store is split into content-defined chunks (chunk boundaries depend on
+	the data, so that inserted or removed bytes only affect the neighboring chunks) and only chunks that
+	are not yet in the store are copied. The data is described by the list of its chunk ids (the recipe),
+	from which it can be re-assembled. Chunks are reference counted and removed when the last recipe
+	referencing them has been released.
+*/
+class ChunkStore {
+public:
+	/*! Constructor. */
+	ChunkStore() : m_memoryUsage(0) {}
+
+	/*! Splits data into content-defined chunks.
+		\param data Pointer to data.
+		\param size Size of data in bytes.
+		\param ids Vector with ids of all chunks (in order of data), sum of chunk sizes equals size.
+	*/
+	static void split(const char * data, size_t size, std::vector<ChunkId> & ids);
+
+	/*! Computes id of a chunk. */
+	static ChunkId chunkId(const char * data, size_t size);
+
+	/*! Adds data to the store.
+		\param data Data to add.
+		\param recipe Returns the ids of all chunks that make up data.
+	*/
+	void add(const std::vector<char> & data, std::vector<ChunkId> & recipe);
+
+	/*! Releases all chunks referenced by the recipe. */
+	void release(const std::vector<ChunkId> & recipe);
+
+	/*! Re-assembles data from the chunks of a recipe. */
+	void assemble(const std::vector<ChunkId> & recipe, std::vector<char> & data) const;
+
+	/*! Removes all chunks. */
+	void clear();
+
+	/*! Total size of all stored chunks in bytes. */
+	size_t memoryUsage() const { return m_memoryUsage; }
+
+private:
+	/*! A stored chunk. */
+	struct Chunk {
+		/*! Content of chunk. */
+		std::vector<char>	m_data;
+		/*! Number of recipes referencing the chunk. */
+		unsigned int		m_refCount;
+	};
+
+	/*! All chunks, key is the chunk id. */
+	std::unordered_map<ChunkId, Chunk, ChunkIdHash>	m_chunks;
+	/*! Total size of all stored chunks in bytes. */
+	size_t											m_memoryUsage;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_CHUNKSTORE_H
@@ -0,0 +1,476 @@
+#include "MSIM_CompressedResults.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+#include <zlib.h>
+
+#include <IBK_Exception.h>
+#include <IBK_assert.h>
+#include <IBK_FormatString.h>
+#include <IBK_FileUtils.h>
+
+namespace MASTER_SIM {
+
+/*! Amount of row text collected before a frame is compressed and written. */
+static const size_t FRAME_TEXT_SIZE = 1024*1024;
+/*! Flag byte of gzip header: extra field present. */
+static const unsigned char GZIP_FEXTRA = 0x04;
+/*! Flag byte of gzip header: comment present. */
+static const unsigned char GZIP_FCOMMENT = 0x10;
+/*! Size of fixed part of gzip header in bytes (without extra field length). */
+static const size_t GZIP_HEADER_SIZE = 10;
+/*! Size of gzip trailer (CRC32 and uncompressed size). */
+static const size_t GZIP_TRAILER_SIZE = 8;
+/*! Length of frame subfield data. */
+static const size_t FRAME_FIELD_SIZE = 28;
+/*! Length of index subfield data. */
+static const size_t INDEX_FIELD_SIZE = 8;
+/*! Size of gzip header of a frame, including extra field. */
+static const size_t FRAME_HEADER_SIZE = GZIP_HEADER_SIZE + 2 + 4 + FRAME_FIELD_SIZE;
+/*! Size of gzip header of the index member, excluding the comment. */
+static const size_t INDEX_HEADER_SIZE = GZIP_HEADER_SIZE + 2 + 4 + INDEX_FIELD_SIZE;
+/*! Number of digits of index offset at end of index comment. */
+static const size_t INDEX_OFFSET_DIGITS = 20;
+/*! Last bytes of the index member: comment terminator, empty final deflate block and trailer of empty member. */
+static const char INDEX_TAIL[11] = { 0, 0x03, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+
+/*! Stores a value in little endian byte order. */
+static void putUInt(char * p, uint64_t val, unsigned int bytes) {
+	for (unsigned int i=0; i<bytes; ++i, val >>= 8)
+		p[i] = (char)(val & 0xff);
+}
+
+
+/*! Reads a value in little endian byte order. */
+static uint64_t getUInt(const char * p, unsigned int bytes) {
+	uint64_t val = 0;
+	for (unsigned int i=bytes; i>0; --i)
+		val = (val << 8) | (unsigned char)p[i-1];
+	return val;
+}
+
+
+/*! Stores a double in little endian byte order. */
+static void putDouble(char * p, double val) {
+	uint64_t bits;
+	std::memcpy(&bits, &val, sizeof(double));
+	putUInt(p, bits, 8);
+}
+
+
+/*! Reads a double in little endian byte order. */
+static double getDouble(const char * p) {
+	uint64_t bits = getUInt(p, 8);
+	double val;
+	std::memcpy(&val, &bits, sizeof(double));
+	return val;
+}
+
+
+/*! Composes the fixed part of a gzip member header with an extra field holding a single subfield.
+	\return Returns pointer to subfield data.
+*/
+static char * putGzipHeader(char * p, unsigned char flags, char id1, char id2, size_t fieldSize) {
+	const char header[GZIP_HEADER_SIZE] = { (char)0x1f, (char)0x8b, 8, (char)flags, 0, 0, 0, 0, 0, (char)0xff };
+	std::memcpy(p, header, GZIP_HEADER_SIZE);
+	putUInt(p + GZIP_HEADER_SIZE, 4 + fieldSize, 2);
+	p[GZIP_HEADER_SIZE + 2] = id1;
+	p[GZIP_HEADER_SIZE + 3] = id2;
+	putUInt(p + GZIP_HEADER_SIZE + 4, fieldSize, 2);
+	return p + GZIP_HEADER_SIZE + 6;
+}
+
+
+// *** CompressedResultWriter ***
+
+CompressedResultWriter::CompressedResultWriter() :
+	m_file(nullptr),
+	m_fileSize(0),
+	m_indexWritten(false)
+{
+}
+
+
+CompressedResultWriter::~CompressedResultWriter() {
+	if (m_file != nullptr)
+		std::fclose(m_file);
+}
+
+
+void CompressedResultWriter::create(const IBK::Path & fname, const std::string & captionLine) {
+	openFile(fname, "wb");
+	m_fileSize = 0;
+	m_frames.clear();
+	m_text.assign(captionLine.begin(), captionLine.end());
+	m_frame = CompressedResultFrame();
+	writeFrame();
+}
+
+
+void CompressedResultWriter::reopen(const IBK::Path & fname, const CompressedResultFrame & pendingRows,
+									const std::vector<char> & pendingText)
+{
+	const char * const FUNC_ID = "[CompressedResultWriter::reopen]";
+	m_fileSize = fname.fileSize();
+	if (CompressedResultReader::scanFrames(fname, m_frames) != (uint64_t)m_fileSize)
+		throw IBK::Exception(IBK::FormatString("Result file '%1' ends with an incomplete frame.").arg(fname), FUNC_ID);
+	if (m_frames.empty())
+		throw IBK::Exception(IBK::FormatString("Result file '%1' does not contain a caption line.").arg(fname), FUNC_ID);
+	openFile(fname, "ab");
+	m_text = pendingText;
+	m_frame = pendingRows;
+	m_frame.m_offset = 0;
+	m_frame.m_size = 0;
+	m_frame.m_textSize = 0;
+	m_indexWritten = false;
+}
+
+
+void CompressedResultWriter::appendRow(double t, const char * text, size_t size) {
+	if (m_frame.m_rowCount == 0)
+		m_frame.m_tFirst = t;
+	m_frame.m_tLast = t;
+	++m_frame.m_rowCount;
+	m_text.insert(m_text.end(), text, text + size);
+	if (m_text.size() >= FRAME_TEXT_SIZE)
+		writeFrame();
+}
+
+
+CompressedResultFrame CompressedResultWriter::pendingRows() const {
+	CompressedResultFrame frame = m_frame;
+	frame.m_offset = (uint64_t)m_fileSize;
+	frame.m_textSize = (uint32_t)m_text.size();
+	return frame;
+}
+
+
+void CompressedResultWriter::pendingText(const CompressedResultFrame & pendingRows, std::vector<char> & text) {
+	const char * const FUNC_ID = "[CompressedResultWriter::pendingText]";
+	text.clear();
+	if (pendingRows.m_textSize == 0)
+		return;
+	if (pendingRows.m_offset == (uint64_t)m_fileSize) {
+		// rows are still pending (further rows may have been appended)
+		IBK_ASSERT(m_text.size() >= pendingRows.m_textSize);
+		text.assign(m_text.begin(), m_text.begin() + pendingRows.m_textSize);
+		return;
+	}
+	// rows have been compressed into the frame starting at the given position, read frame back from file
+	if (m_file != nullptr && std::fflush(m_file) != 0)
+		throw IBK::Exception(IBK::FormatString("Error writing result file '%1'.").arg(m_fname), FUNC_ID);
+	CompressedResultReader reader;
+	reader.open(m_fname);
+	for (size_t i=0; i<reader.frames().size(); ++i) {
+		if (reader.frames()[i].m_offset == pendingRows.m_offset) {
+			std::string frameText;
+			reader.readFrame(i, frameText);
+			if (frameText.size() < pendingRows.m_textSize)
+				break;
+			text.assign(frameText.begin(), frameText.begin() + pendingRows.m_textSize);
+			return;
+		}
+	}
+	throw IBK::Exception(IBK::FormatString("Result file '%1' does not contain the frame with pending rows.").arg(m_fname), FUNC_ID);
+}
+
+
+void CompressedResultWriter::flush() {
+	writeFrame();
+	if (m_file != nullptr && std::fflush(m_file) != 0)
+		throw IBK::Exception(IBK::FormatString("Error writing result file '%1'.").arg(m_fname), "[CompressedResultWriter::flush]");
+}
+
+
+void CompressedResultWriter::finish() {
+	if (m_file == nullptr)
+		return;
+	writeFrame();
+	if (!m_indexWritten) {
+		// comment with one line per frame, terminated by the offset of the index member
+		std::stringstream strm;
+		strm << "MasterSim frame index\n";
+		char line[128];
+		for (const CompressedResultFrame & frame : m_frames) {
+			std::snprintf(line, sizeof(line), "%llu\t%u\t%u\t%u\t%.17g\t%.17g\n", (unsigned long long)frame.m_offset,
+						  frame.m_size, frame.m_textSize, frame.m_rowCount, frame.m_tFirst, frame.m_tLast);
+			strm << line;
+		}
+		std::snprintf(line, sizeof(line), "%020llu", (unsigned long long)m_fileSize);
+		strm << line;
+		std::string comment = strm.str();
+
+		std::vector<char> member(INDEX_HEADER_SIZE);
+		char * field = putGzipHeader(&member[0], GZIP_FEXTRA | GZIP_FCOMMENT, 'M', 'I', INDEX_FIELD_SIZE);
+		putUInt(field, INDEX_HEADER_SIZE + comment.size() + sizeof(INDEX_TAIL), 4);
+		putUInt(field + 4, m_frames.size(), 4);
+		member.insert(member.end(), comment.begin(), comment.end());
+		member.insert(member.end(), INDEX_TAIL, INDEX_TAIL + sizeof(INDEX_TAIL));
+		// Note: when rows are appended afterwards, this index member is skipped by readers
+		write(member.data(), member.size());
+		m_indexWritten = true;
+	}
+	if (std::fflush(m_file) != 0)
+		throw IBK::Exception(IBK::FormatString("Error writing result file '%1'.").arg(m_fname), "[CompressedResultWriter::finish]");
+}
+
+
+void CompressedResultWriter::close() {
+	m_text.clear();
+	m_frame = CompressedResultFrame();
+	if (m_file != nullptr) {
+		int res = std::fclose(m_file);
+		m_file = nullptr;
+		if (res != 0)
+			throw IBK::Exception(IBK::FormatString("Error writing result file '%1'.").arg(m_fname), "[CompressedResultWriter::close]");
+	}
+}
+
+
+void CompressedResultWriter::openFile(const IBK::Path & fname, const char * mode) {
+	const char * const FUNC_ID = "[CompressedResultWriter::openFile]";
+	close();
+	m_fname = fname;
+#if defined(_WIN32)
+	std::wstring wmode(mode, mode + std::strlen(mode));
+	m_file = _wfopen(fname.wstrOS().c_str(), wmode.c_str());
+#else
+	m_file = std::fopen(fname.str().c_str(), mode);
+#endif
+	if (m_file == nullptr)
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1' for writing.").arg(fname), FUNC_ID);
+	m_text.reserve(FRAME_TEXT_SIZE + 64*1024);
+	m_indexWritten = false;
+}
+
+
+void CompressedResultWriter::writeFrame() {
+	const char * const FUNC_ID = "[CompressedResultWriter::writeFrame]";
+	if (m_text.empty() || m_file == nullptr)
+		return;
+
+	// raw deflate stream, gzip header and trailer are composed here,
+	// fastest compression level so that the output thread keeps up with the simulation
+	z_stream strm;
+	std::memset(&strm, 0, sizeof(strm));
+	if (deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		throw IBK::Exception("Cannot initialize zlib.", FUNC_ID);
+	uLong bound = deflateBound(&strm, (uLong)m_text.size());
+	m_compressed.resize(FRAME_HEADER_SIZE + bound + GZIP_TRAILER_SIZE);
+	strm.next_in = reinterpret_cast<Bytef*>(m_text.data());
+	strm.avail_in = (uInt)m_text.size();
+	strm.next_out = reinterpret_cast<Bytef*>(&m_compressed[FRAME_HEADER_SIZE]);
+	strm.avail_out = (uInt)bound;
+	int res = deflate(&strm, Z_FINISH);
+	size_t compressedSize = strm.total_out;
+	deflateEnd(&strm);
+	if (res != Z_STREAM_END)
+		throw IBK::Exception("Error compressing output rows.", FUNC_ID);
+
+	m_frame.m_offset = (uint64_t)m_fileSize;
+	m_frame.m_size = (uint32_t)(FRAME_HEADER_SIZE + compressedSize + GZIP_TRAILER_SIZE);
+	m_frame.m_textSize = (uint32_t)m_text.size();
+
+	char * field = putGzipHeader(&m_compressed[0], GZIP_FEXTRA, 'M', 'F', FRAME_FIELD_SIZE);
+	putUInt(field, m_frame.m_size, 4);
+	putUInt(field + 4, m_frame.m_textSize, 4);
+	putUInt(field + 8, m_frame.m_rowCount, 4);
+	putDouble(field + 12, m_frame.m_tFirst);
+	putDouble(field + 20, m_frame.m_tLast);
+
+	char * trailer = &m_compressed[FRAME_HEADER_SIZE + compressedSize];
+	putUInt(trailer, crc32(0, reinterpret_cast<const Bytef*>(m_text.data()), (uInt)m_text.size()), 4);
+	putUInt(trailer + 4, m_frame.m_textSize, 4);
+
+	write(m_compressed.data(), m_frame.m_size);
+	m_frames.push_back(m_frame);
+	m_indexWritten = false;
+
+	m_text.clear();
+	m_frame = CompressedResultFrame();
+}
+
+
+void CompressedResultWriter::write(const char * data, size_t size) {
+	if (std::fwrite(data, 1, size, m_file) != size)
+		throw IBK::Exception(IBK::FormatString("Error writing result file '%1'.").arg(m_fname), "[CompressedResultWriter::write]");
+	m_fileSize += (int64_t)size;
+}
+
+
+
+// *** CompressedResultReader ***
+
+void CompressedResultReader::open(const IBK::Path & fname) {
+	const char * const FUNC_ID = "[CompressedResultReader::open]";
+	m_in.close();
+	m_in.clear();
+	m_fname = fname;
+	if (!IBK::open_ifstream(m_in, fname, std::ios_base::in | std::ios_base::binary))
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(fname), FUNC_ID);
+	// use index if present, otherwise enumerate frames from their headers
+	if (!readIndex(fname.fileSize())) {
+		m_in.clear();
+		scanFrames(fname, m_frames);
+	}
+	if (m_frames.empty())
+		throw IBK::Exception(IBK::FormatString("Result file '%1' does not contain a caption line.").arg(fname), FUNC_ID);
+}
+
+
+size_t CompressedResultReader::findFrame(double t) const {
+	// frames are sorted by time, skip caption frame
+	for (size_t i=1; i<m_frames.size(); ++i)
+		if (m_frames[i].m_tLast >= t)
+			return i;
+	return m_frames.size();
+}
+
+
+void CompressedResultReader::readFrame(size_t i, std::string & text) {
+	const char * const FUNC_ID = "[CompressedResultReader::readFrame]";
+	const CompressedResultFrame & frame = m_frames[i];
+	m_compressed.resize(frame.m_size);
+	m_in.clear();
+	if (frame.m_size < FRAME_HEADER_SIZE + GZIP_TRAILER_SIZE || !m_in.seekg((std::streamoff)frame.m_offset) ||
+		!m_in.read(m_compressed.data(), frame.m_size))
+	{
+		throw IBK::Exception(IBK::FormatString("Result file '%1' is corrupt or truncated.").arg(m_fname), FUNC_ID);
+	}
+
+	text.resize(frame.m_textSize);
+	z_stream strm;
+	std::memset(&strm, 0, sizeof(strm));
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+		throw IBK::Exception("Cannot initialize zlib.", FUNC_ID);
+	strm.next_in = reinterpret_cast<Bytef*>(&m_compressed[FRAME_HEADER_SIZE]);
+	strm.avail_in = (uInt)(frame.m_size - FRAME_HEADER_SIZE - GZIP_TRAILER_SIZE);
+	strm.next_out = reinterpret_cast<Bytef*>(&text[0]);
+	strm.avail_out = (uInt)text.size();
+	int res = inflate(&strm, Z_FINISH);
+	size_t textSize = strm.total_out;
+	inflateEnd(&strm);
+	const char * trailer = &m_compressed[frame.m_size - GZIP_TRAILER_SIZE];
+	if (res != Z_STREAM_END || textSize != frame.m_textSize ||
+		getUInt(trailer, 4) != crc32(0, reinterpret_cast<const Bytef*>(text.data()), (uInt)text.size()))
+	{
+		throw IBK::Exception(IBK::FormatString("Result file '%1' is corrupt or truncated.").arg(m_fname), FUNC_ID);
+	}
+}
+
+
+void CompressedResultReader::writeCSV(const IBK::Path & csvFile) {
+	const char * const FUNC_ID = "[CompressedResultReader::writeCSV]";
+	std::ofstream out;
+	if (!IBK::open_ofstream(out, csvFile, std::ios_base::trunc | std::ios_base::binary))
+		throw IBK::Exception(IBK::FormatString("Cannot create file '%1'.").arg(csvFile), FUNC_ID);
+	std::string text;
+	for (size_t i=0; i<m_frames.size(); ++i) {
+		readFrame(i, text);
+		out.write(text.data(), (std::streamsize)text.size());
+	}
+	if (!out)
+		throw IBK::Exception(IBK::FormatString("Error writing file '%1'.").arg(csvFile), FUNC_ID);
+}
+
+
+uint64_t CompressedResultReader::scanFrames(const IBK::Path & fname, std::vector<CompressedResultFrame> & frames) {
+	const char * const FUNC_ID = "[CompressedResultReader::scanFrames]";
+	std::ifstream in;
+	if (!IBK::open_ifstream(in, fname, std::ios_base::in | std::ios_base::binary))
+		throw IBK::Exception(IBK::FormatString("Cannot open result file '%1'.").arg(fname), FUNC_ID);
+	uint64_t fileSize = (uint64_t)fname.fileSize();
+	frames.clear();
+	uint64_t pos = 0;
+	char header[FRAME_HEADER_SIZE];
+	while (pos + INDEX_HEADER_SIZE <= fileSize) {
+		if (!in.seekg((std::streamoff)pos) || !in.read(header, INDEX_HEADER_SIZE))
+			break;
+		if ((unsigned char)header[0] != 0x1f || (unsigned char)header[1] != 0x8b || header[2] != 8 ||
+			(header[3] & GZIP_FEXTRA) == 0 || header[GZIP_HEADER_SIZE + 2] != 'M')
+		{
+			throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+		}
+		uint64_t fieldSize = getUInt(header + GZIP_HEADER_SIZE + 4, 2);
+		if (header[GZIP_HEADER_SIZE + 3] == 'I' && fieldSize == INDEX_FIELD_SIZE) {
+			// skip index member
+			uint64_t memberSize = getUInt(header + GZIP_HEADER_SIZE + 6, 4);
+			if (memberSize < INDEX_HEADER_SIZE)
+				throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+			if (pos + memberSize > fileSize)
+				break;
+			pos += memberSize;
+			continue;
+		}
+		if (header[GZIP_HEADER_SIZE + 3] != 'F' || fieldSize != FRAME_FIELD_SIZE)
+			throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+		if (!in.read(header + INDEX_HEADER_SIZE, FRAME_HEADER_SIZE - INDEX_HEADER_SIZE))
+			break;
+		const char * field = header + GZIP_HEADER_SIZE + 6;
+		CompressedResultFrame frame;
+		frame.m_offset = pos;
+		frame.m_size = (uint32_t)getUInt(field, 4);
+		frame.m_textSize = (uint32_t)getUInt(field + 4, 4);
+		frame.m_rowCount = (uint32_t)getUInt(field + 8, 4);
+		frame.m_tFirst = getDouble(field + 12);
+		frame.m_tLast = getDouble(field + 20);
+		if (frame.m_size < FRAME_HEADER_SIZE + GZIP_TRAILER_SIZE)
+			throw IBK::Exception(IBK::FormatString("Invalid format of result file '%1'.").arg(fname), FUNC_ID);
+		// incomplete last frame
+		if (pos + frame.m_size > fileSize)
+			break;
+		frames.push_back(frame);
+		pos += frame.m_size;
+	}
+	return pos;
+}
+
+
+bool CompressedResultReader::readIndex(int64_t fileSize) {
+	// last bytes: offset of index member, comment terminator and empty deflate stream with trailer
+	const size_t TAIL_SIZE = INDEX_OFFSET_DIGITS + sizeof(INDEX_TAIL);
+	if (fileSize < (int64_t)(INDEX_HEADER_SIZE + TAIL_SIZE))
+		return false;
+	char tail[TAIL_SIZE];
+	if (!m_in.seekg((std::streamoff)(fileSize - (int64_t)TAIL_SIZE)) || !m_in.read(tail, TAIL_SIZE) ||
+		std::memcmp(tail + INDEX_OFFSET_DIGITS, INDEX_TAIL, sizeof(INDEX_TAIL)) != 0)
+	{
+		return false;
+	}
+	std::string offsetStr(tail, INDEX_OFFSET_DIGITS);
+	if (offsetStr.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+	uint64_t offset = std::strtoull(offsetStr.c_str(), nullptr, 10);
+	if (offset + INDEX_HEADER_SIZE + TAIL_SIZE > (uint64_t)fileSize)
+		return false;
+
+	// index member header
+	char header[INDEX_HEADER_SIZE];
+	if (!m_in.seekg((std::streamoff)offset) || !m_in.read(header, INDEX_HEADER_SIZE) ||
+		(unsigned char)header[3] != (GZIP_FEXTRA | GZIP_FCOMMENT) ||
+		header[GZIP_HEADER_SIZE + 2] != 'M' || header[GZIP_HEADER_SIZE + 3] != 'I' ||
+		getUInt(header + GZIP_HEADER_SIZE + 6, 4) != (uint64_t)fileSize - offset)
+	{
+		return false;
+	}
+	size_t frameCount = (size_t)getUInt(header + GZIP_HEADER_SIZE + 10, 4);
+
+	// comment with frame list
+	std::string comment((size_t)((uint64_t)fileSize - offset - INDEX_HEADER_SIZE - sizeof(INDEX_TAIL)), ' ');
+	if (!m_in.read(&comment[0], (std::streamsize)comment.size()))
+		return false;
+	std::stringstream strm(comment);
+	std::string line;
+	std::getline(strm, line);
+	m_frames.resize(frameCount);
+	for (CompressedResultFrame & frame : m_frames) {
+		if (!(strm >> frame.m_offset >> frame.m_size >> frame.m_textSize >> frame.m_rowCount >> frame.m_tFirst >> frame.m_tLast))
+			return false;
+	}
+	return true;
+}
+
+} // namespace MASTER_SIM
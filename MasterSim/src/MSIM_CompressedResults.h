@@ -0,0 +1,204 @@
+#ifndef MSIM_COMPRESSEDRESULTS_H
+#define MSIM_COMPRESSEDRESULTS_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+
+#include <IBK_Path.h>
+
+namespace MASTER_SIM {
+
+/*! Describes a frame of a compressed result file. */
+struct CompressedResultFrame {
+	/*! Constructor. */
+	CompressedResultFrame() : m_offset(0), m_size(0), m_textSize(0), m_rowCount(0), m_tFirst(0), m_tLast(0) {}
+
+	/*! Position of frame in file in bytes. */
+	uint64_t	m_offset;
+	/*! Size of frame in file in bytes. */
+	uint32_t	m_size;
+	/*! Size of uncompressed text in bytes. */
+	uint32_t	m_textSize;
+	/*! Number of rows in frame (0 for the frame holding the caption line). */
+	uint32_t	m_rowCount;
+	/*! Time of first row (value of first column, in output time unit). */
+	double		m_tFirst;
+	/*! Time of last row (value of first column, in output time unit). */
+	double		m_tLast;
+};
+
+
+/*! Writes result file 'values.csv.gz', a compressed version of 'values.csv' that can be read selectively.
+
+	Rows are collected until about 1 MB of text is available. This block of text is then compressed
+	independently of all other blocks and written as a single gzip member (a frame). Since a gzip file may
+	consist of any number of members, the file can be decompressed with standard tools (gzip, zcat, any
+	zlib-based reader) and yields the content of 'values.csv'. The first frame holds only the caption line.
+
+	Each frame carries its position information in an extra field of the gzip header (subfield 'MF',
+	all numbers little endian):
+	\code
+	uint32    size of frame in bytes (gzip header, compressed data and trailer)
+	uint32    size of uncompressed text in bytes
+	uint32    number of rows
+	double    time of first row
+	double    time of last row
+	\endcode
+
+	When the file is finished, an index member with an empty payload is appended. Its extra field
+	(subfield 'MI') holds the member size and the number of frames, its comment holds one line per frame
+	with offset, size, text size, row count, first and last time (tab-separated), and ends with the offset
+	of the index member in 20 digits. The index can therefore be located from the last bytes of the file,
+	and a reader can decompress only the frames covering a given time range. If the index is missing
+	(simulation aborted), the frames can still be enumerated from their headers.
+
+	Frames are completed when flush() is called (e.g. when creating checkpoints), so that the file size at
+	this time marks a frame boundary and the file may be truncated there when restarting a simulation.
+	In-memory snapshots do not complete a frame, they record the pending rows instead (see pendingRows()).
+*/
+class CompressedResultWriter {
+public:
+	/*! Constructor. */
+	CompressedResultWriter();
+	/*! Destructor, closes file (pending rows are discarded, call finish() before). */
+	~CompressedResultWriter();
+
+	/*! Creates a new result file and writes the frame with the caption line.
+		\param fname Result file path.
+		\param captionLine Caption line including line break.
+	*/
+	void create(const IBK::Path & fname, const std::string & captionLine);
+
+	/*! Re-opens an existing result file for appending rows (when restarting or rewinding a simulation).
+		The file must end at a frame boundary, an existing index is ignored and a new index is appended by finish().
+		\param fname Result file path.
+		\param pendingRows Rows that had not been compressed into a frame at the position the file has been truncated to,
+			see pendingRows(). These rows are appended to the next frame.
+		\param pendingText Text of the pending rows, see pendingText().
+	*/
+	void reopen(const IBK::Path & fname, const CompressedResultFrame & pendingRows = CompressedResultFrame(),
+				const std::vector<char> & pendingText = std::vector<char>());
+
+	/*! Appends a row.
+		\param t Time of row (value of first column).
+		\param text Row text including line break.
+		\param size Length of text in bytes.
+	*/
+	void appendRow(double t, const char * text, size_t size);
+
+	/*! Compresses pending rows into a frame and flushes the file. */
+	void flush();
+
+	/*! Compresses pending rows into a frame and appends the frame index.
+		Further rows may be appended afterwards, in this case a new index is appended with the next call to finish().
+	*/
+	void finish();
+
+	/*! Closes the file, pending rows are discarded. */
+	void close();
+
+	/*! Size of file in bytes (pending rows are not included before they are compressed into a frame). */
+	int64_t fileSize() const { return m_fileSize; }
+
+	/*! Returns row count, time range and text size of the rows not yet compressed into a frame, m_offset holds the
+		current file size. Together with the file size, this describes the current position without completing a frame.
+	*/
+	CompressedResultFrame pendingRows() const;
+
+	/*! Returns the text of rows that were pending at an earlier position (see pendingRows()).
+		If these rows have been compressed into a frame meanwhile, the frame is read back from the file.
+	*/
+	void pendingText(const CompressedResultFrame & pendingRows, std::vector<char> & text);
+
+	/*! All completed frames. */
+	const std::vector<CompressedResultFrame> & frames() const { return m_frames; }
+
+private:
+	/*! Opens the file with the given mode. */
+	void openFile(const IBK::Path & fname, const char * mode);
+	/*! Compresses pending text into a frame and writes it to file. */
+	void writeFrame();
+	/*! Writes data to file and updates file size. */
+	void write(const char * data, size_t size);
+
+	/*! File handle. */
+	std::FILE							*m_file;
+	/*! File path. */
+	IBK::Path							m_fname;
+	/*! Size of file in bytes. */
+	int64_t								m_fileSize;
+	/*! All frames in file. */
+	std::vector<CompressedResultFrame>	m_frames;
+	/*! Frame currently being collected (row count and time range). */
+	CompressedResultFrame				m_frame;
+	/*! Text of rows in frame currently being collected. */
+	std::vector<char>					m_text;
+	/*! Buffer for the compressed frame. */
+	std::vector<char>					m_compressed;
+	/*! True, if the index at the end of the file is up-to-date. */
+	bool								m_indexWritten;
+};
+
+
+/*! Reads result files written by CompressedResultWriter.
+
+	Only the frame index (or the frame headers) is read when opening the file, frames are decompressed
+	individually on request.
+
+	\code
+	CompressedResultReader reader;
+	reader.open(IBK::Path("results/values.csv.gz"));
+	std::string text;
+	for (size_t i=reader.findFrame(86400); i<reader.frames().size(); ++i) {
+		reader.readFrame(i, text);
+		std::cout << text;
+	}
+	\endcode
+*/
+class CompressedResultReader {
+public:
+	/*! Opens a result file and reads the frame index. */
+	void open(const IBK::Path & fname);
+
+	/*! All frames in file, the first frame holds the caption line. */
+	const std::vector<CompressedResultFrame> & frames() const { return m_frames; }
+
+	/*! Returns index of the first frame with rows at or after time t (value of first column),
+		or the number of frames if there is no such frame.
+	*/
+	size_t findFrame(double t) const;
+
+	/*! Decompresses frame i and stores the text of all rows in text. */
+	void readFrame(size_t i, std::string & text);
+
+	/*! Writes the uncompressed content, the created file is identical to the 'values.csv' file
+		written by MasterSim for the same simulation.
+	*/
+	void writeCSV(const IBK::Path & csvFile);
+
+	/*! Enumerates all frames of a result file from their gzip headers.
+		Index members are skipped, an incomplete last frame (e.g. when the simulation was aborted) is ignored.
+		\return Returns the end position of the last complete member in bytes.
+	*/
+	static uint64_t scanFrames(const IBK::Path & fname, std::vector<CompressedResultFrame> & frames);
+
+private:
+	/*! Reads the index at the end of the file, returns false if there is no valid index. */
+	bool readIndex(int64_t fileSize);
+
+	/*! File path. */
+	IBK::Path							m_fname;
+	/*! Input file stream. */
+	std::ifstream						m_in;
+	/*! All frames in file. */
+	std::vector<CompressedResultFrame>	m_frames;
+	/*! Buffer for the compressed frame. */
+	std::vector<char>					m_compressed;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_COMPRESSEDRESULTS_H
@@ -222,39 +222,6 @@ void FMU::import(ModelDescription::FMUType typeToImport) {
 }
 
 
-unsigned int FMU::localOutputIndex(FMIVariable::VarType t, unsigned int valueReference) const {
-	switch (t) {
-		case FMIVariable::VT_BOOL : {
-			// search corresponding vector for valueReference and return index
-			for (unsigned int i=0; i<m_boolValueRefsOutput.size(); ++i)
-				if (m_boolValueRefsOutput[i] == valueReference)
-					return i;
-		} break;
-		case FMIVariable::VT_INT : {
-			// search corresponding vector for valueReference and return index
-			for (unsigned int i=0; i<m_intValueRefsOutput.size(); ++i)
-				if (m_intValueRefsOutput[i] == valueReference)
-					return i;
-		} break;
-		case FMIVariable::VT_DOUBLE : {
-			// search corresponding vector for valueReference and return index
-			for (unsigned int i=0; i<m_doubleValueRefsOutput.size(); ++i)
-				if (m_doubleValueRefsOutput[i] == valueReference)
-					return i;
-		} break;
-		case FMIVariable::VT_STRING : {
-			// search corresponding vector for valueReference and return index
-			for (unsigned int i=0; i<m_stringValueRefsOutput.size(); ++i)
-				if (m_stringValueRefsOutput[i] == valueReference)
-					return i;
-		} break;
-		case FMIVariable::NUM_VT : ; // just to remove compiler warning
-	}
-	throw IBK::Exception( IBK::FormatString("Variable of type '%1' with value reference %2 is not defined in this FMU.")
-		.arg(FMIVariable::varType2String(t)).arg(valueReference), "[FMU::localOutputIndex]");
-}
-
-
 void FMU::importFMIv1Functions() {
 	try {
 		std::string modelPrefix = m_modelDescription.m_modelIdentifier + "_";
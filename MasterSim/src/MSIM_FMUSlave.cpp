@@ -7,11 +7,16 @@
 #include <cstdlib>
 #include <cstdarg>
 #include <cstdio>
+#include <mutex>
 
 #include "MSIM_FMU.h"
+#include "MSIM_OutputFilter.h"
 
 namespace MASTER_SIM {
 
+/*! Serializes log messages from FMUs, since slaves may be evaluated concurrently. */
+static std::mutex loggerMutex;
+
 void fmiLoggerCallback( fmiComponent /* c */, fmiString instanceName, fmiStatus status,
 						fmiString category, fmiString message, ... )
 {
@@ -22,6 +27,7 @@ void fmiLoggerCallback( fmiComponent /* c */, fmiString instanceName, fmiStatus
 		default :;
 	}
 
+	std::lock_guard<std::mutex> lock(loggerMutex);
 	static char buffer[5000];
 	va_list args;
 	va_start (args, message);
@@ -48,6 +54,7 @@ void fmi2LoggerCallback( fmi2ComponentEnvironment /* c */, fmi2String instanceNa
 		default :;
 	}
 
+	std::lock_guard<std::mutex> lock(loggerMutex);
 	static char buffer[5000];
 	va_list args;
 	va_start (args, message);
@@ -97,14 +104,23 @@ bool FMUSlave::m_useDebugLogging = true;
 FMUSlave::FMUSlave(FMU * fmu, const std::string & name) :
 	AbstractSlave(name),
 	m_fmu(fmu),
-	m_component(nullptr)
+	m_recordedOutputsCached(false),
+	m_component(nullptr),
+	m_serializationState(nullptr)
 {
 	m_filepath = fmu->fmuFilePath();
+	// by default, retrieve all output variables of the FMU
+	m_boolValueRefsOutput = fmu->m_boolValueRefsOutput;
+	m_intValueRefsOutput = fmu->m_intValueRefsOutput;
+	m_stringValueRefsOutput = fmu->m_stringValueRefsOutput;
+	m_doubleValueRefsOutput = fmu->m_doubleValueRefsOutput;
+	partitionOutputs(nullptr);
 }
 
 
 FMUSlave::~FMUSlave() {
 	if (m_component != nullptr) {
+		freeState(&m_serializationState);
 		if (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1)
 			m_fmu->m_fmi1Functions.freeSlaveInstance(m_component);
 		else
@@ -113,6 +129,101 @@ FMUSlave::~FMUSlave() {
 }
 
 
+/*! Copies all value references from the FMU list that are selected by the filter or coupled. */
+static void selectValueRefs(const std::string & slaveName, const ModelDescription & modelDescription, FMIVariable::VarType t,
+							const OutputFilter & filter, const std::set< std::pair<FMIVariable::VarType, unsigned int> > & coupledVariables,
+							const std::vector<unsigned int> & fmuValueRefs, std::vector<unsigned int> & valueRefs)
+{
+	valueRefs.clear();
+	for (unsigned int i=0; i<fmuValueRefs.size(); ++i) {
+		unsigned int valueRef = fmuValueRefs[i];
+		if (coupledVariables.find(std::make_pair(t, valueRef)) != coupledVariables.end() ||
+			filter.matches(slaveName + "." + modelDescription.variableByRef(t, valueRef).m_name))
+		{
+			valueRefs.push_back(valueRef);
+		}
+	}
+}
+
+
+void FMUSlave::selectOutputs(const OutputFilter & filter, const std::set< std::pair<FMIVariable::VarType, unsigned int> > & coupledVariables) {
+	IBK_ASSERT(m_component == nullptr);
+	// without filter, keep all variables
+	if (!filter.empty()) {
+		const ModelDescription & modelDesc = m_fmu->m_modelDescription;
+		selectValueRefs(m_name, modelDesc, FMIVariable::VT_BOOL, filter, coupledVariables, m_fmu->m_boolValueRefsOutput, m_boolValueRefsOutput);
+		selectValueRefs(m_name, modelDesc, FMIVariable::VT_INT, filter, coupledVariables, m_fmu->m_intValueRefsOutput, m_intValueRefsOutput);
+		selectValueRefs(m_name, modelDesc, FMIVariable::VT_STRING, filter, coupledVariables, m_fmu->m_stringValueRefsOutput, m_stringValueRefsOutput);
+		selectValueRefs(m_name, modelDesc, FMIVariable::VT_DOUBLE, filter, coupledVariables, m_fmu->m_doubleValueRefsOutput, m_doubleValueRefsOutput);
+	}
+	partitionOutputs(&coupledVariables);
+}
+
+
+void FMUSlave::selectOutputs(const FMUSlave & other) {
+	IBK_ASSERT(m_component == nullptr && m_fmu == other.m_fmu);
+	m_boolValueRefsOutput = other.m_boolValueRefsOutput;
+	m_intValueRefsOutput = other.m_intValueRefsOutput;
+	m_stringValueRefsOutput = other.m_stringValueRefsOutput;
+	m_doubleValueRefsOutput = other.m_doubleValueRefsOutput;
+	for (unsigned int t=0; t<FMIVariable::NUM_VT; ++t) {
+		m_couplingOutputs[t] = other.m_couplingOutputs[t];
+		m_recordedOutputs[t] = other.m_recordedOutputs[t];
+	}
+	m_boolBuffer.resize(other.m_boolBuffer.size());
+	m_intBuffer.resize(other.m_intBuffer.size());
+	m_doubleBuffer.resize(other.m_doubleBuffer.size());
+}
+
+
+void FMUSlave::partitionOutputs(const std::set< std::pair<FMIVariable::VarType, unsigned int> > * coupledVariables) {
+	const std::vector<unsigned int> * valueRefs[FMIVariable::NUM_VT];
+	valueRefs[FMIVariable::VT_BOOL] = &m_boolValueRefsOutput;
+	valueRefs[FMIVariable::VT_INT] = &m_intValueRefsOutput;
+	valueRefs[FMIVariable::VT_STRING] = &m_stringValueRefsOutput;
+	valueRefs[FMIVariable::VT_DOUBLE] = &m_doubleValueRefsOutput;
+	for (unsigned int t=0; t<FMIVariable::NUM_VT; ++t) {
+		OutputSubset & coupling = m_couplingOutputs[t];
+		OutputSubset & recorded = m_recordedOutputs[t];
+		coupling = OutputSubset();
+		recorded = OutputSubset();
+		const std::vector<unsigned int> & refs = *valueRefs[t];
+		for (unsigned int i=0; i<refs.size(); ++i) {
+			bool coupled = (coupledVariables == nullptr ||
+							coupledVariables->find(std::make_pair((FMIVariable::VarType)t, refs[i])) != coupledVariables->end());
+			OutputSubset & subset = coupled ? coupling : recorded;
+			subset.m_valueRefs.push_back(refs[i]);
+			subset.m_indexes.push_back(i);
+		}
+	}
+	// buffers are only needed for subsets that do not contain all variables of their type
+	m_boolBuffer.resize(m_boolValueRefsOutput.size());
+	m_intBuffer.resize(m_intValueRefsOutput.size());
+	m_doubleBuffer.resize(m_doubleValueRefsOutput.size());
+	m_recordedOutputsCached = false;
+}
+
+
+unsigned int FMUSlave::localOutputIndex(FMIVariable::VarType t, unsigned int valueReference) const {
+	const std::vector<unsigned int> * valueRefs = nullptr;
+	switch (t) {
+		case FMIVariable::VT_BOOL	: valueRefs = &m_boolValueRefsOutput; break;
+		case FMIVariable::VT_INT	: valueRefs = &m_intValueRefsOutput; break;
+		case FMIVariable::VT_DOUBLE	: valueRefs = &m_doubleValueRefsOutput; break;
+		case FMIVariable::VT_STRING	: valueRefs = &m_stringValueRefsOutput; break;
+		case FMIVariable::NUM_VT : ; // just to remove compiler warning
+	}
+	if (valueRefs != nullptr) {
+		// search corresponding vector for valueReference and return index
+		for (unsigned int i=0; i<valueRefs->size(); ++i)
+			if ((*valueRefs)[i] == valueReference)
+				return i;
+	}
+	throw IBK::Exception( IBK::FormatString("Variable of type '%1' with value reference %2 is not an output of slave '%3'.")
+		.arg(FMIVariable::varType2String(t)).arg(valueReference).arg(m_name), "[FMUSlave::localOutputIndex]");
+}
+
+
 void FMUSlave::instantiate() {
 	if (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) {
 		m_component = m_fmu->m_fmi1Functions.instantiateSlave(
@@ -141,26 +252,26 @@ void FMUSlave::instantiate() {
 		throw IBK::Exception("Error instantiating slave.", "[FMUSlave::instantiateFMUSlave]");
 
 	// resize vectors
-	m_boolOutputs.resize(m_fmu->m_boolValueRefsOutput.size());
-	m_intOutputs.resize(m_fmu->m_intValueRefsOutput.size());
-	m_doubleOutputs.resize(m_fmu->m_doubleValueRefsOutput.size());
-	m_stringOutputs.resize(m_fmu->m_stringValueRefsOutput.size());
+	m_boolOutputs.resize(m_boolValueRefsOutput.size());
+	m_intOutputs.resize(m_intValueRefsOutput.size());
+	m_doubleOutputs.resize(m_doubleValueRefsOutput.size());
+	m_stringOutputs.resize(m_stringValueRefsOutput.size());
 
 	// compose variable names as they appear in the output file
-	for (unsigned int v=0; v<m_fmu->m_stringValueRefsOutput.size(); ++v) {
-		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_STRING, m_fmu->m_stringValueRefsOutput[v]);
+	for (unsigned int v=0; v<m_stringValueRefsOutput.size(); ++v) {
+		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_STRING, m_stringValueRefsOutput[v]);
 		m_stringVarNames.push_back(var.m_name);
 	}
-	for (unsigned int v=0; v<m_fmu->m_boolValueRefsOutput.size(); ++v) {
-		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_BOOL, m_fmu->m_boolValueRefsOutput[v]);
+	for (unsigned int v=0; v<m_boolValueRefsOutput.size(); ++v) {
+		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_BOOL, m_boolValueRefsOutput[v]);
 		m_boolVarNames.push_back(var.m_name);
 	}
-	for (unsigned int v=0; v<m_fmu->m_intValueRefsOutput.size(); ++v) {
-		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_INT, m_fmu->m_intValueRefsOutput[v]);
+	for (unsigned int v=0; v<m_intValueRefsOutput.size(); ++v) {
+		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_INT, m_intValueRefsOutput[v]);
 		m_intVarNames.push_back(var.m_name);
 	}
-	for (unsigned int v=0; v<m_fmu->m_doubleValueRefsOutput.size(); ++v) {
-		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_DOUBLE, m_fmu->m_doubleValueRefsOutput[v]);
+	for (unsigned int v=0; v<m_doubleValueRefsOutput.size(); ++v) {
+		const FMIVariable & var = m_fmu->m_modelDescription.variableByRef(FMIVariable::VT_DOUBLE, m_doubleValueRefsOutput[v]);
 		std::string unit = var.m_unit;
 		if (unit.empty())
 			unit = "-"; // no unit = undefined
@@ -244,6 +355,10 @@ void FMUSlave::currentState(fmi2FMUstate * state) const {
 
 
 void FMUSlave::setState(double t, fmi2FMUstate slaveState) {
+	if (m_stateless) {
+		m_t = t;
+		return;
+	}
 	if (m_fmu->m_fmi2Functions.setFMUstate(m_component, slaveState) != fmi2OK) {
 		throw IBK::Exception(IBK::FormatString("Failed setting FMU state in slave '%1'.").arg(m_name), "[FMUSlave::setState]");
 	}
@@ -251,67 +366,190 @@ void FMUSlave::setState(double t, fmi2FMUstate slaveState) {
 }
 
 
+bool FMUSlave::canBeCopied() const {
+	const ModelDescription & modelDesc = m_fmu->m_modelDescription;
+	return !(modelDesc.m_fmuType & ModelDescription::CS_v1) &&
+			modelDesc.m_canGetAndSetFMUstate &&
+			modelDesc.m_canSerializeFMUstate &&
+			!modelDesc.m_canBeInstantiatedOnlyOncePerProcess;
+}
+
+
+void FMUSlave::serializeState(fmi2FMUstate state, std::vector<char> & data) const {
+	const char * const FUNC_ID = "[FMUSlave::serializeState]";
+	IBK_ASSERT(m_fmu->m_modelDescription.m_canSerializeFMUstate);
+
+	size_t size = 0;
+	if (m_fmu->m_fmi2Functions.serializedFMUstateSize(m_component, state, &size) != fmi2OK)
+		throw IBK::Exception(IBK::FormatString("Failed getting size of serialized FMU state from slave '%1'.").arg(m_name), FUNC_ID);
+	data.resize(size);
+	if (size == 0)
+		return;
+	if (m_fmu->m_fmi2Functions.serializeFMUstate(m_component, state, reinterpret_cast<fmi2Byte*>(&data[0]), size) != fmi2OK)
+		throw IBK::Exception(IBK::FormatString("Failed serializing FMU state of slave '%1'.").arg(m_name), FUNC_ID);
+}
+
+
+void FMUSlave::deserializeState(const std::vector<char> & data, fmi2FMUstate * state) {
+	const char * const FUNC_ID = "[FMUSlave::deserializeState]";
+	IBK_ASSERT(m_fmu->m_modelDescription.m_canSerializeFMUstate);
+
+	freeState(state);
+	if (m_fmu->m_fmi2Functions.deSerializeFMUstate(m_component, reinterpret_cast<const fmi2Byte*>(data.data()), data.size(), state) != fmi2OK)
+		throw IBK::Exception(IBK::FormatString("Failed de-serializing FMU state in slave '%1'.").arg(m_name), FUNC_ID);
+}
+
+
+void FMUSlave::freeState(fmi2FMUstate * state) {
+	if (*state == nullptr)
+		return;
+	if (m_fmu->m_fmi2Functions.freeFMUstate(m_component, state) != fmi2OK)
+		IBK::IBK_Message(IBK::FormatString("Failed releasing FMU state of slave '%1'.\n").arg(m_name), IBK::MSG_WARNING, "[FMUSlave::freeState]", IBK::VL_STANDARD);
+	*state = nullptr;
+}
+
+
+void FMUSlave::serializeCurrentState(std::vector<char> & data) const {
+	const char * const FUNC_ID = "[FMUSlave::serializeCurrentState]";
+	if (m_stateless) {
+		data.clear(); // nothing to store
+		return;
+	}
+	const ModelDescription & modelDesc = m_fmu->m_modelDescription;
+	if ((modelDesc.m_fmuType & ModelDescription::CS_v1) || !modelDesc.m_canGetAndSetFMUstate || !modelDesc.m_canSerializeFMUstate)
+		throw IBK::Exception(IBK::FormatString("Slave '%1' does not support serialization of FMU state.").arg(m_name), FUNC_ID);
+
+	// the FMU state is kept and updated in place in subsequent calls
+	currentState(&m_serializationState);
+	serializeState(m_serializationState, data);
+}
+
+
+void FMUSlave::restoreSerializedState(double t, const std::vector<char> & data) {
+	const char * const FUNC_ID = "[FMUSlave::restoreSerializedState]";
+	if (m_stateless) {
+		setState(t, nullptr);
+		cacheOutputs();
+		return;
+	}
+	const ModelDescription & modelDesc = m_fmu->m_modelDescription;
+	if ((modelDesc.m_fmuType & ModelDescription::CS_v1) || !modelDesc.m_canGetAndSetFMUstate || !modelDesc.m_canSerializeFMUstate)
+		throw IBK::Exception(IBK::FormatString("Slave '%1' does not support serialization of FMU state.").arg(m_name), FUNC_ID);
+
+	fmi2FMUstate state = nullptr;
+	deserializeState(data, &state);
+	try {
+		setState(t, state);
+	}
+	catch (...) {
+		freeState(&state);
+		throw;
+	}
+	freeState(&state);
+	cacheOutputs();
+}
+
+
 void FMUSlave::cacheOutputs() {
-	const char * const FUNC_ID = "[FMUSlave::cacheOutputs]";
+	retrieveOutputs(m_couplingOutputs);
+	// slave state has changed, other outputs are retrieved again when needed
+	m_recordedOutputsCached = false;
+}
+
+
+void FMUSlave::cacheRecordedOutputs() {
+	if (m_recordedOutputsCached)
+		return;
+	retrieveOutputs(m_recordedOutputs);
+	m_recordedOutputsCached = true;
+}
+
+
+void FMUSlave::retrieveOutputs(const OutputSubset * subsets) {
+	const char * const FUNC_ID = "[FMUSlave::retrieveOutputs]";
+	const OutputSubset & bools = subsets[FMIVariable::VT_BOOL];
+	const OutputSubset & ints = subsets[FMIVariable::VT_INT];
+	const OutputSubset & doubles = subsets[FMIVariable::VT_DOUBLE];
+	const OutputSubset & strings = subsets[FMIVariable::VT_STRING];
+	// if a subset holds all variables of a type, values are retrieved directly into the output vector,
+	// otherwise into a buffer and copied afterwards
+	const bool directBools = (bools.m_indexes.size() == m_boolOutputs.size());
+	const bool directInts = (ints.m_indexes.size() == m_intOutputs.size());
+	const bool directDoubles = (doubles.m_indexes.size() == m_doubleOutputs.size());
 	int res = fmi2OK;
 	if (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) {
 		// booleans must be converted one-by-one for FMI 1
-		for (unsigned int i=0; i<m_fmu->m_boolValueRefsOutput.size(); ++i) {
+		for (unsigned int i=0; i<bools.m_valueRefs.size(); ++i) {
 			fmiBoolean boolValue;
-			res = m_fmu->m_fmi1Functions.getBoolean(m_component, &m_fmu->m_boolValueRefsOutput[i], 1, &boolValue);
-			m_boolOutputs[i] = (boolValue == fmiTrue);
+			res = m_fmu->m_fmi1Functions.getBoolean(m_component, &bools.m_valueRefs[i], 1, &boolValue);
+			m_boolOutputs[bools.m_indexes[i]] = (boolValue == fmiTrue);
 		}
-		if (!m_fmu->m_intValueRefsOutput.empty()) {
-			res = m_fmu->m_fmi1Functions.getInteger(m_component, &m_fmu->m_intValueRefsOutput[0],
-					m_fmu->m_intValueRefsOutput.size(), &m_intOutputs[0]);
+		if (!ints.m_valueRefs.empty()) {
+			res = m_fmu->m_fmi1Functions.getInteger(m_component, &ints.m_valueRefs[0],
+					ints.m_valueRefs.size(), directInts ? &m_intOutputs[0] : &m_intBuffer[0]);
 		}
-		if (!m_fmu->m_doubleValueRefsOutput.empty()) {
-			res = m_fmu->m_fmi1Functions.getReal(m_component, &m_fmu->m_doubleValueRefsOutput[0],
-					m_fmu->m_doubleValueRefsOutput.size(), &m_doubleOutputs[0]);
+		if (!doubles.m_valueRefs.empty()) {
+			res = m_fmu->m_fmi1Functions.getReal(m_component, &doubles.m_valueRefs[0],
+					doubles.m_valueRefs.size(), directDoubles ? &m_doubleOutputs[0] : &m_doubleBuffer[0]);
 		}
 		// strings are queried one-by-one
-		for (unsigned int i=0; i<m_fmu->m_stringValueRefsOutput.size(); ++i) {
+		for (unsigned int i=0; i<strings.m_valueRefs.size(); ++i) {
 			const char * str;
-			res = m_fmu->m_fmi1Functions.getString(m_component, &m_fmu->m_stringValueRefsOutput[i], 1, &str);
+			res = m_fmu->m_fmi1Functions.getString(m_component, &strings.m_valueRefs[i], 1, &str);
 			if (res != fmi2OK) break;
 			IBK_ASSERT(str != nullptr);
-			m_stringOutputs[i] = std::string(str);
+			m_stringOutputs[strings.m_indexes[i]] = std::string(str);
 		}
 	}
 	else {
-		if (!m_fmu->m_boolValueRefsOutput.empty()) {
-			res = m_fmu->m_fmi2Functions.getBoolean(m_component, &m_fmu->m_boolValueRefsOutput[0],
-					m_fmu->m_boolValueRefsOutput.size(), &m_boolOutputs[0]);
+		if (!bools.m_valueRefs.empty()) {
+			res = m_fmu->m_fmi2Functions.getBoolean(m_component, &bools.m_valueRefs[0],
+					bools.m_valueRefs.size(), directBools ? &m_boolOutputs[0] : &m_boolBuffer[0]);
 		}
-		if (!m_fmu->m_intValueRefsOutput.empty()) {
-			res = m_fmu->m_fmi2Functions.getInteger(m_component, &m_fmu->m_intValueRefsOutput[0],
-					m_fmu->m_intValueRefsOutput.size(), &m_intOutputs[0]);
+		if (!ints.m_valueRefs.empty()) {
+			res = m_fmu->m_fmi2Functions.getInteger(m_component, &ints.m_valueRefs[0],
+					ints.m_valueRefs.size(), directInts ? &m_intOutputs[0] : &m_intBuffer[0]);
 		}
-		if (!m_fmu->m_doubleValueRefsOutput.empty()) {
-			res = m_fmu->m_fmi2Functions.getReal(m_component, &m_fmu->m_doubleValueRefsOutput[0],
-					m_fmu->m_doubleValueRefsOutput.size(), &m_doubleOutputs[0]);
-			for (unsigned int i=0; i<m_fmu->m_doubleValueRefsOutput.size(); ++i) {
+		if (!doubles.m_valueRefs.empty()) {
+			double * values = directDoubles ? &m_doubleOutputs[0] : &m_doubleBuffer[0];
+			res = m_fmu->m_fmi2Functions.getReal(m_component, &doubles.m_valueRefs[0],
+					doubles.m_valueRefs.size(), values);
+			for (unsigned int i=0; i<doubles.m_valueRefs.size(); ++i) {
 				IBK_FastMessage(IBK::VL_DEVELOPER)(IBK::FormatString("MASTER: realOutput from slave %1, idx %2: value=%3\n")
-												   .arg(m_name).arg(m_fmu->m_doubleValueRefsOutput[i]).arg(m_doubleOutputs[i], 0, 'g', 12),
+												   .arg(m_name).arg(doubles.m_valueRefs[i]).arg(values[i], 0, 'g', 12),
 												   IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_DEVELOPER);
 			}
 		}
 		// strings are queried one-by-one
-		for (unsigned int i=0; i<m_fmu->m_stringValueRefsOutput.size(); ++i) {
+		for (unsigned int i=0; i<strings.m_valueRefs.size(); ++i) {
 			const char * str = nullptr;
-			res = m_fmu->m_fmi2Functions.getString(m_component, &m_fmu->m_stringValueRefsOutput[i], 1, &str);
+			res = m_fmu->m_fmi2Functions.getString(m_component, &strings.m_valueRefs[i], 1, &str);
 			if (res != fmi2OK) break;
 			if (str == nullptr) {
 				IBK::IBK_Message(IBK::FormatString("Slave '%1' returned null-ptr as string for requested variable/parameter with value ref #%2." )
-								 .arg(m_fmu->m_modelDescription.m_modelName).arg(m_fmu->m_stringValueRefsOutput[i]), IBK::MSG_ERROR, FUNC_ID, IBK::VL_STANDARD);
+								 .arg(m_fmu->m_modelDescription.m_modelName).arg(strings.m_valueRefs[i]), IBK::MSG_ERROR, FUNC_ID, IBK::VL_STANDARD);
 				res = fmi2Error;
 				break;
 			}
 			else
-				m_stringOutputs[i] = std::string(str);
+				m_stringOutputs[strings.m_indexes[i]] = std::string(str);
 		}
 	}
 	if (res != fmi2OK)	throw IBK::Exception("Error retrieving values from slave.", FUNC_ID);
+
+	// copy buffered values to their positions in the output vectors
+	if (!directBools && !(m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1)) {
+		for (unsigned int i=0; i<bools.m_indexes.size(); ++i)
+			m_boolOutputs[bools.m_indexes[i]] = m_boolBuffer[i];
+	}
+	if (!directInts) {
+		for (unsigned int i=0; i<ints.m_indexes.size(); ++i)
+			m_intOutputs[ints.m_indexes[i]] = m_intBuffer[i];
+	}
+	if (!directDoubles) {
+		for (unsigned int i=0; i<doubles.m_indexes.size(); ++i)
+			m_doubleOutputs[doubles.m_indexes[i]] = m_doubleBuffer[i];
+	}
 }
 
 
@@ -373,6 +611,78 @@ void FMUSlave::setString(unsigned int valueReference, const std::string & str) {
 }
 
 
+void FMUSlave::setReals(const unsigned int * valueReferences, const double * values, unsigned int count) {
+	if (count == 0)
+		return;
+	int res;
+	if (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) {
+		res = m_fmu->m_fmi1Functions.setReal(m_component, valueReferences, count, values);
+	}
+	else {
+		res = m_fmu->m_fmi2Functions.setReal(m_component, valueReferences, count, values);
+	}
+	if (res != fmi2OK) {
+		throw IBK::Exception("Error setting input variables.", "[FMUSlave::setReals]");
+	}
+}
+
+
+void FMUSlave::setIntegers(const unsigned int * valueReferences, const int * values, unsigned int count) {
+	if (count == 0)
+		return;
+	int res;
+	if (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) {
+		res = m_fmu->m_fmi1Functions.setInteger(m_component, valueReferences, count, values);
+	}
+	else {
+		res = m_fmu->m_fmi2Functions.setInteger(m_component, valueReferences, count, values);
+	}
+	if (res != fmi2OK) {
+		throw IBK::Exception("Error setting input variables.", "[FMUSlave::setIntegers]");
+	}
+}
+
+
+void FMUSlave::setBooleans(const unsigned int * valueReferences, const fmi2Boolean * values, unsigned int count) {
+	if (count == 0)
+		return;
+	int res;
+	if (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) {
+		// booleans must be converted for FMI 1
+		m_fmi1BoolBuffer.resize(count);
+		for (unsigned int i=0; i<count; ++i)
+			m_fmi1BoolBuffer[i] = (values[i] == fmi2True) ? fmiTrue : fmiFalse;
+		res = m_fmu->m_fmi1Functions.setBoolean(m_component, valueReferences, count, &m_fmi1BoolBuffer[0]);
+	}
+	else {
+		res = m_fmu->m_fmi2Functions.setBoolean(m_component, valueReferences, count, values);
+	}
+	if (res != fmi2OK) {
+		throw IBK::Exception("Error setting input variables.", "[FMUSlave::setBooleans]");
+	}
+}
+
+
+bool FMUSlave::providesDirectionalDerivatives() const {
+	return (m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v2) &&
+			!(m_fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) &&
+			m_fmu->m_modelDescription.m_providesDirectionalDerivative;
+}
+
+
+int FMUSlave::getDirectionalDerivatives(const unsigned int * outputIndexes, unsigned int nOutputs,
+										const unsigned int * inputValueReferences, unsigned int nInputs,
+										const double * seed, double * derivatives)
+{
+	IBK_ASSERT(providesDirectionalDerivatives());
+	m_derivativeValueRefBuffer.resize(nOutputs);
+	for (unsigned int i=0; i<nOutputs; ++i)
+		m_derivativeValueRefBuffer[i] = m_doubleValueRefsOutput[outputIndexes[i]];
+	return m_fmu->m_fmi2Functions.getDirectionalDerivative(m_component, &m_derivativeValueRefBuffer[0], nOutputs,
+														   inputValueReferences, nInputs, seed, derivatives);
+}
+
+
 void FMUSlave::setValue(const FMIVariable & var, const std::string & value) {
 	// convert value into type
 	switch (var.m_type) {
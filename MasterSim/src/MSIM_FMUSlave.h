@@ -1,11 +1,14 @@
 #ifndef MSIM_FMUSLAVE_H
 #define MSIM_FMUSLAVE_H
 
+#include <set>
+
 #include "MSIM_AbstractSlave.h"
 
 namespace MASTER_SIM {
 
 class FMU;
+class OutputFilter;
 
 /*! Holds data for a simulation slave, that is a single instance of an FMU.
 	Mind that there may be several slaves instantiated by a single FMU.
@@ -18,6 +21,27 @@ public:
 	/*! Destructor, frees instance and cleans up memory. */
 	~FMUSlave();
 
+	/*! Selects the variables retrieved from the output variables of the FMU.
+		A variable is kept if its flat name (<slave name>.<variable name>) is selected by the filter, or if it is
+		needed for a connection. Variables needed for connections are retrieved in cacheOutputs() after each step,
+		all others only in cacheRecordedOutputs(). Without call to this function, all output variables of the
+		FMU are retrieved in cacheOutputs().
+		Must be called before instantiate().
+		\param filter Output filter.
+		\param coupledVariables Type and value reference of all variables of this slave used as connection outputs.
+	*/
+	void selectOutputs(const OutputFilter & filter, const std::set< std::pair<FMIVariable::VarType, unsigned int> > & coupledVariables);
+
+	/*! Selects the same output variables as another slave of the same FMU (used for copies of slaves).
+		Must be called before instantiate().
+	*/
+	void selectOutputs(const FMUSlave & other);
+
+	/*! Returns the index of the referenced variable in the corresponding vector with output values (m_xxxOutputs).
+		Throws an IBK::Exception if the variable is not retrieved by this slave.
+	*/
+	unsigned int localOutputIndex(FMIVariable::VarType t, unsigned int valueReference) const;
+
 	/*! Calls FMU instantiation function to create this simulation slave.
 		This function essentially populates the m_components pointer.
 	*/
@@ -44,9 +68,40 @@ public:
 	/*! Sets the state of the FMU (roll-back to recorded state). */
 	void setState(double t, fmi2FMUstate slaveState) override;
 
-	/*! Retrieve all output quantities from slave and store in local vectors. */
+	/*! Retrieve output quantities needed for connections from slave and store in local vectors. */
 	void cacheOutputs() override;
 
+	/*! Retrieve all other output quantities from slave, unless already done for the current slave state. */
+	void cacheRecordedOutputs() override;
+
+	/*! Serializes the current state of the slave into a byte array. */
+	void serializeCurrentState(std::vector<char> & data) const override;
+
+	/*! Restores the slave state from data created by serializeCurrentState(). */
+	void restoreSerializedState(double t, const std::vector<char> & data) override;
+
+	/*! Returns true, if additional instances of this slave can be created and synchronized with
+		this slave via serialized FMU states (FMI 2 slaves with capabilities canGetAndSetFMUstate and
+		canSerializeFMUstate, which can be instantiated more than once per process).
+	*/
+	bool canBeCopied() const;
+
+	/*! Serializes the given FMU state of this slave into a byte array.
+		\param state FMU state obtained via currentState().
+		\param data Byte array, resized in function.
+	*/
+	void serializeState(fmi2FMUstate state, std::vector<char> & data) const;
+
+	/*! Creates an FMU state of this slave from serialized data (may have been serialized by another
+		instance of the same FMU).
+		\param data Serialized state.
+		\param state FMU state, a previously allocated state is released first.
+	*/
+	void deserializeState(const std::vector<char> & data, fmi2FMUstate * state);
+
+	/*! Releases an FMU state obtained via currentState() or deserializeState() and sets it to nullptr. */
+	void freeState(fmi2FMUstate * state) override;
+
 	/*! Pointer to the FMU object that instantiated this slave. */
 	const FMU			* fmu() const { return m_fmu; }
 
@@ -74,6 +129,25 @@ public:
 	*/
 	void setString(unsigned int valueReference, const std::string & str) override;
 
+	/*! Sets several input variables of type real in the slave with a single call to fmiSetReal or fmi2SetReal. */
+	void setReals(const unsigned int * valueReferences, const double * values, unsigned int count) override;
+
+	/*! Sets several input variables of type int in the slave with a single call to fmiSetInteger or fmi2SetInteger. */
+	void setIntegers(const unsigned int * valueReferences, const int * values, unsigned int count) override;
+
+	/*! Sets several input variables of type bool in the slave with a single call to fmiSetBoolean or fmi2SetBoolean.
+		For FMI 1 slaves, values are converted to fmiBoolean first.
+	*/
+	void setBooleans(const unsigned int * valueReferences, const fmi2Boolean * values, unsigned int count) override;
+
+	/*! Returns true for FMI 2 slaves with providesDirectionalDerivative capability. */
+	bool providesDirectionalDerivatives() const override;
+
+	/*! Computes directional derivatives with a single call to fmi2GetDirectionalDerivative. */
+	int getDirectionalDerivatives(const unsigned int * outputIndexes, unsigned int nOutputs,
+								  const unsigned int * inputValueReferences, unsigned int nInputs,
+								  const double * seed, double * derivatives) override;
+
 	/*! Convenience function for setting a variable of type defined by FMIVariable.
 		\param var The variable holding type and value reference.
 		\param value The value as string, will be decoded into the corresponding type.
@@ -87,13 +161,59 @@ public:
 	static bool					m_useDebugLogging;
 
 private:
+	/*! Value references and positions in the output vectors (m_xxxOutputs) of a subset of the output variables of one type. */
+	struct OutputSubset {
+		/*! Value references passed to the get-functions of the FMU. */
+		std::vector<unsigned int>	m_valueRefs;
+		/*! Indexes of variables in output vector, ascending. */
+		std::vector<unsigned int>	m_indexes;
+	};
+
+	/*! Splits output variables into variables needed for connections and variables only needed for outputs.
+		\param coupledVariables Type and value reference of coupled variables, if nullptr, all variables are treated as coupled.
+	*/
+	void partitionOutputs(const std::set< std::pair<FMIVariable::VarType, unsigned int> > * coupledVariables);
+
+	/*! Retrieves values of output variables and stores them in the output vectors.
+		\param subsets Array with subsets of output variables, indexed by FMIVariable::VarType.
+	*/
+	void retrieveOutputs(const OutputSubset * subsets);
 
 	/*! Pointer to the FMU object that instantiated this slave. */
 	FMU			*m_fmu;
 
+	// Value references of variables retrieved in cacheOutputs(), subset of the corresponding lists in the FMU.
+
+	std::vector<unsigned int>	m_boolValueRefsOutput;
+	std::vector<unsigned int>	m_intValueRefsOutput;
+	std::vector<unsigned int>	m_stringValueRefsOutput;
+	std::vector<unsigned int>	m_doubleValueRefsOutput;
+
+	/*! Output variables needed for connections, retrieved in cacheOutputs(). */
+	OutputSubset				m_couplingOutputs[FMIVariable::NUM_VT];
+	/*! Output variables only needed for result files, retrieved in cacheRecordedOutputs(). */
+	OutputSubset				m_recordedOutputs[FMIVariable::NUM_VT];
+	/*! True, if values of m_recordedOutputs have been retrieved since last change of the slave state. */
+	bool						m_recordedOutputsCached;
+
+	// Buffers for values of output subsets that do not contain all variables of a type.
+
+	std::vector<fmi2Boolean>	m_boolBuffer;
+	std::vector<int>			m_intBuffer;
+	std::vector<double>			m_doubleBuffer;
+
 	/*! Component pointer returned by instantiation function of FMU. */
 	void		*m_component;
 
+	/*! FMU state used in serializeCurrentState(), allocated on first use and updated in place afterwards. */
+	mutable fmi2FMUstate	m_serializationState;
+
+	/*! Buffer for converted boolean values passed to fmiSetBoolean (FMI 1 only). */
+	std::vector<fmiBoolean>	m_fmi1BoolBuffer;
+
+	/*! Buffer for value references of outputs passed to fmi2GetDirectionalDerivative. */
+	std::vector<unsigned int>	m_derivativeValueRefBuffer;
+
 	/*! Structure with function pointers to required call back functions. */
 	static	fmiCallbackFunctions	m_fmiCallBackFunctions;
 	/*! Structure with function pointers to required call back functions. */
@@ -12,6 +12,7 @@
 #include <cstdarg>
 #include <cstdio>
 #include <fstream>
+#include <algorithm>
 
 #include "MSIM_FMU.h"
 
@@ -19,7 +20,8 @@ namespace MASTER_SIM {
 
 FileReaderSlave::FileReaderSlave(const IBK::Path & filepath, const std::string & name) :
 	AbstractSlave(name),
-	m_fileReader(new IBK::CSVReader)
+	m_fileReader(new IBK::CSVReader),
+	m_timeIndex(0)
 {
 	m_filepath = filepath;
 }
@@ -137,6 +139,7 @@ void FileReaderSlave::enterInitializationMode() {
 			}
 			try {
 				m_valueSplines[j]->setValues(tVec, yVec);
+				m_timePoints = m_valueSplines[j]->x(); // same for all columns
 			} catch (IBK::Exception & ex) {
 				throw IBK::Exception(ex, IBK::FormatString("Invalid interpolation table data in column '%2' in file '%3'. Error during initialization of slave '%1'")
 									 .arg(m_name).arg(m_fileReader->m_captions[j+1]).arg(m_filepath), FUNC_ID);
@@ -172,7 +175,60 @@ void FileReaderSlave::currentState(fmi2FMUstate * /*state*/) const {
 
 
 void FileReaderSlave::setState(double t, fmi2FMUstate /*slaveState*/) {
-	m_t = t;
+	m_t = t; // m_timeIndex is kept, the next lookup starts from the current position
+}
+
+
+void FileReaderSlave::serializeCurrentState(std::vector<char> & data) const {
+	// the state of the file reader is defined by the time point alone, which is stored by the master
+	data.clear();
+}
+
+
+void FileReaderSlave::restoreSerializedState(double t, const std::vector<char> & /*data*/) {
+	setState(t, nullptr);
+	cacheOutputs();
+}
+
+
+/*! Linearly interpolated value at time t, identical to IBK::LinearSpline::value() with constant extrapolation.
+	\param i Index of first time point >= t.
+*/
+static double interpolatedValue(const std::vector<double> & x, const std::vector<double> & y, unsigned int i, double t) {
+	if (x.size() == 1 || i == x.size())
+		return y.back();
+	if (i == 0)
+		return y.front();
+	double alpha = (t - x[i-1])/(x[i]-x[i-1]);
+	return y[i-1]*(1-alpha) + y[i]*alpha;
+}
+
+
+/*! Step-wise constant value at time t, identical to IBK::LinearSpline::nonInterpolatedValue().
+	\param i Index of first time point >= t.
+*/
+static double nonInterpolatedValue(const std::vector<double> & x, const std::vector<double> & y, unsigned int i, double t) {
+	if (x.size() == 1 || i == x.size())
+		return y.back();
+	if (i == 0 || x[i] == t)
+		return y[i];
+	return y[i-1];
+}
+
+
+void FileReaderSlave::updateTimeIndex() {
+	// search linearly from the last position for small forward/backward moves, otherwise use bisection
+	const unsigned int MAX_LINEAR_STEPS = 8;
+	unsigned int n = (unsigned int)m_timePoints.size();
+	unsigned int i = std::min(m_timeIndex, n);
+	unsigned int steps = 0;
+	while (i < n && m_timePoints[i] < m_t && ++steps <= MAX_LINEAR_STEPS)
+		++i;
+	while (i > 0 && m_timePoints[i-1] >= m_t && ++steps <= MAX_LINEAR_STEPS)
+		--i;
+	if (steps > MAX_LINEAR_STEPS)
+		i = (unsigned int)(std::lower_bound(m_timePoints.begin(), m_timePoints.end(), m_t) - m_timePoints.begin());
+	m_timeIndex = i;
 }
 
 
@@ -180,20 +236,25 @@ void FileReaderSlave::cacheOutputs() {
 	const char * const FUNC_ID = "[FileReaderSlave::cacheOutputs]";
 	int res = fmi2OK;
 
+	updateTimeIndex();
+
 	// transfer values by type
 	for (unsigned int j=0; j<m_columnVariableTypes.size(); ++j) {
 		switch (m_columnVariableTypes[j]) {
 			case MASTER_SIM::FMIVariable::VT_DOUBLE :
 				IBK_ASSERT(m_columnVariableOutputVectorIndex[j] != (unsigned int)-1);
-				m_doubleOutputs[ m_columnVariableOutputVectorIndex[j] ] = m_valueSplines[j]->value(m_t);
+				m_doubleOutputs[ m_columnVariableOutputVectorIndex[j] ] =
+						interpolatedValue(m_timePoints, m_valueSplines[j]->y(), m_timeIndex, m_t);
 			break;
 			case MASTER_SIM::FMIVariable::VT_INT :
 				IBK_ASSERT(m_columnVariableOutputVectorIndex[j] != (unsigned int)-1);
-				m_intOutputs[ m_columnVariableOutputVectorIndex[j] ] = (int)m_valueSplines[j]->nonInterpolatedValue(m_t);
+				m_intOutputs[ m_columnVariableOutputVectorIndex[j] ] =
+						(int)nonInterpolatedValue(m_timePoints, m_valueSplines[j]->y(), m_timeIndex, m_t);
 			break;
 			case MASTER_SIM::FMIVariable::VT_BOOL :
 				IBK_ASSERT(m_columnVariableOutputVectorIndex[j] != (unsigned int)-1);
-				m_boolOutputs[ m_columnVariableOutputVectorIndex[j] ] = (bool)m_valueSplines[j]->nonInterpolatedValue(m_t);
+				m_boolOutputs[ m_columnVariableOutputVectorIndex[j] ] =
+						(bool)nonInterpolatedValue(m_timePoints, m_valueSplines[j]->y(), m_timeIndex, m_t);
 			break;
 			case MASTER_SIM::FMIVariable::VT_STRING : break; // TODO : later store string variables
 			case MASTER_SIM::FMIVariable::NUM_VT : break; // nothing to do
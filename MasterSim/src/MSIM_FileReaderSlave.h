@@ -47,9 +47,18 @@ public:
 	/*! Sets the state of the FMU (roll-back to recorded state). */
 	void setState(double t, fmi2FMUstate slaveState) override;
 
+	/*! Nothing to release, the file reader does not create states. */
+	void freeState(fmi2FMUstate * state) override { *state = nullptr; }
+
 	/*! Retrieve all output quantities from slave and store in local vectors. */
 	void cacheOutputs() override;
 
+	/*! Serializes the current state of the slave into a byte array. */
+	void serializeCurrentState(std::vector<char> & data) const override;
+
+	/*! Restores the slave state from data created by serializeCurrentState(). */
+	void restoreSerializedState(double t, const std::vector<char> & data) override;
+
 	/*! Sets an input variable of type real in the slave.
 		This is essentially a wrapper function around fmiSetReal or fmi2SetReal, depending on the
 		standard supported by the FMU.
@@ -74,12 +83,32 @@ public:
 	*/
 	void setString(unsigned int /*valueReference*/, const std::string & /*str*/) override {}
 
+	/*! Sets several input variables of type real in the slave (no inputs in file reader slaves). */
+	void setReals(const unsigned int * /*valueReferences*/, const double * /*values*/, unsigned int /*count*/) override {}
+
+	/*! Sets several input variables of type int in the slave (no inputs in file reader slaves). */
+	void setIntegers(const unsigned int * /*valueReferences*/, const int * /*values*/, unsigned int /*count*/) override {}
+
+	/*! Sets several input variables of type bool in the slave (no inputs in file reader slaves). */
+	void setBooleans(const unsigned int * /*valueReferences*/, const fmi2Boolean * /*values*/, unsigned int /*count*/) override {}
+
+	/*! File reader slaves have no inputs, hence no derivatives. */
+	bool providesDirectionalDerivatives() const override { return false; }
+
+	/*! File reader slaves have no inputs, hence no derivatives. */
+	int getDirectionalDerivatives(const unsigned int * /*outputIndexes*/, unsigned int /*nOutputs*/,
+								  const unsigned int * /*inputValueReferences*/, unsigned int /*nInputs*/,
+								  const double * /*seed*/, double * /*derivatives*/) override { return fmi2Error; }
+
 	/*! Convenience function for setting a variable of type defined by FMIVariable.
 		\param var The variable holding type and value reference.
 		\param value The value as string, will be decoded into the corresponding type.
 	*/
 	void setValue(const FMIVariable & /*var*/, const std::string & /*value*/) override {}
 
+	/*! Values depend only on time, a roll-back only resets the time point. */
+	bool isStateless() const override { return true; }
+
 	/*! Variables names for quantities that are not yet assigned a type (done based on connection). */
 	std::vector<std::string>	m_typelessVarNames;
 	/*! Units for quantities, to be appended when writing output files as ' [unit]' text. */
@@ -106,9 +135,18 @@ public:
 	std::vector<unsigned int>						m_columnVariableOutputVectorIndex;
 
 private:
+	/*! Updates m_timeIndex for the current time point, the search starts at the previous position. */
+	void updateTimeIndex();
 
 	IBK::CSVReader					*m_fileReader;
 	std::vector<IBK::LinearSpline*>	m_valueSplines;
+
+	/*! Time points of all splines (identical for all columns), in seconds. */
+	std::vector<double>				m_timePoints;
+	/*! Index of first time point >= m_t (m_timePoints.size() if m_t is past the last time point).
+		The index is kept across steps and roll-backs, so that the lookup is usually done in a few comparisons.
+	*/
+	unsigned int					m_timeIndex;
 };
 
 } // namespace MASTER_SIM
@@ -4,6 +4,9 @@
 #include <cmath>
 #include <fstream>
 #include <algorithm> // for min and max
+#include <cstring> // for memcmp
+#include <set>
+#include <map>
 
 #include <chrono>
 #include <thread>
@@ -23,6 +26,8 @@
 #include "MSIM_AlgorithmGaussJacobi.h"
 #include "MSIM_AlgorithmGaussSeidel.h"
 #include "MSIM_AlgorithmNewton.h"
+#include "MSIM_SlaveGraph.h"
+#include "MSIM_OutputFilter.h"
 
 namespace MASTER_SIM {
 
@@ -87,9 +92,21 @@ void MasterSim::initialize() {
 	// collect all output and input variables from all slaves, ordered according to cycles
 	composeVariableVector();
 
+	// determine which cycles exchange variables with each other
+	setupCycleDependencies();
+
+	// start worker threads, if parallel evaluation of slaves is requested
+	if (m_project.m_threadCount > 1) {
+		IBK::IBK_Message(IBK::FormatString("Starting thread pool with %1 threads\n").arg(m_project.m_threadCount), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+		m_threadPool.start(m_project.m_threadCount);
+	}
+
 	// select master algorithm
 	initMasterAlgorithm();
 
+	// determine which slave states need to be stored before each step
+	setupStateCapture();
+
 	// sets up default parameters like ResultsRootDir
 	setupDefaultParameters();
 
@@ -125,6 +142,11 @@ void MasterSim::initialize() {
 	m_statErrorTestTime = 0;
 	m_statStepCounter = 0;
 	m_statAlgorithmCallCounter = 0;
+	m_statCheckpointTime = 0;
+	m_statCheckpointCounter = 0;
+	m_statSnapshotTime = 0;
+	m_statSnapshotCounter = 0;
+	m_snapshots.setMemoryLimit((size_t)m_project.m_snapshotMemoryLimit*1024*1024);
 
 	m_acceptedErrRichardson = 1;
 	m_acceptedErrSlopeCheck = 1;
@@ -136,33 +158,405 @@ void MasterSim::openOutputFiles(bool reopen) {
 }
 
 
-void MasterSim::restoreState(double /*t*/, const IBK::Path & /*stateDirectory*/) {
-	// all FMUs must be able to restore state!
+/*! Version of checkpoint data format, increase whenever the content of checkpoint files changes. */
+static const unsigned int CHECKPOINT_VERSION = 8;
+
+/*! Appends binary representation of a value to the checkpoint buffer. */
+template <typename T>
+static void appendBinary(std::vector<char> & buffer, const T & val) {
+	const char * p = reinterpret_cast<const char *>(&val);
+	buffer.insert(buffer.end(), p, p + sizeof(T));
+}
+
+/*! Appends size and content of a vector with POD data to the checkpoint buffer. */
+template <typename T>
+static void appendBinary(std::vector<char> & buffer, const std::vector<T> & vec) {
+	appendBinary(buffer, (uint64_t)vec.size());
+	if (vec.empty())
+		return;
+	const char * p = reinterpret_cast<const char *>(&vec[0]);
+	buffer.insert(buffer.end(), p, p + vec.size()*sizeof(T));
+}
+
+static void appendBinary(std::vector<char> & buffer, const std::string & str) {
+	appendBinary(buffer, (uint64_t)str.size());
+	buffer.insert(buffer.end(), str.begin(), str.end());
+}
+
+static void appendBinary(std::vector<char> & buffer, const std::vector<std::string> & vec) {
+	appendBinary(buffer, (uint64_t)vec.size());
+	for (const std::string & str : vec)
+		appendBinary(buffer, str);
+}
+
+
+/*! Reads values from a checkpoint buffer in the order written with appendBinary().
+	Throws an exception if data is missing or if vector sizes do not match the current master setup.
+*/
+class CheckpointReader {
+public:
+	explicit CheckpointReader(const std::vector<char> & data) : m_data(data), m_pos(0) {}
+
+	template <typename T>
+	void read(T & val) {
+		readRaw(&val, sizeof(T));
+	}
+
+	/*! Reads vector with POD data, the vector must already have the size stored in the checkpoint. */
+	template <typename T>
+	void read(std::vector<T> & vec) {
+		readSize(vec.size());
+		if (!vec.empty())
+			readRaw(&vec[0], vec.size()*sizeof(T));
+	}
+
+	void read(std::string & str) {
+		uint64_t size;
+		read(size);
+		if (size > m_data.size() - m_pos)
+			throw IBK::Exception("Unexpected end of checkpoint data.", "[CheckpointReader::read]");
+		str.assign(m_data.data() + m_pos, (size_t)size);
+		m_pos += (size_t)size;
+	}
+
+	/*! Reads vector of strings, the vector must already have the size stored in the checkpoint. */
+	void read(std::vector<std::string> & vec) {
+		readSize(vec.size());
+		for (std::string & str : vec)
+			read(str);
+	}
+
+	/*! Reads a byte array of arbitrary size. */
+	void readBytes(std::vector<char> & data) {
+		uint64_t size;
+		read(size);
+		if (size > m_data.size() - m_pos)
+			throw IBK::Exception("Unexpected end of checkpoint data.", "[CheckpointReader::readBytes]");
+		data.assign(m_data.begin() + (std::ptrdiff_t)m_pos, m_data.begin() + (std::ptrdiff_t)(m_pos + size));
+		m_pos += (size_t)size;
+	}
+
+	bool atEnd() const { return m_pos == m_data.size(); }
+
+private:
+	void readRaw(void * p, size_t n) {
+		if (n > m_data.size() - m_pos)
+			throw IBK::Exception("Unexpected end of checkpoint data.", "[CheckpointReader::read]");
+		std::memcpy(p, m_data.data() + m_pos, n);
+		m_pos += n;
+	}
+
+	void readSize(size_t expectedSize) {
+		uint64_t size;
+		read(size);
+		if (size != expectedSize)
+			throw IBK::Exception("Checkpoint data does not match current simulation setup.", "[CheckpointReader::read]");
+	}
+
+	const std::vector<char>	&m_data;
+	size_t					m_pos;
+};
+
+
+void MasterSim::restoreState(const IBK::Path & stateDirectory) {
+	const char * const FUNC_ID = "[MasterSim::restoreState]";
+
+	IBK::Path checkpointFile = stateDirectory / "checkpoint.bin";
+	IBK::IBK_Message(IBK::FormatString("Restoring simulation state from checkpoint file '%1'\n").arg(checkpointFile),
+					 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	IBK::MessageIndentor indent; (void)indent;
+
+	// read and decompress checkpoint file
+	std::vector<char> data;
+	CheckpointWriter::read(checkpointFile, CHECKPOINT_VERSION, data);
+
+	try {
+		// output file sizes have been appended to the master state by the checkpoint writer, see storeState()
+		int64_t fileSizes[3];
+		if (data.size() < sizeof(fileSizes))
+			throw IBK::Exception("Unexpected end of checkpoint data.", FUNC_ID);
+		std::memcpy(fileSizes, data.data() + data.size() - sizeof(fileSizes), sizeof(fileSizes));
+		data.resize(data.size() - sizeof(fileSizes));
+		deserializeMasterState(data);
+
+		// discard all outputs written after the checkpoint
+		m_outputWriter.truncateOutputFiles(fileSizes[0], fileSizes[1], fileSizes[2]);
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, IBK::FormatString("Error restoring state from checkpoint file '%1'.").arg(checkpointFile), FUNC_ID);
+	}
+
+	IBK::IBK_Message(IBK::FormatString("Resuming simulation at t = %1 s\n").arg(m_t), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+}
+
+
+void MasterSim::storeState(const IBK::Path & stateDirectory) {
+	const char * const FUNC_ID = "[MasterSim::storeState]";
+
+	if (!stateDirectory.exists() && !IBK::Path::makePath(stateDirectory))
+		throw IBK::Exception(IBK::FormatString("Cannot create checkpoint directory '%1'.").arg(stateDirectory), FUNC_ID);
+
+	// Note: the time needed to capture the checkpoint data (including the time waiting for the previous checkpoint
+	//       to be written) is the time the simulation is blocked; compression and file writing is done by the
+	//       checkpoint writer in the background
+	m_timer.start();
+	++m_statCheckpointCounter;
+
+	std::vector<char> data;
+	serializeMasterState(data);
+	// output files are flushed by the output thread once it has written all outputs up to now
+	std::shared_ptr<OutputFileSizeMarker> outputFileSizes = m_outputWriter.addFileSizeMarker(true);
+
+	// hand over data to background writer, this waits until the previous checkpoint has been written;
+	// the writer appends the output file sizes once they are available
+	m_checkpointWriter.write(stateDirectory / "checkpoint.bin", CHECKPOINT_VERSION, data,
+		[outputFileSizes](std::vector<char> & checkpointData) {
+			outputFileSizes->wait();
+			appendBinary(checkpointData, outputFileSizes->m_valuesSize);
+			appendBinary(checkpointData, outputFileSizes->m_stringsSize);
+			appendBinary(checkpointData, outputFileSizes->m_binarySize);
+		});
+	m_statCheckpointTime += m_timer.stop()*1e-3;
+	IBK::IBK_Message(IBK::FormatString("Checkpoint created at t = %1 s\n").arg(m_t), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+}
+
+
+void MasterSim::takeSnapshot() {
+	const char * const FUNC_ID = "[MasterSim::takeSnapshot]";
+
+	m_timer.start();
+	serializeMasterState(m_snapshotData);
+	// output files are neither flushed nor is a compressed frame completed, sizes are only needed when rewinding
+	m_snapshots.add(m_t, m_snapshotData, m_outputWriter.addFileSizeMarker(false));
+	m_statSnapshotTime += m_timer.stop()*1e-3;
+	++m_statSnapshotCounter;
+	IBK_FastMessage(IBK::VL_DETAILED)(IBK::FormatString("Snapshot taken at t = %1 s (%2 snapshots, %3 MB data, %4 MB stored)\n")
+		.arg(m_t).arg(m_snapshots.size()).arg(m_snapshots.dataSize()/(1024.*1024.)).arg(m_snapshots.memoryUsage()/(1024.*1024.)),
+		IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_DETAILED);
+}
+
+
+double MasterSim::restoreSnapshot(double t) {
+	const char * const FUNC_ID = "[MasterSim::restoreSnapshot]";
+
+	const SnapshotBuffer::Snapshot * snapshot = m_snapshots.latestSnapshot(t);
+	if (snapshot == nullptr)
+		throw IBK::Exception(IBK::FormatString("No snapshot available at or before t = %1 s.").arg(t), FUNC_ID);
+
+	try {
+		m_snapshots.snapshotData(*snapshot, m_snapshotData);
+		deserializeMasterState(m_snapshotData);
+
+		// discard all outputs written after the snapshot
+		snapshot->m_outputFileSizes->wait();
+		m_outputWriter.rewindOutputFiles(*snapshot->m_outputFileSizes);
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, IBK::FormatString("Error restoring snapshot at t = %1 s.").arg(snapshot->m_t), FUNC_ID);
+	}
+	// later snapshots belong to the discarded trajectory
+	m_snapshots.discardAfter(m_t);
+
+	IBK::IBK_Message(IBK::FormatString("Simulation rewound to t = %1 s\n").arg(m_t), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	return m_t;
+}
+
+
+void MasterSim::setSlaveParameter(const std::string & slaveName, const std::string & variableName, const std::string & value) {
+	const char * const FUNC_ID = "[MasterSim::setSlaveParameter]";
 
-	// for all FMU instances:
-	// - do normal FMU init
-	// - compute FMU-specific state file path
-	// - read serialization file and extract meta header
-	// - tell FMU to de-serialize state
+	FMUSlave * slave = nullptr;
+	for (AbstractSlave * s : m_slaves) {
+		if (s->m_name == slaveName) {
+			slave = dynamic_cast<FMUSlave *>(s);
+			break;
+		}
+	}
+	if (slave == nullptr)
+		throw IBK::Exception(IBK::FormatString("Unknown FMU slave '%1'.").arg(slaveName), FUNC_ID);
+
+	try {
+		const FMIVariable & var = slave->fmu()->m_modelDescription.variable(variableName);
+		// only tunable parameters may be changed during the simulation (FMI 2 co-simulation)
+		if (var.m_causality != FMIVariable::C_PARAMETER || var.m_variability != "tunable")
+			throw IBK::Exception(IBK::FormatString("Variable '%1' is not a tunable parameter.").arg(variableName), FUNC_ID);
+		slave->setValue(var, value);
+		// outputs at current time may depend on the parameter
+		slave->cacheOutputs();
+		syncSlaveOutputs(slave, m_realyt, m_intyt, m_boolyt, m_stringyt, false);
+	}
+	catch (IBK::Exception & ex) {
+		throw IBK::Exception(ex, IBK::FormatString("Error while setting parameter in slave '%1'").arg(slaveName), FUNC_ID);
+	}
+	// reused Jacobians have been computed with the previous parameter value
+	m_masterAlgorithm->discardStepHistory();
 
-	// update state of master simulator
+	IBK::IBK_Message(IBK::FormatString("%1.%2 = %3 at t = %4 s\n").arg(slaveName).arg(variableName).arg(value).arg(m_t),
+					 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
 }
 
 
-void MasterSim::storeState(const IBK::Path & /*stateDirectory*/) {
-	// all FMUs must be able to store state!
+void MasterSim::serializeMasterState(std::vector<char> & data) {
+	data.clear();
+	appendBinary(data, m_t);
+
+	// serialize all slaves
+	appendBinary(data, (uint32_t)m_slaves.size());
+	std::vector<char> & slaveState = m_serializedSlaveState;
+	for (const AbstractSlave * slave : m_slaves) {
+		appendBinary(data, slave->m_name);
+		slave->serializeCurrentState(slaveState);
+		appendBinary(data, slaveState);
+	}
+
+	// master state
+	appendBinary(data, m_h);
+	appendBinary(data, m_hProposed);
+	appendBinary(data, m_errTOriginal);
+	appendBinary(data, m_acceptedErrRichardson);
+	appendBinary(data, m_acceptedErrSlopeCheck);
+	appendBinary(data, m_realyt);
+	appendBinary(data, m_intyt);
+	appendBinary(data, m_boolyt);
+	appendBinary(data, m_stringyt);
+	appendBinary(data, m_errRealytFirst);
+	appendBinary(data, m_errRealyt);
+	appendBinary(data, m_errIntyt);
+	appendBinary(data, m_errBoolyt);
+	appendBinary(data, m_errStringyt);
+
+	// statistics
+	appendBinary(data, m_statRollBackCounters);
+	appendBinary(data, m_statRollBackTimes);
+	appendBinary(data, m_statStoreStateCounters);
+	appendBinary(data, m_statStoreStateTimes);
+	appendBinary(data, m_statStateAllocCounters);
+	appendBinary(data, m_statStateReuseCounters);
+	appendBinary(data, m_statSlaveEvalCounters);
+	appendBinary(data, m_statSlaveEvalTimes);
+	appendBinary(data, m_statInputSetCounters);
+	appendBinary(data, m_statInputSkipCounters);
+	appendBinary(data, m_statOutputTime);
+	appendBinary(data, m_statAlgorithmTime);
+	appendBinary(data, m_statConvergenceFailsCounter);
+	appendBinary(data, m_statErrorTestFailsCounter);
+	appendBinary(data, m_statErrorTestTime);
+	appendBinary(data, m_statStepCounter);
+	appendBinary(data, m_statAlgorithmCallCounter);
+	appendBinary(data, m_statCheckpointTime);
+	appendBinary(data, m_statCheckpointCounter);
+	unsigned int algStats[5];
+	m_masterAlgorithm->stats(algStats[0], algStats[1], algStats[2]);
+	m_masterAlgorithm->jacobianStats(algStats[3], algStats[4]);
+	appendBinary(data, algStats);
+
+	// data carried over by the algorithm from one step to the next (e.g. reused Jacobians)
+	m_masterAlgorithm->serializeStepHistory(slaveState); // Mind: re-use buffer
+	appendBinary(data, slaveState);
+
+	// output writer state (output file sizes are recorded separately, see storeState() and takeSnapshot())
+	appendBinary(data, m_outputWriter.m_tEarliestOutputTime);
+	appendBinary(data, m_outputWriter.m_tLastOutput);
+	const OutputAggregator & aggregator = m_outputWriter.m_aggregator;
+	appendBinary(data, (uint64_t)aggregator.size());
+	appendBinary(data, aggregator.m_tStart);
+	appendBinary(data, aggregator.m_tLast);
+	appendBinary(data, aggregator.m_started);
+	appendBinary(data, aggregator.m_last);
+	appendBinary(data, aggregator.m_integral);
+	appendBinary(data, aggregator.m_min);
+	appendBinary(data, aggregator.m_max);
+}
+
 
-	// for all FMU instances:
-	// - compute FMU-specific state file path
-	// - ask for serialization size and create dummy vector
-	// - ask for FMU state and then serialize content of FMU
-	// - dump state into file with meta-data header
+void MasterSim::deserializeMasterState(const std::vector<char> & data) {
+	const char * const FUNC_ID = "[MasterSim::deserializeMasterState]";
+
+	CheckpointReader reader(data);
+	reader.read(m_t);
+
+	// restore slave states
+	uint32_t slaveCount;
+	reader.read(slaveCount);
+	if (slaveCount != m_slaves.size())
+		throw IBK::Exception("Checkpoint data does not match current simulation setup.", FUNC_ID);
+	std::vector<char> & slaveState = m_serializedSlaveState;
+	std::string slaveName;
+	for (AbstractSlave * slave : m_slaves) {
+		reader.read(slaveName);
+		if (slaveName != slave->m_name)
+			throw IBK::Exception(IBK::FormatString("Checkpoint data of slave '%1' missing.").arg(slave->m_name), FUNC_ID);
+		reader.readBytes(slaveState);
+		slave->restoreSerializedState(m_t, slaveState);
+		// inputs of slaves must be set again before the next step
+		invalidateInputCache(slave);
+	}
 
-	// dump state of master simulator
+	// restore master state
+	reader.read(m_h);
+	reader.read(m_hProposed);
+	reader.read(m_errTOriginal);
+	reader.read(m_acceptedErrRichardson);
+	reader.read(m_acceptedErrSlopeCheck);
+	reader.read(m_realyt);
+	reader.read(m_intyt);
+	reader.read(m_boolyt);
+	reader.read(m_stringyt);
+	reader.read(m_errRealytFirst);
+	reader.read(m_errRealyt);
+	reader.read(m_errIntyt);
+	reader.read(m_errBoolyt);
+	reader.read(m_errStringyt);
+
+	// restore statistics
+	reader.read(m_statRollBackCounters);
+	reader.read(m_statRollBackTimes);
+	reader.read(m_statStoreStateCounters);
+	reader.read(m_statStoreStateTimes);
+	reader.read(m_statStateAllocCounters);
+	reader.read(m_statStateReuseCounters);
+	reader.read(m_statSlaveEvalCounters);
+	reader.read(m_statSlaveEvalTimes);
+	reader.read(m_statInputSetCounters);
+	reader.read(m_statInputSkipCounters);
+	reader.read(m_statOutputTime);
+	reader.read(m_statAlgorithmTime);
+	reader.read(m_statConvergenceFailsCounter);
+	reader.read(m_statErrorTestFailsCounter);
+	reader.read(m_statErrorTestTime);
+	reader.read(m_statStepCounter);
+	reader.read(m_statAlgorithmCallCounter);
+	reader.read(m_statCheckpointTime);
+	reader.read(m_statCheckpointCounter);
+	unsigned int algStats[5];
+	reader.read(algStats);
+	m_masterAlgorithm->restoreStats(algStats[0], algStats[1], algStats[2], algStats[3], algStats[4]);
+
+	// restore data carried over by the algorithm from one step to the next
+	reader.readBytes(slaveState); // Mind: re-use buffer
+	m_masterAlgorithm->deserializeStepHistory(slaveState);
+
+	// restore output writer state
+	reader.read(m_outputWriter.m_tEarliestOutputTime);
+	reader.read(m_outputWriter.m_tLastOutput);
+	// Note: output files (and aggregator) may not be set up yet, when restoring a checkpoint
+	OutputAggregator & aggregator = m_outputWriter.m_aggregator;
+	uint64_t aggregatedVars;
+	reader.read(aggregatedVars);
+	aggregator.resize((unsigned int)aggregatedVars);
+	reader.read(aggregator.m_tStart);
+	reader.read(aggregator.m_tLast);
+	reader.read(aggregator.m_started);
+	reader.read(aggregator.m_last);
+	reader.read(aggregator.m_integral);
+	reader.read(aggregator.m_min);
+	reader.read(aggregator.m_max);
+	if (!reader.atEnd())
+		throw IBK::Exception("Checkpoint data does not match current simulation setup.", FUNC_ID);
 }
 
 
-void MasterSim::simulate() {
+void MasterSim::simulate(double tStop) {
 	const char * const FUNC_ID = "[MasterSim::simulate]";
 
 	// write initial statistics and header
@@ -182,6 +576,19 @@ void MasterSim::simulate() {
 	//     m_hProposed            = 0.001
 	//     m_project.m_tEnd.value = 1.0
 	//     -> Take step, but adjust m_hProposed to hit exactly tEnd
+	// time point of next checkpoint, computed with the multiplication method to avoid accumulation of rounding errors
+	double hCheckpoint = m_project.m_checkpointInterval.empty() ? 0 : m_project.m_checkpointInterval.value;
+	int checkpointIndex = 0;
+	double tNextCheckpoint = 0;
+	if (hCheckpoint > 0) {
+		while (m_project.m_tStart.value + ++checkpointIndex*hCheckpoint <= m_t + 1e-8);
+		tNextCheckpoint = m_project.m_tStart.value + checkpointIndex*hCheckpoint;
+	}
+
+	// initial snapshot, so that the simulation can be rewound to the start time (or to the restart time)
+	if (m_project.m_snapshotStepInterval > 0 && m_snapshots.size() == 0)
+		takeSnapshot();
+
 	while (m_t < m_project.m_tEnd.value) {
 		double hRemaining = m_project.m_tEnd.value - m_t;
 		if (hRemaining < m_hProposed) {
@@ -208,16 +615,44 @@ void MasterSim::simulate() {
 
 		if (m_t < m_project.m_tEnd.value) {
 			appendOutputs();// appends outputs (filtering/scheduling is implemented inside OutputWriter class)
+
+			// write checkpoint when scheduled
+			// mind rounding errors in m_t, use same tolerance as for final output
+			if (hCheckpoint > 0 && m_t > tNextCheckpoint - 1e-8) {
+				storeState(checkpointDirectory());
+				while (m_project.m_tStart.value + ++checkpointIndex*hCheckpoint <= m_t + 1e-8);
+				tNextCheckpoint = m_project.m_tStart.value + checkpointIndex*hCheckpoint;
+			}
+
+			// take in-memory snapshot when scheduled
+			if (m_project.m_snapshotStepInterval > 0 && m_statStepCounter % m_project.m_snapshotStepInterval == 0)
+				takeSnapshot();
+
+			// stop without reaching the end time, when requested
+			if (m_t >= tStop)
+				break;
 		}
 	}
 	// write final results
 
 	// ensure, that final results are definitely written, but only if the last output time is not already
 	// close enough to the final results
-	if (m_t - m_outputWriter.m_tLastOutput > 1e-8) {
+	if (m_t < tStop && m_t - m_outputWriter.m_tLastOutput > 1e-8) {
 		m_outputWriter.m_tEarliestOutputTime = -1;  // this ensures that output is always written
 		appendOutputs();
 	}
+
+	// wait for output thread to write all outputs, so that errors are reported
+	m_timer.start();
+	m_outputWriter.finishOutputs();
+	m_statOutputTime += m_timer.stop()*1e-3;
+
+	// wait for last checkpoint to be written, so that errors are reported
+	if (hCheckpoint > 0) {
+		m_timer.start();
+		m_checkpointWriter.waitForCompletion();
+		m_statCheckpointTime += m_timer.stop()*1e-3;
+	}
 }
 
 
@@ -277,6 +712,13 @@ void MasterSim::doStep() {
 					throw IBK::Exception(IBK::FormatString("Step failure at t=%1, taking step size %2. "
 														   "Reducing step would fall below minimum step size of %3.")
 										 .arg(m_t).arg(m_h).arg(m_project.m_hMin.value), FUNC_ID);
+				// without iteration and error control, slave states are not stored
+				for (AbstractSlave * slave : m_slaves) {
+					if (!m_slaveStateCaptured[slave->m_slaveIndex] && !slave->supportsCheapRollback())
+						throw IBK::Exception(IBK::FormatString("Step failure at t=%1, taking step size %2. Cannot repeat step "
+															   "since state of slave '%3' has not been stored (enable iteration or error control).")
+											 .arg(m_t).arg(m_h).arg(slave->m_name), FUNC_ID);
+				}
 				m_h /= 5;
 
 				// Reset slaves
@@ -371,6 +813,14 @@ void MasterSim::writeMetrics() const {
 	IBK::IBK_Message( IBK::FormatString("Error test time and failure count          = %1    %2\n")
 		.arg(IBK::Time::format_time_difference(m_statErrorTestTime, ustr, true),13).arg(m_statErrorTestFailsCounter,6),
 		IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	if (m_statCheckpointCounter > 0)
+		IBK::IBK_Message( IBK::FormatString("Checkpoint capture (blocking) and count    = %1    %2\n")
+			.arg(IBK::Time::format_time_difference(m_statCheckpointTime, ustr, true),13).arg(m_statCheckpointCounter,6),
+			IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	if (m_statSnapshotCounter > 0)
+		IBK::IBK_Message( IBK::FormatString("Snapshot capture and count                 = %1    %2\n")
+			.arg(IBK::Time::format_time_difference(m_statSnapshotTime, ustr, true),13).arg(m_statSnapshotCounter,6),
+			IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
 	IBK::IBK_Message( IBK::FormatString("------------------------------------------------------------------------------\n"), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
 
 	for (unsigned int i=0; i<m_slaves.size(); ++i) {
@@ -384,6 +834,11 @@ void MasterSim::writeMetrics() const {
 						  .arg(IBK::Time::format_time_difference(m_statStoreStateTimes[i], ustr, true),13)
 						  .arg(m_statStoreStateCounters[i], 6),
 						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+		if (m_statStoreStateCounters[i] > 0)
+			IBK::IBK_Message( IBK::FormatString("                 state handles alloc/reuse = %1    %2\n")
+							  .arg(m_statStateAllocCounters[i], 13)
+							  .arg(m_statStateReuseCounters[i], 6),
+							  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
 		IBK::IBK_Message( IBK::FormatString("                                  setState = %1    %2\n")
 						  .arg(IBK::Time::format_time_difference(m_statRollBackTimes[i], ustr, true),13)
 						  .arg(m_statRollBackCounters[i], 6),
@@ -513,6 +968,28 @@ void MasterSim::checkCapabilities() {
 									 FUNC_ID);
 		}
 	}
+
+	// checkpoints and snapshots require serialization of all FMU states
+	bool writeCheckpoints = !m_project.m_checkpointInterval.empty() && m_project.m_checkpointInterval.value > 0;
+	if (writeCheckpoints)
+		IBK::IBK_Message(IBK::FormatString("Checkpoints are written every %1.\n").arg(m_project.m_checkpointInterval.toString(true)),
+						 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+	if (m_project.m_snapshotStepInterval > 0)
+		IBK::IBK_Message(IBK::FormatString("In-memory snapshots are taken every %1 steps (memory limit %2 MB).\n")
+						 .arg(m_project.m_snapshotStepInterval).arg(m_project.m_snapshotMemoryLimit),
+						 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+	if (writeCheckpoints || m_project.m_snapshotStepInterval > 0) {
+		for (unsigned int i=0; i<m_fmuManager.fmus().size(); ++i) {
+			const FMU * fmu = m_fmuManager.fmus()[i];
+			if ((fmu->m_modelDescription.m_fmuType & ModelDescription::CS_v1) ||
+				!fmu->m_modelDescription.m_canGetAndSetFMUstate || !fmu->m_modelDescription.m_canSerializeFMUstate)
+			{
+				throw IBK::Exception(IBK::FormatString("FMU '%1' does not provide canGetAndSetFMUState and canSerializeFMUstate "
+													   "capabilities (FMI 2), which are required for checkpoints and snapshots.").arg(fmu->fmuFilePath()),
+									 FUNC_ID);
+			}
+		}
+	}
 }
 
 
@@ -523,6 +1000,10 @@ void MasterSim::instatiateSlaves() {
 	// turn on debug logging for high verbosity levels
 	FMUSlave::m_useDebugLogging = m_args.m_verbosityLevel > 3;
 
+	// output filter selects the variables retrieved from FMU slaves (in addition to connected variables)
+	OutputFilter outputFilter;
+	outputFilter.setPatterns(m_project.m_outputFilter);
+
 	// now that all FMUs have been loaded and their functions/symbols imported, we can instantiate the simulator slaves
 	std::set<FMU*>	instantiatedFMUs; // set that holds all instantiated slaves, in case an FMU may only be instantiated once
 
@@ -554,7 +1035,23 @@ void MasterSim::instatiateSlaves() {
 				// remember that this FMU was instantiated
 				instantiatedFMUs.insert(fmu);
 				// create new simulation slave
-				slave.reset( new FMUSlave(fmu, slaveDef.m_name) );
+				FMUSlave * fmuSlave = new FMUSlave(fmu, slaveDef.m_name);
+				slave.reset( fmuSlave );
+
+				// collect variables of this slave used in connections, these are retrieved regardless of the output filter;
+				// invalid variable references are skipped here and reported when composing the variable mappings
+				std::set< std::pair<FMIVariable::VarType, unsigned int> > coupledVariables;
+				for (unsigned int e=0; e<m_project.m_graph.size(); ++e) {
+					std::vector<std::string> tokens;
+					if (IBK::explode_in2(m_project.m_graph[e].m_outputVariableRef, tokens, '.') != 2 || tokens[0] != slaveDef.m_name)
+						continue;
+					try {
+						const FMIVariable & var = fmu->m_modelDescription.variable(tokens[1]);
+						coupledVariables.insert(std::make_pair(var.m_type, var.m_valueReference));
+					}
+					catch (IBK::Exception &) {}
+				}
+				fmuSlave->selectOutputs(outputFilter, coupledVariables);
 			}
 			else if (IBK::string_nocase_compare(fmuSlavePath.extension(), "tsv") ||
 					 IBK::string_nocase_compare(fmuSlavePath.extension(), "csv"))
@@ -573,33 +1070,16 @@ void MasterSim::instatiateSlaves() {
 			catch (IBK::Exception & ex) {
 				throw IBK::Exception(ex, IBK::FormatString("Error setting up slave '%1'").arg(slaveDef.m_name), FUNC_ID);
 			}
+			if (slaveDef.m_stateless)
+				slave->m_stateless = true;
 			// store index of slave in global slaves vector
 			slave->m_slaveIndex = (unsigned int)m_slaves.size();
 			// add slave to vector with slaves
-			AbstractSlave * s = slave.get();
 			m_slaves.push_back(slave.release());
-
-			// insert slave into cycle/priority
-			if (m_cycles.size() <= slaveDef.m_cycle)
-				m_cycles.resize(slaveDef.m_cycle+1);
-			m_cycles[slaveDef.m_cycle].m_slaves.push_back(s);
-		}
-	}
-
-	IBK::IBK_Message("\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
-	IBK::IBK_Message("Cycles\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
-	IBK::MessageIndentor indent2; (void)indent2;
-
-	for (unsigned int i=0; i<m_cycles.size(); ++i) {
-		IBK::IBK_Message( IBK::FormatString("Cycle %1:\n").arg(i+1),
-						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
-		for (unsigned int s=0; s<m_cycles[i].m_slaves.size(); ++s) {
-			const AbstractSlave * slave = m_cycles[i].m_slaves[s];
-			IBK::IBK_Message( IBK::FormatString("  %1 (%2)\n").arg(slave->m_name).arg(slave->m_filepath.filename()),
-						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
 		}
 	}
 
+	setupCycles();
 
 	unsigned int nSlaves = (unsigned int)m_slaves.size();
 
@@ -613,6 +1093,10 @@ void MasterSim::instatiateSlaves() {
 	m_statRollBackTimes.resize(nSlaves);
 	m_statStoreStateCounters.resize(nSlaves);
 	m_statStoreStateTimes.resize(nSlaves);
+	m_statStateAllocCounters.resize(nSlaves);
+	m_statStateReuseCounters.resize(nSlaves);
+	m_statInputSetCounters.resize(nSlaves);
+	m_statInputSkipCounters.resize(nSlaves);
 
 	// initialize vectors
 	for (unsigned int i=0; i<nSlaves; ++i) {
@@ -624,6 +1108,85 @@ void MasterSim::instatiateSlaves() {
 		m_statRollBackTimes[i] = 0;
 		m_statStoreStateCounters[i] = 0;
 		m_statStoreStateTimes[i] = 0;
+		m_statStateAllocCounters[i] = 0;
+		m_statStateReuseCounters[i] = 0;
+		m_statInputSetCounters[i] = 0;
+		m_statInputSkipCounters[i] = 0;
+	}
+}
+
+
+void MasterSim::setupCycles() {
+	const char * const FUNC_ID = "[MasterSim::setupCycles]";
+
+	// create dependency graph between slaves
+	SlaveGraph graph((unsigned int)m_slaves.size());
+	for (unsigned int i=0; i<m_project.m_graph.size(); ++i) {
+		const Project::GraphEdge & edge = m_project.m_graph[i];
+		std::vector<Project::SimulatorDef>::const_iterator outIt = std::find(m_project.m_simulators.begin(),
+			m_project.m_simulators.end(), edge.outputSlaveName());
+		std::vector<Project::SimulatorDef>::const_iterator inIt = std::find(m_project.m_simulators.begin(),
+			m_project.m_simulators.end(), edge.inputSlaveName());
+		if (outIt == m_project.m_simulators.end() || inIt == m_project.m_simulators.end())
+			continue; // invalid references are reported when composing variable vector
+		graph.addEdge((unsigned int)(outIt - m_project.m_simulators.begin()),
+					  (unsigned int)(inIt - m_project.m_simulators.begin()));
+	}
+
+	// determine minimal cycles and their evaluation order
+	std::vector< std::vector<unsigned int> > derivedCycles;
+	graph.computeCycles(derivedCycles);
+
+	// collect user-defined cycles
+	std::vector< std::vector<unsigned int> > userCycles;
+	for (unsigned int i=0; i<m_project.m_simulators.size(); ++i) {
+		const Project::SimulatorDef & slaveDef = m_project.m_simulators[i];
+		if (userCycles.size() <= slaveDef.m_cycle)
+			userCycles.resize(slaveDef.m_cycle+1);
+		userCycles[slaveDef.m_cycle].push_back(i);
+	}
+
+	IBK::IBK_Message("\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	if (m_project.m_automaticCycleDetection) {
+		IBK::IBK_Message("Cycles (determined from connection graph)\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	}
+	else {
+		// report derived cycles as proposal, if different from user-defined cycles
+		std::vector< std::vector<unsigned int> > nonEmptyUserCycles;
+		for (unsigned int i=0; i<userCycles.size(); ++i)
+			if (!userCycles[i].empty())
+				nonEmptyUserCycles.push_back(userCycles[i]);
+		if (nonEmptyUserCycles != derivedCycles) {
+			IBK::IBK_Message(IBK::FormatString("Cycles determined from connection graph (%1 back edges, user-defined cycles have %2 back edges):\n")
+							 .arg(graph.backEdgeCount(derivedCycles)).arg(graph.backEdgeCount(userCycles)),
+							 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+			for (unsigned int i=0; i<derivedCycles.size(); ++i) {
+				std::string slaveNames;
+				for (unsigned int s=0; s<derivedCycles[i].size(); ++s)
+					slaveNames += " " + m_slaves[derivedCycles[i][s]]->m_name;
+				IBK::IBK_Message(IBK::FormatString("  Cycle %1:%2\n").arg(i+1).arg(slaveNames), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+			}
+			IBK::IBK_Message("Use 'automaticCycleDetection yes' in project file to use these cycles.\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+		}
+		IBK::IBK_Message("Cycles\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+	}
+
+	const std::vector< std::vector<unsigned int> > & cycles = m_project.m_automaticCycleDetection ? derivedCycles : userCycles;
+	m_cycles.clear();
+	m_cycles.resize(cycles.size());
+	for (unsigned int i=0; i<cycles.size(); ++i)
+		for (unsigned int s=0; s<cycles[i].size(); ++s)
+			m_cycles[i].m_slaves.push_back(m_slaves[cycles[i][s]]);
+
+	IBK::MessageIndentor indent; (void)indent;
+	for (unsigned int i=0; i<m_cycles.size(); ++i) {
+		IBK::IBK_Message( IBK::FormatString("Cycle %1:\n").arg(i+1),
+						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+		for (unsigned int s=0; s<m_cycles[i].m_slaves.size(); ++s) {
+			const AbstractSlave * slave = m_cycles[i].m_slaves[s];
+			IBK::IBK_Message( IBK::FormatString("  %1 (%2)\n").arg(slave->m_name).arg(slave->m_filepath.filename()),
+						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+		}
 	}
 }
 
@@ -647,6 +1210,61 @@ void MasterSim::initMasterAlgorithm() {
 }
 
 
+void MasterSim::setupStateCapture() {
+	const char * const FUNC_ID = "[MasterSim::setupStateCapture]";
+
+	unsigned int nSlaves = (unsigned int)m_slaves.size();
+	m_slaveStateCaptured.assign(nSlaves, false);
+	m_stateTimers.resize(nSlaves);
+
+	// slaves opted in for concurrent state access are handled by the thread pool; since the serial slaves
+	// are processed concurrently to these, an FMU is only used concurrently if all of its slaves are opted in
+	std::map<const FMU*, bool> fmuParallelStates;
+	for (AbstractSlave * slave : m_slaves) {
+		const FMUSlave * fmuSlave = dynamic_cast<const FMUSlave*>(slave);
+		if (fmuSlave == nullptr)
+			continue;
+		bool parallelStates = m_project.simulatorDefinition(slave->m_name).m_parallelStates;
+		std::map<const FMU*, bool>::iterator it = fmuParallelStates.find(fmuSlave->fmu());
+		if (it == fmuParallelStates.end())
+			fmuParallelStates[fmuSlave->fmu()] = parallelStates;
+		else
+			it->second = it->second && parallelStates;
+	}
+	m_parallelStateSlaves.clear();
+	m_serialStateSlaves.clear();
+	for (AbstractSlave * slave : m_slaves) {
+		if (slave->supportsCheapRollback())
+			continue;
+		const FMUSlave * fmuSlave = dynamic_cast<const FMUSlave*>(slave);
+		if (m_threadPool.threadCount() > 1 && fmuSlave != nullptr && fmuParallelStates[fmuSlave->fmu()])
+			m_parallelStateSlaves.push_back(slave->m_slaveIndex);
+		else
+			m_serialStateSlaves.push_back(slave->m_slaveIndex);
+	}
+	if (!m_parallelStateSlaves.empty())
+		IBK::IBK_Message(IBK::FormatString("States of %1 slaves are stored/restored in parallel.\n").arg(m_parallelStateSlaves.size()),
+						 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+
+	if (!m_enableIteration && !m_useErrorTestWithVariableStepSizes)
+		return; // states are never stored
+
+	// Mind: a step that fails (e.g. FMU error) is repeated with reduced step size even without time step
+	//       adjustment, and then all slaves are rolled back; hence only stateless slaves are skipped, these
+	//       are only reset in time
+	unsigned int capturedCount = 0;
+	for (AbstractSlave * slave : m_slaves) {
+		if (!slave->supportsCheapRollback()) {
+			m_slaveStateCaptured[slave->m_slaveIndex] = true;
+			++capturedCount;
+		}
+	}
+	if (capturedCount < nSlaves)
+		IBK::IBK_Message(IBK::FormatString("States of %1 of %2 slaves are stored for roll-back.\n").arg(capturedCount).arg(nSlaves),
+						 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+}
+
+
 void MasterSim::setupDefaultParameters() {
 	const char * const FUNC_ID = "[MasterSim::setupDefaultParameters]";
 	IBK::IBK_Message("\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
@@ -1080,7 +1698,7 @@ void MasterSim::composeVariableVector() {
 
 			varMap.m_outputSlave = const_cast<AbstractSlave*>(outputVarRef.first);
 			FMUSlave * fmuSlave = dynamic_cast<FMUSlave*>(varMap.m_outputSlave);
-			varMap.m_outputLocalIndex = fmuSlave->fmu()->localOutputIndex(t, outputVarRef.second->m_valueReference);
+			varMap.m_outputLocalIndex = fmuSlave->localOutputIndex(t, outputVarRef.second->m_valueReference);
 		}
 
 		// add variable mapping to corresponding vector
@@ -1126,6 +1744,62 @@ void MasterSim::composeVariableVector() {
 	if (m_realVariableMapping.empty())
 		IBK::IBK_Message("No real variables in connection graph. This may be an error since FMUs won't communicate with each other.", IBK::MSG_WARNING, FUNC_ID);
 
+	// build per-slave connection tables
+	m_slaveConnections.clear();
+	m_slaveConnections.resize(m_slaves.size());
+	addSlaveConnections(m_realVariableMapping, &SlaveConnections::m_realInputs, &SlaveConnections::m_realInputValueRefs,
+						&SlaveConnections::m_realOutputs);
+	addSlaveConnections(m_intVariableMapping, &SlaveConnections::m_intInputs, &SlaveConnections::m_intInputValueRefs,
+						&SlaveConnections::m_intOutputs);
+	addSlaveConnections(m_boolVariableMapping, &SlaveConnections::m_boolInputs, &SlaveConnections::m_boolInputValueRefs,
+						&SlaveConnections::m_boolOutputs);
+	addSlaveConnections(m_stringVariableMapping, &SlaveConnections::m_stringInputs, &SlaveConnections::m_stringInputValueRefs,
+						&SlaveConnections::m_stringOutputs);
+	// preallocate value buffers
+	for (SlaveConnections & conn : m_slaveConnections) {
+		conn.m_realInputValues.resize(conn.m_realInputs.size());
+		conn.m_intInputValues.resize(conn.m_intInputs.size());
+		conn.m_boolInputValues.resize(conn.m_boolInputs.size());
+		if (m_project.m_skipUnchangedInputs) {
+			conn.m_inputValueRefBuffer.resize(std::max(conn.m_realInputs.size(),
+													   std::max(conn.m_intInputs.size(), conn.m_boolInputs.size())));
+			conn.m_realInputCache.resize(conn.m_realInputs.size());
+			conn.m_intInputCache.resize(conn.m_intInputs.size());
+			conn.m_boolInputCache.resize(conn.m_boolInputs.size());
+			conn.m_stringInputCache.resize(conn.m_stringInputs.size());
+		}
+	}
+	// Within iterated cycles, real inputs are set on any change: the iteration compares slave results
+	// computed from the current iterate, and skipping small changes would evaluate slaves with outdated
+	// inputs (in the first iteration of a step, the inputs are compared to those of the previous step).
+	if (m_project.m_skipUnchangedInputs && m_project.m_inputChangeTolerance != 0) {
+		// a cycle is coupled, if real outputs of its slaves are connected to inputs of its slaves
+		std::vector<unsigned int> cycleOfSlave(m_slaves.size(), 0);
+		for (unsigned int c=0; c<m_cycles.size(); ++c)
+			for (const AbstractSlave * slave : m_cycles[c].m_slaves)
+				cycleOfSlave[slave->m_slaveIndex] = c;
+		std::vector<bool> coupled(m_cycles.size(), false);
+		for (const VariableMapping & varMap : m_realVariableMapping) {
+			if (varMap.m_inputSlave != nullptr &&
+				cycleOfSlave[varMap.m_inputSlave->m_slaveIndex] == cycleOfSlave[varMap.m_outputSlave->m_slaveIndex])
+			{
+				coupled[cycleOfSlave[varMap.m_inputSlave->m_slaveIndex]] = true;
+			}
+		}
+		for (unsigned int c=0; c<m_cycles.size(); ++c) {
+			const Cycle & cycle = m_cycles[c];
+			// Gauss-Seidel does not iterate cycles with a single slave
+			bool iterated = m_enableIteration && coupled[c] &&
+					(m_project.m_masterMode == Project::MM_NEWTON ||
+					 (m_project.m_masterMode == Project::MM_GAUSS_SEIDEL && cycle.m_slaves.size() > 1));
+			for (const AbstractSlave * slave : cycle.m_slaves)
+				m_slaveConnections[slave->m_slaveIndex].m_inputChangeTolerance = iterated ? 0 : m_project.m_inputChangeTolerance;
+			if (iterated)
+				IBK::IBK_Message(IBK::FormatString("Cycle %1 is iterated, inputChangeTolerance is not used for its slaves.\n")
+								 .arg(c+1), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+		}
+	}
+
 	// resize variable vectors
 	m_realyt.resize(m_realVariableMapping.size());
 	m_realytNext.resize(m_realVariableMapping.size());
@@ -1153,6 +1827,77 @@ void MasterSim::composeVariableVector() {
 }
 
 
+void MasterSim::setupCycleDependencies() {
+	std::vector<unsigned int> cycleOfSlave(m_slaves.size(), 0);
+	for (unsigned int c=0; c<m_cycles.size(); ++c) {
+		Cycle & cycle = m_cycles[c];
+		cycle.m_realOutputs.clear();
+		cycle.m_intOutputs.clear();
+		cycle.m_boolOutputs.clear();
+		cycle.m_stringOutputs.clear();
+		for (unsigned int s=0; s<cycle.m_slaves.size(); ++s) {
+			unsigned int slaveIdx = cycle.m_slaves[s]->m_slaveIndex;
+			cycleOfSlave[slaveIdx] = c;
+			const SlaveConnections & conn = m_slaveConnections[slaveIdx];
+			for (const OutputConnection & o : conn.m_realOutputs)		cycle.m_realOutputs.push_back(o.m_variableIndex);
+			for (const OutputConnection & o : conn.m_intOutputs)		cycle.m_intOutputs.push_back(o.m_variableIndex);
+			for (const OutputConnection & o : conn.m_boolOutputs)		cycle.m_boolOutputs.push_back(o.m_variableIndex);
+			for (const OutputConnection & o : conn.m_stringOutputs)	cycle.m_stringOutputs.push_back(o.m_variableIndex);
+		}
+		std::sort(cycle.m_realOutputs.begin(), cycle.m_realOutputs.end());
+		std::sort(cycle.m_intOutputs.begin(), cycle.m_intOutputs.end());
+		std::sort(cycle.m_boolOutputs.begin(), cycle.m_boolOutputs.end());
+		std::sort(cycle.m_stringOutputs.begin(), cycle.m_stringOutputs.end());
+	}
+
+	// two cycles depend on each other if any variable is exchanged between them, regardless of direction:
+	// - the later cycle needs the results of the earlier cycle
+	// - the earlier cycle needs values of the later cycle from the last time level, so the later cycle
+	//   must not update these values before the earlier cycle is done
+	std::vector< std::set<unsigned int> > successors(m_cycles.size());
+	const std::vector<VariableMapping> * mappings[4] = { &m_realVariableMapping, &m_intVariableMapping,
+														&m_boolVariableMapping, &m_stringVariableMapping };
+	for (unsigned int t=0; t<4; ++t) {
+		for (const VariableMapping & varMap : *mappings[t]) {
+			if (varMap.m_inputSlave == nullptr)
+				continue;
+			unsigned int c1 = cycleOfSlave[varMap.m_outputSlave->m_slaveIndex];
+			unsigned int c2 = cycleOfSlave[varMap.m_inputSlave->m_slaveIndex];
+			if (c1 != c2)
+				successors[std::min(c1, c2)].insert(std::max(c1, c2));
+		}
+	}
+	m_cycleSuccessors.clear();
+	m_cycleSuccessors.resize(m_cycles.size());
+	for (unsigned int c=0; c<m_cycles.size(); ++c)
+		m_cycleSuccessors[c].assign(successors[c].begin(), successors[c].end());
+}
+
+
+void MasterSim::addSlaveConnections(const std::vector<VariableMapping> & mappings,
+									std::vector<InputConnection> SlaveConnections::* inputs,
+									std::vector<unsigned int> SlaveConnections::* inputValueRefs,
+									std::vector<OutputConnection> SlaveConnections::* outputs)
+{
+	for (unsigned int i=0; i<mappings.size(); ++i) {
+		const VariableMapping & varMap = mappings[i];
+		if (varMap.m_inputSlave != nullptr) {
+			InputConnection c;
+			c.m_variableIndex = i;
+			c.m_scaleFactor = varMap.m_scaleFactor;
+			c.m_offset = varMap.m_offset;
+			SlaveConnections & conn = m_slaveConnections[varMap.m_inputSlave->m_slaveIndex];
+			(conn.*inputs).push_back(c);
+			(conn.*inputValueRefs).push_back(varMap.m_inputValueReference);
+		}
+		OutputConnection c;
+		c.m_variableIndex = i;
+		c.m_outputLocalIndex = varMap.m_outputLocalIndex;
+		(m_slaveConnections[varMap.m_outputSlave->m_slaveIndex].*outputs).push_back(c);
+	}
+}
+
+
 bool MasterSim::doErrorCheckRichardson() {
 	const char * const FUNC_ID = "[MasterSim::doErrorCheckRichardson]";
 
@@ -1431,44 +2176,112 @@ void MasterSim::updateSlaveInputs(AbstractSlave * slave, const std::vector<doubl
 	IBK_ASSERT(intVariables.size() == m_intVariableMapping.size());
 	IBK_ASSERT(boolVariables.size() == m_boolVariableMapping.size());
 	IBK_ASSERT(stringVariables.size() == m_stringVariableMapping.size());
-	// process all connected variables
-	for (unsigned int i=0; i<m_realVariableMapping.size(); ++i) {
-		VariableMapping & varMap = m_realVariableMapping[i];
-		// skip variables that are not inputs to selected slave
-		if (varMap.m_inputSlave == nullptr || varMap.m_inputSlave != slave) continue;
-		// set input in slave and apply scaling/offset
-		double realValue = realVariables[i];
-		realValue = varMap.m_offset + varMap.m_scaleFactor*realValue;
-		if (varMap.m_offset != 0 || varMap.m_scaleFactor != 1.0) {
+	IBK_ASSERT(slave->m_slaveIndex < m_slaveConnections.size());
+	SlaveConnections & conn = m_slaveConnections[slave->m_slaveIndex];
+	const bool skipUnchanged = m_project.m_skipUnchangedInputs;
+	const double tolerance = conn.m_inputChangeTolerance;
+	unsigned int & setCounter = m_statInputSetCounters[slave->m_slaveIndex];
+	unsigned int & skipCounter = m_statInputSkipCounters[slave->m_slaveIndex];
+
+	// collect all connected variables of this slave and pass them with one call per data type;
+	// when skipping unchanged inputs, only changed values and their value references are collected
+	unsigned int count = 0;
+	for (unsigned int i=0; i<conn.m_realInputs.size(); ++i) {
+		const InputConnection & c = conn.m_realInputs[i];
+		// apply scaling/offset
+		double realValue = realVariables[c.m_variableIndex];
+		realValue = c.m_offset + c.m_scaleFactor*realValue;
+		if (c.m_offset != 0 || c.m_scaleFactor != 1.0) {
 			IBK_FastMessage(IBK::VL_DETAILED)(IBK::FormatString("%1 = %2 + %3*%4\n")
-											  .arg(realValue).arg(varMap.m_offset).arg(varMap.m_scaleFactor)
-											  .arg(realVariables[i]), IBK::MSG_PROGRESS, "[MasterSim::updateSlaveInputs]", IBK::VL_DETAILED);
+											  .arg(realValue).arg(c.m_offset).arg(c.m_scaleFactor)
+											  .arg(realVariables[c.m_variableIndex]), IBK::MSG_PROGRESS, "[MasterSim::updateSlaveInputs]", IBK::VL_DETAILED);
 		}
-		varMap.m_inputSlave->setReal(varMap.m_inputValueReference, realValue);
+		if (skipUnchanged) {
+			if (conn.m_realInputCacheValid) {
+				bool unchanged;
+				if (tolerance == 0)
+					unchanged = (std::memcmp(&realValue, &conn.m_realInputCache[i], sizeof(double)) == 0);
+				else
+					unchanged = (std::fabs(realValue - conn.m_realInputCache[i]) <= tolerance);
+				if (unchanged) {
+					++skipCounter;
+					continue;
+				}
+			}
+			conn.m_realInputCache[i] = realValue;
+			conn.m_inputValueRefBuffer[count] = conn.m_realInputValueRefs[i];
+		}
+		conn.m_realInputValues[count++] = realValue;
 	}
-	if (!realOnly) {
-		for (unsigned int i=0; i<m_intVariableMapping.size(); ++i) {
-			VariableMapping & varMap = m_intVariableMapping[i];
-			// skip variables that are not inputs to selected slave
-			if (varMap.m_inputSlave == nullptr || varMap.m_inputSlave != slave) continue;
-			// set input in slave
-			varMap.m_inputSlave->setInteger(varMap.m_inputValueReference, intVariables[i]);
+	if (count != 0) {
+		slave->setReals(skipUnchanged ? &conn.m_inputValueRefBuffer[0] : &conn.m_realInputValueRefs[0],
+						&conn.m_realInputValues[0], count);
+		setCounter += count;
+	}
+	conn.m_realInputCacheValid = true;
+	if (realOnly)
+		return;
+
+	count = 0;
+	for (unsigned int i=0; i<conn.m_intInputs.size(); ++i) {
+		int intValue = intVariables[conn.m_intInputs[i].m_variableIndex];
+		if (skipUnchanged) {
+			if (conn.m_inputCacheValid && intValue == conn.m_intInputCache[i]) {
+				++skipCounter;
+				continue;
+			}
+			conn.m_intInputCache[i] = intValue;
+			conn.m_inputValueRefBuffer[count] = conn.m_intInputValueRefs[i];
 		}
-		for (unsigned int i=0; i<m_boolVariableMapping.size(); ++i) {
-			VariableMapping & varMap = m_boolVariableMapping[i];
-			// skip variables that are not inputs to selected slave
-			if (varMap.m_inputSlave == nullptr || varMap.m_inputSlave != slave) continue;
-			// set input in slave
-			varMap.m_inputSlave->setBoolean(varMap.m_inputValueReference, boolVariables[i]);
+		conn.m_intInputValues[count++] = intValue;
+	}
+	if (count != 0) {
+		slave->setIntegers(skipUnchanged ? &conn.m_inputValueRefBuffer[0] : &conn.m_intInputValueRefs[0],
+						   &conn.m_intInputValues[0], count);
+		setCounter += count;
+	}
+
+	count = 0;
+	for (unsigned int i=0; i<conn.m_boolInputs.size(); ++i) {
+		fmi2Boolean boolValue = boolVariables[conn.m_boolInputs[i].m_variableIndex];
+		if (skipUnchanged) {
+			if (conn.m_inputCacheValid && boolValue == conn.m_boolInputCache[i]) {
+				++skipCounter;
+				continue;
+			}
+			conn.m_boolInputCache[i] = boolValue;
+			conn.m_inputValueRefBuffer[count] = conn.m_boolInputValueRefs[i];
 		}
-		for (unsigned int i=0; i<m_stringVariableMapping.size(); ++i) {
-			VariableMapping & varMap = m_stringVariableMapping[i];
-			// skip variables that are not inputs to selected slave
-			if (varMap.m_inputSlave == nullptr || varMap.m_inputSlave != slave) continue;
-			// set input in slave
-			varMap.m_inputSlave->setString(varMap.m_inputValueReference, stringVariables[i]);
+		conn.m_boolInputValues[count++] = boolValue;
+	}
+	if (count != 0) {
+		slave->setBooleans(skipUnchanged ? &conn.m_inputValueRefBuffer[0] : &conn.m_boolInputValueRefs[0],
+						   &conn.m_boolInputValues[0], count);
+		setCounter += count;
+	}
+
+	// strings are set one-by-one
+	for (unsigned int i=0; i<conn.m_stringInputs.size(); ++i) {
+		const std::string & str = stringVariables[conn.m_stringInputs[i].m_variableIndex];
+		if (skipUnchanged) {
+			if (conn.m_inputCacheValid && str == conn.m_stringInputCache[i]) {
+				++skipCounter;
+				continue;
+			}
+			conn.m_stringInputCache[i] = str;
 		}
+		slave->setString(conn.m_stringInputValueRefs[i], str);
+		++setCounter;
 	}
+	conn.m_inputCacheValid = true;
+}
+
+
+void MasterSim::invalidateInputCache(const AbstractSlave * slave) {
+	IBK_ASSERT(slave->m_slaveIndex < m_slaveConnections.size());
+	SlaveConnections & conn = m_slaveConnections[slave->m_slaveIndex];
+	conn.m_realInputCacheValid = false;
+	conn.m_inputCacheValid = false;
 }
 
 
@@ -1483,36 +2296,18 @@ void MasterSim::syncSlaveOutputs(const AbstractSlave * slave,
 	IBK_ASSERT(intVariables.size() == m_intVariableMapping.size());
 	IBK_ASSERT(boolVariables.size() == m_boolVariableMapping.size());
 	IBK_ASSERT(stringVariables.size() == m_stringVariableMapping.size());
-	// process all connected variables
-	for (unsigned int i=0; i<m_realVariableMapping.size(); ++i) {
-		VariableMapping & varMap = m_realVariableMapping[i];
-		// skip variables that are not outputs of selected slave
-		if (varMap.m_outputSlave != slave) continue;
-		// copy local variable to global array
-		realVariables[i] = slave->m_doubleOutputs[varMap.m_outputLocalIndex];
-	}
+	IBK_ASSERT(slave->m_slaveIndex < m_slaveConnections.size());
+	const SlaveConnections & conn = m_slaveConnections[slave->m_slaveIndex];
+	// copy local variables of this slave to global arrays
+	for (const OutputConnection & c : conn.m_realOutputs)
+		realVariables[c.m_variableIndex] = slave->m_doubleOutputs[c.m_outputLocalIndex];
 	if (!realOnly) {
-		for (unsigned int i=0; i<m_intVariableMapping.size(); ++i) {
-			VariableMapping & varMap = m_intVariableMapping[i];
-			// skip variables that are not outputs of selected slave
-			if (varMap.m_outputSlave != slave) continue;
-			// copy local variable to global array
-			intVariables[i] = slave->m_intOutputs[varMap.m_outputLocalIndex];
-		}
-		for (unsigned int i=0; i<m_boolVariableMapping.size(); ++i) {
-			VariableMapping & varMap = m_boolVariableMapping[i];
-			// skip variables that are not outputs of selected slave
-			if (varMap.m_outputSlave != slave) continue;
-			// copy local variable to global array
-			boolVariables[i] = slave->m_boolOutputs[varMap.m_outputLocalIndex];
-		}
-		for (unsigned int i=0; i<m_stringVariableMapping.size(); ++i) {
-			VariableMapping & varMap = m_stringVariableMapping[i];
-			// skip variables that are not outputs of selected slave
-			if (varMap.m_outputSlave != slave) continue;
-			// copy local variable to global array
-			stringVariables[i] = slave->m_stringOutputs[varMap.m_outputLocalIndex];
-		}
+		for (const OutputConnection & c : conn.m_intOutputs)
+			intVariables[c.m_variableIndex] = slave->m_intOutputs[c.m_outputLocalIndex];
+		for (const OutputConnection & c : conn.m_boolOutputs)
+			boolVariables[c.m_variableIndex] = slave->m_boolOutputs[c.m_outputLocalIndex];
+		for (const OutputConnection & c : conn.m_stringOutputs)
+			stringVariables[c.m_variableIndex] = slave->m_stringOutputs[c.m_outputLocalIndex];
 	}
 }
 
@@ -1521,26 +2316,83 @@ void MasterSim::storeCurrentSlaveStates(std::vector<void *> & slaveStates) {
 	const char * const FUNC_ID = "[MasterSim::storeCurrentSlaveStates]";
 	IBK_FastMessage(IBK::VL_DETAILED)(IBK::FormatString("MASTER: Retrieving slave states at t=%1 (calling getFMUState() in FMI 2 slaves)\n")
 		.arg(m_t), IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_DETAILED);
-	IBK::StopWatch w;
-	for (unsigned int s=0; s<m_slaves.size(); ++s) {
-		AbstractSlave * slave = m_slaves[s];
-		w.start();
-		slave->currentState(&slaveStates[s]);
-		m_statStoreStateTimes[slave->m_slaveIndex] += 1e-3*w.stop(); // add elapsed time in seconds
-		++m_statStoreStateCounters[slave->m_slaveIndex];
+	if (m_parallelStateSlaves.empty()) {
+		for (unsigned int s : m_serialStateSlaves)
+			storeSlaveState(s, slaveStates);
+		return;
+	}
+	// task 0 processes all slaves that must not be accessed concurrently, one after another
+	m_threadPool.parallelFor((unsigned int)m_parallelStateSlaves.size() + 1, [&](unsigned int i) {
+		if (i == 0) {
+			for (unsigned int s : m_serialStateSlaves)
+				storeSlaveState(s, slaveStates);
+		}
+		else
+			storeSlaveState(m_parallelStateSlaves[i-1], slaveStates);
+	});
+}
+
+
+void MasterSim::storeSlaveState(unsigned int s, std::vector<void *> & slaveStates) {
+	// skip slaves that are never rolled back
+	if (!m_slaveStateCaptured[s])
+		return;
+	AbstractSlave * slave = m_slaves[s];
+	IBK::StopWatch & w = m_stateTimers[s];
+	w.start();
+	// existing states are updated in place by the FMU, only the first call allocates a new state
+	void * previousState = slaveStates[s];
+	slave->currentState(&slaveStates[s]);
+	m_statStoreStateTimes[s] += 1e-3*w.stop(); // add elapsed time in seconds
+	++m_statStoreStateCounters[s];
+	if (slaveStates[s] != nullptr) {
+		if (slaveStates[s] == previousState)
+			++m_statStateReuseCounters[s];
+		else
+			++m_statStateAllocCounters[s]; // new state, or FMU ignored the existing state
 	}
 }
 
 
 void MasterSim::restoreSlaveStates(double t, const std::vector<void*> & slaveStates) {
-	IBK::StopWatch w;
-	for (unsigned int s=0; s<m_slaves.size(); ++s) {
-		AbstractSlave * slave = m_slaves[s];
-		w.start();
-		slave->setState(t, slaveStates[slave->m_slaveIndex]);
-		m_statRollBackTimes[slave->m_slaveIndex] += 1e-3*w.stop(); // add elapsed time in seconds
-		++m_statRollBackCounters[slave->m_slaveIndex];
+	// slaves with cheap roll-back only reset their time
+	for (AbstractSlave * slave : m_slaves) {
+		if (slave->supportsCheapRollback()) {
+			slave->setState(t, nullptr);
+			invalidateInputCache(slave);
+		}
+	}
+	if (m_parallelStateSlaves.empty()) {
+		for (unsigned int s : m_serialStateSlaves)
+			restoreSlaveState(s, t, slaveStates);
+		return;
 	}
+	// task 0 processes all slaves that must not be accessed concurrently, one after another
+	m_threadPool.parallelFor((unsigned int)m_parallelStateSlaves.size() + 1, [&](unsigned int i) {
+		if (i == 0) {
+			for (unsigned int s : m_serialStateSlaves)
+				restoreSlaveState(s, t, slaveStates);
+		}
+		else
+			restoreSlaveState(m_parallelStateSlaves[i-1], t, slaveStates);
+	});
+}
+
+
+void MasterSim::restoreSlaveState(unsigned int s, double t, const std::vector<void*> & slaveStates) {
+	AbstractSlave * slave = m_slaves[s];
+	IBK::StopWatch & w = m_stateTimers[s];
+	w.start();
+	slave->setState(t, slaveStates[s]);
+	invalidateInputCache(slave);
+	m_statRollBackTimes[s] += 1e-3*w.stop(); // add elapsed time in seconds
+	++m_statRollBackCounters[s];
+}
+
+
+void MasterSim::releaseSlaveStates(std::vector<void*> & slaveStates) {
+	for (unsigned int s=0; s<slaveStates.size() && s<m_slaves.size(); ++s)
+		m_slaves[s]->freeState(&slaveStates[s]);
 }
 
 
@@ -1561,35 +2413,80 @@ void MasterSim::writeStepStatistics() {
 			   << std::setw(18) << std::left << "IterLimitExceeded" << '\t'
 			   << std::setw(12) << std::left << "FMUErrors" << '\t'
 			   << std::setw(18) << std::left << "ErrorNormRichardson" << '\t'
-			   << std::setw(18) << std::left << "ErrorNormSlopeCheck"
+			   << std::setw(18) << std::left << "ErrorNormSlopeCheck" << '\t'
+			   << std::setw(14) << std::left << "InputSets" << '\t'
+			   << std::setw(14) << std::left << "InputSetsSkipped" << '\t'
+			   << std::setw(14) << std::left << "JacGenerations" << '\t'
+			   << std::setw(14) << std::left << "JacUpdates"
 			   << std::endl;
 		return; // first call only writes header
 	}
-	std::ostream & out = *m_stepStatsOutput;
 	unsigned int maIters, maFMUErrs, maLimitExceeded;
 	m_masterAlgorithm->stats(maIters, maLimitExceeded, maFMUErrs);
+	unsigned int maJacGenerations, maJacUpdates;
+	m_masterAlgorithm->jacobianStats(maJacGenerations, maJacUpdates);
 	double h = m_h;
 	if (m_project.m_errorControlMode == Project::EM_STEP_DOUBLING)
 		h *= 2;
-	out << std::setw(14) << std::left << m_t << '\t'
-		   << std::setw(10) << std::left << m_statStepCounter << '\t'
-		   << std::setw(14) << std::left << h << '\t'
-		   << std::setw(18) << std::left << m_statAlgorithmCallCounter << '\t'
-		   << std::setw(18) << std::left << m_statErrorTestFailsCounter << '\t'
-		   << std::setw(18) << std::left << m_statConvergenceFailsCounter << '\t'
-		   << std::setw(12) << std::left << maIters << '\t'
-		   << std::setw(18) << std::left << maLimitExceeded << '\t'
-		   << std::setw(12) << std::left << maFMUErrs << '\t'
-		   << std::setw(18) << std::left << m_acceptedErrRichardson << '\t'
-		   << std::setw(18) << std::left << m_acceptedErrSlopeCheck << '\t'
-		   << std::endl;
+	unsigned int inputSets = 0, inputSetsSkipped = 0;
+	for (unsigned int i=0; i<m_slaves.size(); ++i) {
+		inputSets += m_statInputSetCounters[i];
+		inputSetsSkipped += m_statInputSkipCounters[i];
+	}
+	// compose line in re-usable buffer, same format as with std::setw(width) << std::left (default precision 6)
+	RowFormatter & row = m_stepStatsRow;
+	row.clear();
+	auto appendField = [&row](double value, size_t width) {
+		size_t start = row.size();
+		row.appendDouble(value, 6);
+		row.padTo(start, width);
+		row.appendChar('\t');
+	};
+	auto appendCounter = [&row](unsigned int value, size_t width) {
+		size_t start = row.size();
+		row.appendInt(value);
+		row.padTo(start, width);
+		row.appendChar('\t');
+	};
+	appendField(m_t, 14);
+	appendCounter(m_statStepCounter, 10);
+	appendField(h, 14);
+	appendCounter(m_statAlgorithmCallCounter, 18);
+	appendCounter(m_statErrorTestFailsCounter, 18);
+	appendCounter(m_statConvergenceFailsCounter, 18);
+	appendCounter(maIters, 12);
+	appendCounter(maLimitExceeded, 18);
+	appendCounter(maFMUErrs, 12);
+	appendField(m_acceptedErrRichardson, 18);
+	appendField(m_acceptedErrSlopeCheck, 18);
+	appendCounter(inputSets, 14);
+	appendCounter(inputSetsSkipped, 14);
+	appendCounter(maJacGenerations, 14);
+	appendCounter(maJacUpdates, 14);
+	row.appendChar('\n');
+	row.writeTo(*m_stepStatsOutput);
 }
 
 
 void MasterSim::freeSlaves() {
+	// no more slave evaluations from here on
+	m_threadPool.stop();
+	// write outputs still queued in output thread, also when simulation was aborted with an exception
+	try {
+		m_outputWriter.finishOutputs();
+	}
+	catch (IBK::Exception & ex) {
+		ex.writeMsgStackToError();
+	}
+	catch (std::exception & ex) {
+		IBK::IBK_Message(ex.what(), IBK::MSG_ERROR, "[MasterSim::freeSlaves]");
+	}
 	// wait a few seconds for the openMP threadpool spin to shut down before deleting the slaves
 	// see https://stackoverflow.com/questions/34439956/vc-crash-when-freeing-a-dll-built-with-openmp
 	if (!m_slaves.empty()) {
+		// release all states held by the master, while the slaves still exist
+		releaseSlaveStates(m_iterationStates);
+		releaseSlaveStates(m_errorCheckStates);
 		std::this_thread::sleep_for(std::chrono::milliseconds(500));
 		for (unsigned int i=0; i<m_slaves.size(); ++i)
 			delete m_slaves[i];
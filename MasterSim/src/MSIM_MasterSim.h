@@ -2,6 +2,7 @@
 #define MSIM_MASTERSIM_H
 
 #include <utility> // for std::pair
+#include <limits>
 
 #include <IBK_Path.h>
 #include <IBK_StopWatch.h>
@@ -12,6 +13,10 @@
 #include "MSIM_FMUManager.h"
 #include "MSIM_FMUSlave.h"
 #include "MSIM_OutputWriter.h"
+#include "MSIM_ThreadPool.h"
+#include "MSIM_CheckpointWriter.h"
+#include "MSIM_SnapshotBuffer.h"
+#include "MSIM_RowFormatter.h"
 
 
 /*! Namespace MASTER_SIM holds all classes, functions, types of the MasterSim library. */
@@ -48,18 +53,55 @@ public:
 	/*! (Re-)opens output files. */
 	void openOutputFiles(bool reopen);
 
-	/*! Restores state of master and all FMUs using data stored below state directory. */
-	void restoreState(double t, const IBK::Path & stateDirectory);
+	/*! Restores state of master and all FMUs from the checkpoint file within stateDirectory.
+		Must be called after initialize() and before openOutputFiles(true). Output files are truncated
+		to their size at the time of the checkpoint.
+	*/
+	void restoreState(const IBK::Path & stateDirectory);
 
-	/*! Serializes all FMUs and state of master to file within stateDirectory. */
+	/*! Serializes all FMUs and state of master to the checkpoint file within stateDirectory.
+		An existing checkpoint file is replaced.
+	*/
 	void storeState(const IBK::Path & stateDirectory);
 
+	/*! Directory where checkpoint files are written to. */
+	IBK::Path checkpointDirectory() const { return m_args.m_workingDir / "checkpoint"; }
+
+	/*! Stores the current state of master and all FMUs as in-memory snapshot (same data as checkpoints).
+		Called from simulate() every Project::m_snapshotStepInterval steps, may also be called directly
+		when driving the simulation with doStep(). Must be called after openOutputFiles().
+	*/
+	void takeSnapshot();
+
+	/*! Rewinds the simulation to the latest in-memory snapshot taken at or before time t.
+		Output files are truncated to their size at the time of the snapshot and snapshots taken after the
+		restored snapshot are discarded. Afterwards, the simulation can be continued with simulate() or doStep(),
+		for example after changing parameters of slaves with setSlaveParameter().
+		Throws an exception if no such snapshot exists.
+		\return Returns the simulation time of the restored snapshot.
+	*/
+	double restoreSnapshot(double t);
+
+	/*! Sets a tunable parameter of an FMU slave at the current simulation time, e.g. after restoreSnapshot().
+		The outputs of the slave are retrieved again, so that the next step uses outputs computed with the new value.
+		Mind that the value is part of the FMU state, hence restoring an earlier snapshot or a checkpoint also
+		restores the previous value (except for stateless slaves, whose state is not stored).
+		Throws an exception if the slave does not exist or if the variable is not a tunable parameter.
+		\param slaveName Name of the slave.
+		\param variableName Name of the parameter in the model description of the FMU.
+		\param value The value as string, decoded in the same way as parameter values in the project file.
+	*/
+	void setSlaveParameter(const std::string & slaveName, const std::string & variableName, const std::string & value);
+
 	/*! Contains the core simulation loop.
 		This is essentially a convenience function around doStep() calls.
 		This function calls doStep() until simulation time has reached/passed time point.
 		After each successful step, the function writeOutputs() is called.
+		\param tStop If given, the simulation is stopped after the first step reaching this time point (before the
+			end time of the project, no final outputs are written). Outputs and the last checkpoint are written
+			completely, so that the simulation can be resumed with restoreState() (used for testing restarts).
 	*/
-	void simulate();
+	void simulate(double tStop = std::numeric_limits<double>::max());
 
 	/*! Returns current time point (of master state). */
 	double tCurrent() const { return m_t; }
@@ -103,6 +145,15 @@ private:
 			\note Pointers are not owned.
 		*/
 		std::vector<AbstractSlave*>			m_slaves;
+
+		/*! Indexes of all variables of type real that are outputs of slaves in this cycle (sorted). */
+		std::vector<unsigned int>			m_realOutputs;
+		/*! Indexes of all variables of type int that are outputs of slaves in this cycle (sorted). */
+		std::vector<unsigned int>			m_intOutputs;
+		/*! Indexes of all variables of type bool that are outputs of slaves in this cycle (sorted). */
+		std::vector<unsigned int>			m_boolOutputs;
+		/*! Indexes of all variables of type string that are outputs of slaves in this cycle (sorted). */
+		std::vector<unsigned int>			m_stringOutputs;
 	};
 
 	/*! Variable mapping structure, used to map exchange quantities between FMUs for the different data types. */
@@ -127,6 +178,70 @@ private:
 		double		m_offset;
 	};
 
+	/*! Connection of an exchange variable to an input of a slave (part of SlaveConnections). */
+	struct InputConnection {
+		/*! Index of exchange variable in vector of respective type (e.g. m_realyt). */
+		unsigned int	m_variableIndex;
+		/*! Scale factor, inputValue = m_offset + m_scaleFactor*outputValue. */
+		double			m_scaleFactor;
+		/*! Offset, inputValue = m_offset + m_scaleFactor*outputValue. */
+		double			m_offset;
+	};
+
+	/*! Connection of a slave output to an exchange variable (part of SlaveConnections). */
+	struct OutputConnection {
+		/*! Index of exchange variable in vector of respective type (e.g. m_realyt). */
+		unsigned int	m_variableIndex;
+		/*! Index of variable slot in locally cached output variables vector of slave. */
+		unsigned int	m_outputLocalIndex;
+	};
+
+	/*! Holds all connections of a single slave, sorted by data type.
+		These tables are extracted from the variable mappings in composeVariableVector() so that
+		updateSlaveInputs() and syncSlaveOutputs() only process variables of the respective slave.
+		Within each vector, connections are ordered by increasing variable index.
+
+		Value references of the inputs are stored in separate vectors (same size/order as the respective
+		input connection vectors), so that all inputs of one type can be passed to the slave with a single
+		call. The values are collected in the preallocated value buffers.
+	*/
+	struct SlaveConnections {
+		std::vector<InputConnection>	m_realInputs;
+		std::vector<InputConnection>	m_intInputs;
+		std::vector<InputConnection>	m_boolInputs;
+		std::vector<InputConnection>	m_stringInputs;
+
+		std::vector<unsigned int>		m_realInputValueRefs;
+		std::vector<unsigned int>		m_intInputValueRefs;
+		std::vector<unsigned int>		m_boolInputValueRefs;
+		std::vector<unsigned int>		m_stringInputValueRefs;
+
+		std::vector<double>				m_realInputValues;
+		std::vector<int>				m_intInputValues;
+		std::vector<fmi2Boolean>		m_boolInputValues;
+		/*! Buffer for value references of inputs that are actually set (when skipping unchanged inputs). */
+		std::vector<unsigned int>		m_inputValueRefBuffer;
+
+		/*! Input values last passed to the slave (only used when skipping unchanged inputs). */
+		std::vector<double>				m_realInputCache;
+		std::vector<int>				m_intInputCache;
+		std::vector<fmi2Boolean>		m_boolInputCache;
+		std::vector<std::string>		m_stringInputCache;
+		/*! Tolerance for detecting changed real inputs, Project::m_inputChangeTolerance or 0 for slaves in
+			iterated cycles (see composeVariableVector()).
+		*/
+		double							m_inputChangeTolerance = 0;
+		/*! If false, m_realInputCache is invalid and all real inputs must be set. */
+		bool							m_realInputCacheValid = false;
+		/*! If false, the int, bool and string input caches are invalid and all these inputs must be set. */
+		bool							m_inputCacheValid = false;
+
+		std::vector<OutputConnection>	m_realOutputs;
+		std::vector<OutputConnection>	m_intOutputs;
+		std::vector<OutputConnection>	m_boolOutputs;
+		std::vector<OutputConnection>	m_stringOutputs;
+	};
+
 	/*! This function handles the FMU unzipping and shared library loading stuff. */
 	void importFMUs();
 
@@ -147,12 +262,37 @@ private:
 	*/
 	AbstractSlave * splitFlatVariableName(const std::string & flatVarName, std::string & varname) const;
 
+	/*! Determines cycles from connection graph and either uses these cycles or the user-defined cycles,
+		depending on project setting. Populates m_cycles.
+	*/
+	void setupCycles();
+
 	/*! Collects all output variables from all slaves and adds them to the variables vector, ordered according to cycles. */
 	void composeVariableVector();
 
+	/*! Collects the output variables of all cycles and determines which cycles exchange variables with each other.
+		Populates the output variable vectors in m_cycles and m_cycleSuccessors.
+	*/
+	void setupCycleDependencies();
+
+	/*! Adds input and output connections of all variable mappings in 'mappings' to the per-slave connection
+		tables in m_slaveConnections.
+		\param mappings Variable mappings of one data type.
+		\param inputs Member pointer to input connection vector of this data type.
+		\param inputValueRefs Member pointer to input value reference vector of this data type.
+		\param outputs Member pointer to output connection vector of this data type.
+	*/
+	void addSlaveConnections(const std::vector<VariableMapping> & mappings,
+							 std::vector<InputConnection> SlaveConnections::* inputs,
+							 std::vector<unsigned int> SlaveConnections::* inputValueRefs,
+							 std::vector<OutputConnection> SlaveConnections::* outputs);
+
 	/*! Initializes the master algorithm. */
 	void initMasterAlgorithm();
 
+	/*! Determines for which slaves the state must be stored before each step (populates m_slaveStateCaptured). */
+	void setupStateCapture();
+
 	/*! This generates default parameters recognized by the master.
 		The parameters will be set for each FMU that imports the matching parameter and
 		a value was not yet specified by the user manually.
@@ -223,6 +363,12 @@ private:
 						   const std::vector<std::string> &stringVariables,
 						   bool realOnly);
 
+	/*! Marks the cached input values of a slave as invalid, so that all inputs are set in the next call
+		to updateSlaveInputs(). Must be called whenever the slave state has been reset, since this also
+		resets the inputs of the slave.
+	*/
+	void invalidateInputCache(const AbstractSlave * slave);
+
 	/*! Copies all connected outputs of a given slave into the vector 'variables'. */
 	void syncSlaveOutputs(const AbstractSlave * slave,
 						  std::vector<double> & realVariables,
@@ -231,15 +377,38 @@ private:
 						  std::vector<std::string> & stringVariables,
 						  bool realOnly);
 
-	/*! Loops over all slaves and retrieves current states. */
+	/*! Serializes states of all slaves, master variables, statistics and output writer state into data
+		(content of checkpoint files and snapshots). Output file sizes are not included, they are recorded
+		asynchronously by the output writer (see OutputWriter::addFileSizeMarker()).
+	*/
+	void serializeMasterState(std::vector<char> & data);
+
+	/*! Restores state of master and all slaves from data created by serializeMasterState().
+		\param data Serialized state.
+	*/
+	void deserializeMasterState(const std::vector<char> & data);
+
+	/*! Loops over all slaves and retrieves current states (only slaves flagged in m_slaveStateCaptured).
+		States of slaves in m_parallelStateSlaves are retrieved concurrently by the thread pool.
+	*/
 	void storeCurrentSlaveStates(std::vector<void *> & slaveStates);
 
+	/*! Retrieves current state of a single slave and updates its statistics. */
+	void storeSlaveState(unsigned int slaveIndex, std::vector<void *> & slaveStates);
+
 	/*! Loops over all slaves and restores state from saved states.
+		States of slaves in m_parallelStateSlaves are restored concurrently by the thread pool.
 		This will not automatically cache the slave outputs and sync with the
 		variable vectors.
 	*/
 	void restoreSlaveStates(double t, const std::vector<void*> & slaveStates);
 
+	/*! Restores state of a single slave and updates its statistics. */
+	void restoreSlaveState(unsigned int slaveIndex, double t, const std::vector<void*> & slaveStates);
+
+	/*! Releases all slave states in vector slaveStates (states are set to nullptr). */
+	void releaseSlaveStates(std::vector<void*> & slaveStates);
+
 	/*! Creates statistics files and appends statistics.
 		This function is called once after each completed doStep();
 	*/
@@ -275,9 +444,18 @@ private:
 	/*! All cycles in order of their evaluation priority. */
 	std::vector<Cycle>		m_cycles;
 
+	/*! Dependency graph between cycles used for parallel evaluation of cycles, m_cycleSuccessors[c] holds the indexes
+		of all cycles after c that exchange variables (in either direction) with cycle c. Cycles that do not depend
+		on each other can be evaluated in parallel without changing the results.
+	*/
+	std::vector< std::vector<unsigned int> >	m_cycleSuccessors;
+
 	/*! Pointer to the actual master algorithm implementation (owned). */
 	AbstractAlgorithm		*m_masterAlgorithm = nullptr;
 
+	/*! Worker threads for parallel evaluation of slaves (only started when m_project.m_threadCount > 1). */
+	ThreadPool				m_threadPool;
+
 	/*! Current simulation time point. */
 	double					m_t;
 
@@ -290,8 +468,20 @@ private:
 	/*! Manager of output files, handles all output file writing. */
 	OutputWriter			m_outputWriter;
 
+	/*! Writes checkpoint files in background. */
+	CheckpointWriter		m_checkpointWriter;
+
+	/*! Ring buffer with in-memory snapshots. */
+	SnapshotBuffer			m_snapshots;
+	/*! Buffer for serialized master state when taking or restoring snapshots. */
+	std::vector<char>		m_snapshotData;
+	/*! Buffer for serialized slave state, used in serializeMasterState() and deserializeMasterState(). */
+	std::vector<char>		m_serializedSlaveState;
+
 	/*! Output file stream for master statistics. */
 	std::ofstream			*m_stepStatsOutput = nullptr;
+	/*! Buffer for composing lines of step statistics file. */
+	RowFormatter			m_stepStatsRow;
 
 	/*! Mapping of all connected variables of type real. */
 	std::vector<VariableMapping>	m_realVariableMapping;
@@ -302,6 +492,9 @@ private:
 	/*! Mapping of all connected variables of type string. */
 	std::vector<VariableMapping>	m_stringVariableMapping;
 
+	/*! Connection tables for each slave (index matches m_slaveIndex), generated from the variable mappings. */
+	std::vector<SlaveConnections>	m_slaveConnections;
+
 	// exchange variables of type real
 
 	/*! Slave variables (input and output) at current master time. */
@@ -364,23 +557,47 @@ private:
 	/*! Error norm that was determined by slope-check to confirm the step. */
 	double							m_acceptedErrSlopeCheck;
 
-	/*! Vector for holding states of FMU slaves at begin of master algorithm to roll back during iterations. */
+	/*! Vector for holding states of FMU slaves at begin of master algorithm to roll back during iterations.
+		The states in m_iterationStates and m_errorCheckStates form a fixed pool of two state handles per slave:
+		they are allocated on first use, updated in place afterwards (vectors are only swapped, never copied)
+		and released in freeSlaves().
+	*/
 	std::vector<void*>				m_iterationStates;
 	/*! Vector for holding states of FMU slaves at begin of error check interval to roll back when error check has failed. */
 	std::vector<void*>				m_errorCheckStates;
+	/*! Flag per slave, true if the slave state is stored in storeCurrentSlaveStates(). States of stateless slaves
+		are never stored, states of other slaves only when the master iterates or uses error control.
+	*/
+	std::vector<bool>				m_slaveStateCaptured;
+	/*! Indexes of slaves whose states may be retrieved/restored concurrently with other slaves (opted in with
+		'parallelStates' in the project file, cheap roll-back slaves excluded).
+	*/
+	std::vector<unsigned int>		m_parallelStateSlaves;
+	/*! Indexes of all other slaves without cheap roll-back, their states are retrieved/restored sequentially. */
+	std::vector<unsigned int>		m_serialStateSlaves;
+	/*! Timers for state retrieval/restoration, one per slave so that slaves can be processed concurrently. */
+	std::vector<IBK::StopWatch>		m_stateTimers;
 
 	/*! Counts for roll backs of all slaves (size nSlaves). */
 	std::vector<unsigned int>		m_statRollBackCounters;
-	/*! Time taken while setState() calls to all slaves during iteration (not Jacobi matrix setup). */
+	/*! Time taken while setState() calls to all slaves during iteration and Jacobian matrix setup (size nSlaves). */
 	std::vector<double>				m_statRollBackTimes;
 	/*! Counts for setting states of all slaves (size nSlaves). */
 	std::vector<unsigned int>		m_statStoreStateCounters;
 	/*! Time taken while currentState() calls to all slaves during iteration (not Jacobi matrix setup). */
 	std::vector<double>				m_statStoreStateTimes;
+	/*! Number of currentState() calls per slave that allocated a new state. */
+	std::vector<unsigned int>		m_statStateAllocCounters;
+	/*! Number of currentState() calls per slave that updated an existing state in place. */
+	std::vector<unsigned int>		m_statStateReuseCounters;
 	/*! Counts for slave evaluation of all slaves (size nSlaves). */
 	std::vector<unsigned int>		m_statSlaveEvalCounters;
 	/*! Time taken while doStep() calls to all slaves during iteration (not Jacobi matrix setup). */
 	std::vector<double>				m_statSlaveEvalTimes;
+	/*! Counts for input values set in all slaves (size nSlaves). */
+	std::vector<unsigned int>		m_statInputSetCounters;
+	/*! Counts for input values not set because they were unchanged (size nSlaves). */
+	std::vector<unsigned int>		m_statInputSkipCounters;
 
 	IBK::StopWatch					m_timer;
 
@@ -391,6 +608,12 @@ private:
 	double							m_statErrorTestTime;
 	unsigned int					m_statStepCounter;
 	unsigned int					m_statAlgorithmCallCounter;
+	/*! Time the simulation was blocked by checkpoints (capturing data and waiting for previous checkpoint to be written). */
+	double							m_statCheckpointTime;
+	unsigned int					m_statCheckpointCounter;
+	/*! Time needed for taking in-memory snapshots (not restored from snapshots/checkpoints). */
+	double							m_statSnapshotTime;
+	unsigned int					m_statSnapshotCounter;
 
 
 	/*! Utility function to copy one vector to another using memcpy. */
@@ -403,6 +626,7 @@ private:
 		std::memcpy(&target[0], &src[0], src.size()*sizeof(T));
 	}
 
+	friend class AbstractAlgorithm;
 	friend class AlgorithmGaussJacobi;
 	friend class AlgorithmGaussSeidel;
 	friend class AlgorithmNewton;
@@ -0,0 +1,79 @@
+#include "MSIM_OutputAggregator.h"
+
+#include <IBK_assert.h>
+
+namespace MASTER_SIM {
+
+void OutputAggregator::resize(unsigned int n) {
+	m_tStart = 0;
+	m_tLast = 0;
+	m_started = false;
+	m_last.assign(n, 0);
+	m_integral.assign(n, 0);
+	m_min.assign(n, 0);
+	m_max.assign(n, 0);
+}
+
+
+void OutputAggregator::addSample(double t, const double * values) {
+	const unsigned int n = size();
+	if (n == 0)
+		return;
+	double * last = &m_last[0];
+	if (!m_started) {
+		for (unsigned int i=0; i<n; ++i)
+			last[i] = values[i];
+		m_tStart = m_tLast = t;
+		m_started = true;
+		restart();
+		return;
+	}
+	IBK_ASSERT(t >= m_tLast);
+	double * integral = &m_integral[0];
+	double * minValues = &m_min[0];
+	double * maxValues = &m_max[0];
+	const double halfStep = 0.5*(t - m_tLast);
+	// Note: loop without branches, so that it can be vectorized
+	for (unsigned int i=0; i<n; ++i) {
+		double v = values[i];
+		integral[i] += halfStep*(last[i] + v);
+		minValues[i] = v < minValues[i] ? v : minValues[i];
+		maxValues[i] = v > maxValues[i] ? v : maxValues[i];
+		last[i] = v;
+	}
+	m_tLast = t;
+}
+
+
+void OutputAggregator::restart() {
+	m_tStart = m_tLast;
+	m_integral.assign(m_integral.size(), 0);
+	m_min = m_last;
+	m_max = m_last;
+}
+
+
+void OutputAggregator::result(const std::vector<AggregationMode> & modes, double * out) const {
+	const unsigned int n = size();
+	const double duration = m_tLast - m_tStart;
+	for (unsigned int i=0; i<n; ++i) {
+		for (unsigned int m=0; m<modes.size(); ++m) {
+			switch (modes[m]) {
+				case AM_MEAN :
+					*out++ = duration > 0 ? m_integral[i]/duration : m_last[i];
+				break;
+				case AM_MIN :
+					*out++ = m_min[i];
+				break;
+				case AM_MAX :
+					*out++ = m_max[i];
+				break;
+				case AM_INTEGRAL :
+					*out++ = m_integral[i];
+				break;
+			}
+		}
+	}
+}
+
+} // namespace MASTER_SIM
@@ -0,0 +1,76 @@
+#ifndef MSIM_OUTPUTAGGREGATOR_H
+#define MSIM_OUTPUTAGGREGATOR_H
+
+#include <vector>
+
+namespace MASTER_SIM {
+
+/*! Accumulates running statistics of output variables over an output interval.
+
+	The master passes the values of all aggregated variables after each accepted master step to addSample().
+	For each variable, the aggregator keeps the integral over time (trapezoidal rule between samples),
+	minimum and maximum of all samples since the start of the interval. When the output row is written,
+	result() returns the time-weighted mean, minimum, maximum or integral, and restart() starts the next
+	interval with the last sample.
+
+	All statistics are stored as separate arrays (one value per variable), so that the update loop
+	in addSample() processes contiguous memory and can be vectorized by the compiler.
+*/
+class OutputAggregator {
+public:
+	/*! Statistics that can be computed for an interval. */
+	enum AggregationMode {
+		/*! Time-weighted mean value. */
+		AM_MEAN,
+		/*! Minimum value. */
+		AM_MIN,
+		/*! Maximum value. */
+		AM_MAX,
+		/*! Integral over time (value unit * s). */
+		AM_INTEGRAL
+	};
+
+	/*! Constructor. */
+	OutputAggregator() : m_tStart(0), m_tLast(0), m_started(false) {}
+
+	/*! Resizes all arrays for the given number of variables and discards all statistics. */
+	void resize(unsigned int n);
+
+	/*! Number of aggregated variables. */
+	unsigned int size() const { return (unsigned int)m_last.size(); }
+
+	/*! Adds values of all variables at time t, the first call starts the interval.
+		\param t Simulation time in seconds, must not be less than the time of the previous sample.
+		\param values Pointer to size() values.
+	*/
+	void addSample(double t, const double * values);
+
+	/*! Starts a new interval at the time of the last sample, statistics only include the last sample afterwards. */
+	void restart();
+
+	/*! Stores the statistics of a variable for the current interval.
+		For an interval of zero length, the mean value is the value of the last sample.
+		\param modes Statistics to compute.
+		\param out Target, receives size() * modes.size() values (all statistics of a variable are stored consecutively).
+	*/
+	void result(const std::vector<AggregationMode> & modes, double * out) const;
+
+	/*! Start time of current interval in seconds. */
+	double					m_tStart;
+	/*! Time of last sample in seconds. */
+	double					m_tLast;
+	/*! True, once the first sample has been added. */
+	bool					m_started;
+	/*! Values of last sample. */
+	std::vector<double>		m_last;
+	/*! Integral over time since interval start. */
+	std::vector<double>		m_integral;
+	/*! Minimum values since interval start. */
+	std::vector<double>		m_min;
+	/*! Maximum values since interval start. */
+	std::vector<double>		m_max;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_OUTPUTAGGREGATOR_H
@@ -0,0 +1,82 @@
+#include "MSIM_OutputFilter.h"
+
+#include <IBK_Exception.h>
+#include <IBK_StringUtils.h>
+
+namespace MASTER_SIM {
+
+void OutputFilter::setPatterns(const std::vector<std::string> & patterns) {
+	const char * const FUNC_ID = "[OutputFilter::setPatterns]";
+	m_patterns.clear();
+	m_hasIncludePatterns = false;
+	for (unsigned int i=0; i<patterns.size(); ++i) {
+		std::string p = patterns[i];
+		IBK::trim(p);
+		if (p.empty())
+			continue;
+		Pattern pat;
+		pat.m_exclude = (p[0] == '!');
+		if (pat.m_exclude)
+			p = p.substr(1);
+		pat.m_isRegex = (p.find("re:") == 0);
+		if (pat.m_isRegex) {
+			try {
+				pat.m_regex = std::regex(p.substr(3), std::regex::ECMAScript | std::regex::optimize);
+			}
+			catch (std::regex_error & ex) {
+				throw IBK::Exception(IBK::FormatString("Invalid regular expression in output filter '%1': %2")
+									 .arg(patterns[i]).arg(ex.what()), FUNC_ID);
+			}
+		}
+		else
+			pat.m_glob = p;
+		if (!pat.m_exclude)
+			m_hasIncludePatterns = true;
+		m_patterns.push_back(pat);
+	}
+}
+
+
+bool OutputFilter::matches(const std::string & flatName) const {
+	bool selected = !m_hasIncludePatterns;
+	for (unsigned int i=0; i<m_patterns.size(); ++i) {
+		const Pattern & pat = m_patterns[i];
+		bool match;
+		if (pat.m_isRegex)
+			match = std::regex_match(flatName, pat.m_regex);
+		else
+			match = globMatch(pat.m_glob.c_str(), flatName.c_str());
+		if (match)
+			selected = !pat.m_exclude;
+	}
+	return selected;
+}
+
+
+bool OutputFilter::globMatch(const char * pattern, const char * str) {
+	// iterative matching, backtracks only to the last '*'
+	const char * starPattern = nullptr;
+	const char * starStr = nullptr;
+	while (*str != 0) {
+		if (*pattern == '*') {
+			starPattern = ++pattern;
+			starStr = str;
+		}
+		else if (*pattern == '?' || *pattern == *str) {
+			++pattern;
+			++str;
+		}
+		else if (starPattern != nullptr) {
+			// let the last '*' match one more character
+			pattern = starPattern;
+			str = ++starStr;
+		}
+		else
+			return false;
+	}
+	while (*pattern == '*')
+		++pattern;
+	return *pattern == 0;
+}
+
+} // namespace MASTER_SIM
@@ -0,0 +1,65 @@
+#ifndef MSIM_OUTPUTFILTER_H
+#define MSIM_OUTPUTFILTER_H
+
+#include <vector>
+#include <string>
+#include <regex>
+
+namespace MASTER_SIM {
+
+/*! Selects output variables by their flat names (<slave name>.<variable name>).
+
+	Patterns are either glob patterns, where '*' matches any sequence of characters (including '.')
+	and '?' matches a single character, or regular expressions with prefix 're:' (ECMAScript syntax,
+	must match the entire name). A leading '!' turns a pattern into an exclusion pattern.
+
+	Patterns are evaluated in the given order, the last matching pattern decides. Names not matched
+	by any pattern are selected only if there are no including patterns at all, so that
+	\code
+	zone*.T*
+	!*.der(*)
+	\endcode
+	selects all variables of slaves named 'zone...' starting with 'T', except derivatives, and
+	'!*.der(*)' alone selects all variables except derivatives.
+
+	The filter is only evaluated during setup, the resulting variable lists are used during the simulation.
+*/
+class OutputFilter {
+public:
+	/*! Constructor, creates an empty filter (selects all variables). */
+	OutputFilter() : m_hasIncludePatterns(false) {}
+
+	/*! Parses and compiles patterns, throws an IBK::Exception for invalid regular expressions. */
+	void setPatterns(const std::vector<std::string> & patterns);
+
+	/*! Returns true, if no patterns are defined (all variables are selected). */
+	bool empty() const { return m_patterns.empty(); }
+
+	/*! Returns true, if the variable with the given flat name is selected. */
+	bool matches(const std::string & flatName) const;
+
+	/*! Glob pattern matching with wildcards '*' and '?' (entire string must match). */
+	static bool globMatch(const char * pattern, const char * str);
+
+private:
+	/*! A compiled pattern. */
+	struct Pattern {
+		/*! True for exclusion patterns (prefix '!'). */
+		bool			m_exclude;
+		/*! True for regular expressions (prefix 're:'). */
+		bool			m_isRegex;
+		/*! Glob pattern (without prefixes). */
+		std::string		m_glob;
+		/*! Compiled regular expression. */
+		std::regex		m_regex;
+	};
+
+	/*! All patterns in order of definition. */
+	std::vector<Pattern>	m_patterns;
+	/*! True, if at least one pattern is not an exclusion pattern. */
+	bool					m_hasIncludePatterns;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_OUTPUTFILTER_H
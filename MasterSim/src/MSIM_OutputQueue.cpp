@@ -0,0 +1,193 @@
+#include "MSIM_OutputQueue.h"
+
+#include <algorithm>
+
+#include <IBK_assert.h>
+#include <IBK_Exception.h>
+
+namespace MASTER_SIM {
+
+void OutputFileSizeMarker::record(int64_t valuesSize, int64_t stringsSize, int64_t binarySize, const CompressedResultFrame & pendingRows) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_valuesSize = valuesSize;
+	m_stringsSize = stringsSize;
+	m_binarySize = binarySize;
+	m_pendingRows = pendingRows;
+	m_recorded = true;
+	m_recordedCondition.notify_all();
+}
+
+
+void OutputFileSizeMarker::fail() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_failed = true;
+	m_recorded = true;
+	m_recordedCondition.notify_all();
+}
+
+
+void OutputFileSizeMarker::wait() const {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_recorded)
+		m_recordedCondition.wait(lock);
+	if (m_failed)
+		throw IBK::Exception("Output files have not been written completely, file sizes are not available.", "[OutputFileSizeMarker::wait]");
+}
+
+
+OutputQueue::OutputQueue() :
+	m_mode(QM_BLOCK),
+	m_pushToOverflow(false),
+	m_popFromOverflow(false),
+	m_head(0),
+	m_tail(0),
+	m_pushedRows(0),
+	m_poppedRows(0),
+	m_droppedRows(0),
+	m_maxOverflowRows(0),
+	m_overflowUsed(false),
+	m_consumerWaiting(false),
+	m_producerWaiting(false),
+	m_shutdown(false)
+{
+}
+
+
+void OutputQueue::setup(unsigned int capacity, QueueMode mode, const OutputRow & prototype) {
+	IBK_ASSERT(capacity > 0);
+	IBK_ASSERT(m_pushedRows == m_poppedRows);
+	m_ring.assign(capacity, prototype);
+	m_growRow = prototype;
+	m_mode = mode;
+	m_head = 0;
+	m_tail = 0;
+	m_pushedRows = 0;
+	m_poppedRows = 0;
+	m_droppedRows = 0;
+	m_maxOverflowRows = 0;
+}
+
+
+OutputRow * OutputQueue::beginPush(bool allowDrop) {
+	// once rows are in the overflow list, all further rows must go there as well to keep the order
+	if (m_overflowUsed) {
+		m_pushToOverflow = true;
+		return &m_growRow;
+	}
+	uint64_t head = m_head.load(std::memory_order_relaxed);
+	uint64_t capacity = m_ring.size();
+	m_pushToOverflow = false;
+	if (head - m_tail < capacity)
+		return &m_ring[head % capacity];
+
+	// ring buffer is full
+	if (m_mode == QM_DROP && allowDrop) {
+		++m_droppedRows;
+		return nullptr;
+	}
+	if (m_mode == QM_GROW) {
+		m_pushToOverflow = true;
+		return &m_growRow;
+	}
+	// QM_BLOCK mode or row must not be dropped
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_producerWaiting = true;
+	while (head - m_tail >= capacity)
+		m_rowProcessed.wait(lock);
+	m_producerWaiting = false;
+	return &m_ring[head % capacity];
+}
+
+
+void OutputQueue::endPush() {
+	if (m_pushToOverflow) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_overflow.push_back(m_growRow);
+		m_maxOverflowRows = std::max(m_maxOverflowRows, m_overflow.size());
+		m_overflowUsed = true;
+		++m_pushedRows;
+		m_rowAvailable.notify_one();
+		return;
+	}
+	m_head = m_head.load(std::memory_order_relaxed) + 1;
+	++m_pushedRows;
+	notifyConsumer();
+}
+
+
+OutputRow * OutputQueue::beginPop() {
+	while (true) {
+		uint64_t tail = m_tail.load(std::memory_order_relaxed);
+		if (m_head != tail) {
+			m_popFromOverflow = false;
+			return &m_ring[tail % m_ring.size()];
+		}
+		std::unique_lock<std::mutex> lock(m_mutex);
+		// the producer only uses the overflow list while the ring buffer is full, so all rows in the
+		// ring buffer are older than those in the overflow list
+		if (m_head != tail)
+			continue;
+		if (!m_overflow.empty()) {
+			std::swap(m_overflowPopRow, m_overflow.front());
+			m_overflow.pop_front();
+			if (m_overflow.empty())
+				m_overflowUsed = false;
+			m_popFromOverflow = true;
+			return &m_overflowPopRow;
+		}
+		if (m_shutdown)
+			return nullptr;
+		// check again after announcing that we wait, the producer publishes ring buffer rows without lock
+		m_consumerWaiting = true;
+		if (m_head == tail)
+			m_rowAvailable.wait(lock);
+		m_consumerWaiting = false;
+	}
+}
+
+
+void OutputQueue::endPop() {
+	if (!m_popFromOverflow)
+		m_tail = m_tail.load(std::memory_order_relaxed) + 1;
+	++m_poppedRows;
+	notifyProducer();
+}
+
+
+void OutputQueue::waitUntilEmpty() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_producerWaiting = true;
+	while (m_poppedRows != m_pushedRows)
+		m_rowProcessed.wait(lock);
+	m_producerWaiting = false;
+}
+
+
+void OutputQueue::shutdown() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_shutdown = true;
+	m_rowAvailable.notify_one();
+}
+
+
+void OutputQueue::restart() {
+	m_shutdown = false;
+}
+
+
+void OutputQueue::notifyConsumer() {
+	if (m_consumerWaiting) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_rowAvailable.notify_one();
+	}
+}
+
+
+void OutputQueue::notifyProducer() {
+	if (m_producerWaiting) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_rowProcessed.notify_one();
+	}
+}
+
+} // namespace MASTER_SIM
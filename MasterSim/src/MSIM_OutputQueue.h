@@ -0,0 +1,196 @@
+#ifndef MSIM_OUTPUTQUEUE_H
+#define MSIM_OUTPUTQUEUE_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "MSIM_CompressedResults.h"
+
+namespace MASTER_SIM {
+
+/*! Sizes of the output files at a certain position in the sequence of output rows, used to truncate
+	the files when restarting or rewinding a simulation.
+
+	The marker is put into the output queue (see OutputWriter::addFileSizeMarker()) and the sizes are recorded
+	by the output thread once all rows queued before the marker have been written. Thus, the simulation does not
+	have to wait for the output thread. Other threads use wait() before accessing the sizes.
+*/
+class OutputFileSizeMarker {
+public:
+	/*! Constructor.
+		\param flush If true, output files are flushed and pending rows of the compressed result file are
+			compressed into a frame before the sizes are recorded, so that the files can be truncated at this
+			position even after the simulation has been aborted (needed for checkpoints).
+	*/
+	explicit OutputFileSizeMarker(bool flush) :
+		m_flush(flush), m_valuesSize(0), m_stringsSize(0), m_binarySize(0), m_recorded(false), m_failed(false) {}
+
+	/*! Stores the sizes and wakes up waiting threads (called by the output writer). */
+	void record(int64_t valuesSize, int64_t stringsSize, int64_t binarySize, const CompressedResultFrame & pendingRows);
+	/*! Marks the sizes as not available since writing of outputs has failed (called by the output writer). */
+	void fail();
+
+	/*! Waits until the sizes have been recorded.
+		Throws an exception if writing of outputs has failed before the marker was reached.
+	*/
+	void wait() const;
+
+	/*! If true, files are flushed before the sizes are recorded. */
+	const bool				m_flush;
+
+	/*! Size of file 'values.csv' or, for 'values.csv.gz', position of the first row not yet compressed into a frame
+		(0, if not written).
+	*/
+	int64_t					m_valuesSize;
+	/*! Size of file 'strings.csv' (0, if not written). */
+	int64_t					m_stringsSize;
+	/*! Size of file 'values.bin' (0, if not written). */
+	int64_t					m_binarySize;
+	/*! 'values.csv.gz' only: rows not yet compressed into a frame (see CompressedResultWriter::pendingRows()). */
+	CompressedResultFrame	m_pendingRows;
+
+private:
+	/*! Guards m_recorded and m_failed. */
+	mutable std::mutex				m_mutex;
+	/*! Signals that the sizes have been recorded. */
+	mutable std::condition_variable	m_recordedCondition;
+	/*! Set once the sizes have been recorded. */
+	bool							m_recorded;
+	/*! Set if writing of outputs has failed. */
+	bool							m_failed;
+};
+
+
+/*! Data of one output row, copied from the slaves when outputs are scheduled. */
+struct OutputRow {
+	/*! Simulation time in seconds. */
+	double						m_t;
+	/*! All number outputs: time in output time unit, then boolean, integer and real values. */
+	std::vector<double>			m_values;
+	/*! All string outputs. */
+	std::vector<std::string>	m_strings;
+	/*! Set for marker rows only (no output values), which request the file sizes at this position. */
+	std::shared_ptr<OutputFileSizeMarker>	m_marker;
+};
+
+
+/*! Single-producer/single-consumer queue of output rows, used to hand over rows from the simulation
+	thread to the output thread.
+
+	Rows are stored in a ring buffer with a fixed number of pre-allocated slots. The producer fills the
+	slot returned by beginPush() in place and publishes it with endPush(), the consumer processes the slot
+	returned by beginPop() and releases it with endPop(). Slot indexes are exchanged via atomics, a mutex is
+	only used when one side needs to wait for the other.
+
+	When the ring buffer is full, the behavior depends on the mode:
+	- QM_BLOCK: the producer waits until the consumer has released a slot,
+	- QM_DROP: the row is dropped (beginPush() returns nullptr) and counted in droppedRows(),
+	- QM_GROW: the row is appended to an unbounded overflow list, which the consumer processes once the
+	  ring buffer has been emptied (rows are always processed in order).
+*/
+class OutputQueue {
+public:
+	/*! Behavior when the ring buffer is full. */
+	enum QueueMode {
+		QM_BLOCK,
+		QM_DROP,
+		QM_GROW
+	};
+
+	/*! Constructor. */
+	OutputQueue();
+
+	/*! Allocates the ring buffer, must not be called while rows are queued.
+		\param capacity Number of rows in ring buffer.
+		\param mode Behavior when ring buffer is full.
+		\param prototype Row with correctly sized vectors, used to pre-allocate all slots.
+	*/
+	void setup(unsigned int capacity, QueueMode mode, const OutputRow & prototype);
+
+	/*! Producer: returns row to be filled, or nullptr if the row has to be dropped (QM_DROP mode, queue full).
+		In QM_BLOCK mode, the function waits until a slot is available.
+		\param allowDrop If false, the function waits for a free slot also in QM_DROP mode (used for marker rows).
+	*/
+	OutputRow * beginPush(bool allowDrop = true);
+	/*! Producer: publishes the row returned by the last call to beginPush(). */
+	void endPush();
+
+	/*! Consumer: returns next row to be processed, waits while the queue is empty.
+		Returns nullptr once shutdown() has been called and all queued rows have been processed.
+	*/
+	OutputRow * beginPop();
+	/*! Consumer: releases the row returned by the last call to beginPop(). */
+	void endPop();
+
+	/*! Producer: waits until the consumer has processed all queued rows. */
+	void waitUntilEmpty();
+
+	/*! Tells the consumer to return from beginPop() once the queue is empty. */
+	void shutdown();
+	/*! Resets the shutdown flag, so that the queue can be used by a new consumer. */
+	void restart();
+
+	/*! Number of rows dropped because the queue was full (QM_DROP mode). */
+	uint64_t droppedRows() const { return m_droppedRows; }
+	/*! Largest number of rows in overflow list (QM_GROW mode). */
+	size_t maxOverflowRows() const { return m_maxOverflowRows; }
+
+private:
+	/*! Wakes up the consumer, if waiting. */
+	void notifyConsumer();
+	/*! Wakes up the producer, if waiting. */
+	void notifyProducer();
+
+	/*! Ring buffer slots. */
+	std::vector<OutputRow>		m_ring;
+	/*! Behavior when ring buffer is full. */
+	QueueMode					m_mode;
+	/*! Row used by producer when rows are added to the overflow list. */
+	OutputRow					m_growRow;
+	/*! Row used by consumer when processing a row of the overflow list. */
+	OutputRow					m_overflowPopRow;
+	/*! Set by beginPush() when m_growRow is filled instead of a ring slot. */
+	bool						m_pushToOverflow;
+	/*! Set by beginPop() when m_overflowPopRow is processed instead of a ring slot. */
+	bool						m_popFromOverflow;
+
+	/*! Number of rows published to the ring buffer (written by producer only). */
+	std::atomic<uint64_t>		m_head;
+	/*! Number of rows released from the ring buffer (written by consumer only). */
+	std::atomic<uint64_t>		m_tail;
+	/*! Number of rows published in total, including overflow (written by producer only). */
+	std::atomic<uint64_t>		m_pushedRows;
+	/*! Number of rows processed in total, including overflow (written by consumer only). */
+	std::atomic<uint64_t>		m_poppedRows;
+	/*! Number of dropped rows. */
+	uint64_t					m_droppedRows;
+	/*! Largest number of rows in overflow list. */
+	size_t						m_maxOverflowRows;
+
+	/*! Mutex guarding the overflow list and the waiting states. */
+	std::mutex					m_mutex;
+	/*! Rows not fitting in ring buffer (QM_GROW mode), guarded by m_mutex. */
+	std::deque<OutputRow>		m_overflow;
+	/*! Set while the overflow list is not empty (may be read without lock by the producer). */
+	std::atomic<bool>			m_overflowUsed;
+	/*! Signals consumer that rows are available (or that the queue shuts down). */
+	std::condition_variable		m_rowAvailable;
+	/*! Signals producer that rows have been processed. */
+	std::condition_variable		m_rowProcessed;
+	/*! Set while consumer waits for rows. */
+	std::atomic<bool>			m_consumerWaiting;
+	/*! Set while producer waits for free slots or for the queue to become empty. */
+	std::atomic<bool>			m_producerWaiting;
+	/*! Set when consumer shall exit once the queue is empty. */
+	std::atomic<bool>			m_shutdown;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_OUTPUTQUEUE_H
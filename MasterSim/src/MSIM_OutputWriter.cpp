@@ -4,6 +4,13 @@
 #include <fstream>
 #include <algorithm>
 #include <memory>
+#include <cstdio>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
 
 #include <IBK_Exception.h>
 #include <IBK_FormatString.h>
@@ -16,6 +23,7 @@
 #include "MSIM_FMUSlave.h"
 #include "MSIM_FMU.h"
 #include "MSIM_Project.h"
+#include "MSIM_OutputFilter.h"
 
 
 namespace MASTER_SIM {
@@ -26,15 +34,32 @@ OutputWriter::OutputWriter() :
 	m_tLastOutput(-1),
 	m_valueOutputs(NULL),
 	m_stringOutputs(NULL),
-	m_progressOutputs(NULL)
+	m_binaryOutputs(NULL),
+	m_compressedOutputs(NULL),
+	m_progressOutputs(NULL),
+	m_valuesFileSize(0),
+	m_stringsFileSize(0),
+	m_outputThreadFailed(false)
 {
 }
 
 
 OutputWriter::~OutputWriter() {
+	// normally, outputs have been finished already at the end of the simulation
+	try {
+		finishOutputs();
+	}
+	catch (IBK::Exception & ex) {
+		ex.writeMsgStackToError();
+	}
+	catch (std::exception & ex) {
+		IBK::IBK_Message(ex.what(), IBK::MSG_ERROR, "[OutputWriter::~OutputWriter]");
+	}
 	delete m_valueOutputs;
 	delete m_stringOutputs;
 	delete m_progressOutputs;
+	delete m_binaryOutputs;
+	delete m_compressedOutputs;
 }
 
 
@@ -53,6 +78,9 @@ void OutputWriter::openOutputFiles(bool reopen) {
 	// first string outputs, collect variables of type string from all slaves and create
 	// a map of output column index to slave and variable index
 	std::string descriptions = IBK::FormatString("Time [%1]").arg(m_project->m_outputTimeUnit.name()).str();
+	// variables retrieved only for connections are not written
+	OutputFilter outputFilter;
+	outputFilter.setPatterns(m_project->m_outputFilter);
 	// collect output variable references for strings
 	for (unsigned int s=0; s<m_slaves.size(); ++s) {
 		const AbstractSlave * slave = m_slaves[s];
@@ -60,6 +88,8 @@ void OutputWriter::openOutputFiles(bool reopen) {
 		// loop all string variables in slave
 		for (unsigned int v=0; v<slave->m_stringVarNames.size(); ++v) {
 			std::string flatName = slave->m_name + "." + slave->m_stringVarNames[v];
+			if (!outputFilter.matches(flatName))
+				continue;
 			descriptions += " \t" + flatName;
 			m_stringOutputMapping.push_back( std::make_pair(slave, v));
 		}
@@ -85,14 +115,29 @@ void OutputWriter::openOutputFiles(bool reopen) {
 			*m_stringOutputs << descriptions << std::endl;
 		}
 		m_stringOutputs->precision(14);
+		m_stringsFileSize = stringOutputFilename.fileSize();
 	}
 
 
+	// statistics written for real outputs, if aggregation is enabled
+	m_aggregationModes.clear();
+	for (unsigned int i=0; i<m_project->m_outputAggregation.size(); ++i) {
+		switch (m_project->m_outputAggregation[i]) {
+			case Project::OA_MEAN		: m_aggregationModes.push_back(OutputAggregator::AM_MEAN); break;
+			case Project::OA_MIN		: m_aggregationModes.push_back(OutputAggregator::AM_MIN); break;
+			case Project::OA_MAX		: m_aggregationModes.push_back(OutputAggregator::AM_MAX); break;
+			case Project::OA_INTEGRAL	: m_aggregationModes.push_back(OutputAggregator::AM_INTEGRAL); break;
+		}
+	}
+
 	// now value outputs (boolean, integer and real)
 	descriptions = IBK::FormatString("Time [%1]").arg(m_project->m_outputTimeUnit.name()).str();
 	std::string boolDescriptions;
 	std::string intDescriptions;
 	std::string realDescriptions;
+	std::vector<BinaryResultColumn> boolColumns;
+	std::vector<BinaryResultColumn> intColumns;
+	std::vector<BinaryResultColumn> realColumns;
 	int outputVars = 0;
 	// collect variable references from all slaves
 	for (unsigned int s=0; s<m_slaves.size(); ++s) {
@@ -101,25 +146,55 @@ void OutputWriter::openOutputFiles(bool reopen) {
 		// loop all boolean variables in slave
 		for (unsigned int v=0; v<slave->m_boolVarNames.size(); ++v) {
 			std::string flatName = slave->m_name + "." + slave->m_boolVarNames[v];
+			if (!outputFilter.matches(flatName))
+				continue;
 			boolDescriptions += " \t" + flatName + " [-]"; // booleans are unit-less
 			m_boolOutputMapping.push_back( std::make_pair(slave, v));
+			boolColumns.push_back(BinaryResultColumn(BinaryResultColumn::CT_BOOL, flatName, "-"));
 			++outputVars;
 		}
 
 		// loop all integer variables in slave
 		for (unsigned int v=0; v<slave->m_intVarNames.size(); ++v) {
 			std::string flatName = slave->m_name + "." + slave->m_intVarNames[v];
+			if (!outputFilter.matches(flatName))
+				continue;
 			intDescriptions += " \t" + flatName + " [-]"; // ints are unit-less
 			m_intOutputMapping.push_back( std::make_pair(slave, v));
+			intColumns.push_back(BinaryResultColumn(BinaryResultColumn::CT_INT, flatName, "-"));
 			++outputVars;
 		}
 
 		// loop all real variables in slave
 		for (unsigned int v=0; v<slave->m_doubleVarNames.size(); ++v) {
-			std::string flatName = slave->m_name + "." + slave->m_doubleVarNames[v] + " [" + slave->m_doubleVarUnits[v] + "]";
-			realDescriptions += " \t" + flatName;
+			std::string varName = slave->m_name + "." + slave->m_doubleVarNames[v];
+			if (!outputFilter.matches(varName))
+				continue;
 			m_realOutputMapping.push_back( std::make_pair(slave, v));
-			++outputVars;
+			const std::string & unit = slave->m_doubleVarUnits[v];
+			if (m_aggregationModes.empty()) {
+				realDescriptions += " \t" + varName + " [" + unit + "]";
+				realColumns.push_back(BinaryResultColumn(BinaryResultColumn::CT_REAL, varName, unit));
+				++outputVars;
+				continue;
+			}
+			// one column per statistic, name gets statistic as suffix, e.g. 'slave.T:mean [C]'
+			for (unsigned int m=0; m<m_aggregationModes.size(); ++m) {
+				std::string columnName = varName;
+				std::string columnUnit = unit;
+				switch (m_aggregationModes[m]) {
+					case OutputAggregator::AM_MEAN		: columnName += ":mean"; break;
+					case OutputAggregator::AM_MIN		: columnName += ":min"; break;
+					case OutputAggregator::AM_MAX		: columnName += ":max"; break;
+					case OutputAggregator::AM_INTEGRAL	:
+						columnName += ":integral";
+						columnUnit = (unit == "-" || unit.empty()) ? std::string("s") : unit + "*s";
+					break;
+				}
+				realDescriptions += " \t" + columnName + " [" + columnUnit + "]";
+				realColumns.push_back(BinaryResultColumn(BinaryResultColumn::CT_REAL, columnName, columnUnit));
+				++outputVars;
+			}
 		}
 
 	} // for - slaves
@@ -152,7 +227,17 @@ void OutputWriter::openOutputFiles(bool reopen) {
 	}
 
 
-	{
+	if (m_project->m_outputFormat != Project::OF_BINARY && m_project->m_outputCompression == Project::OC_DEFLATE) {
+		IBK::IBK_Message( IBK::FormatString("Creating output file 'values.csv.gz'.\n"),
+						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+		m_compressedOutputs = new CompressedResultWriter;
+		if (reopen)
+			m_compressedOutputs->reopen(m_resultsDir / "values.csv.gz");
+		else
+			m_compressedOutputs->create(m_resultsDir / "values.csv.gz",
+										descriptions + boolDescriptions + intDescriptions + realDescriptions + "\n");
+	}
+	else if (m_project->m_outputFormat != Project::OF_BINARY) {
 		IBK::IBK_Message( IBK::FormatString("Creating output file 'values.csv'.\n"),
 						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
 		IBK::Path outputFilename = m_resultsDir / "values.csv";
@@ -171,8 +256,39 @@ void OutputWriter::openOutputFiles(bool reopen) {
 				<< std::endl;
 		}
 		m_valueOutputs->precision(14);
+		m_valuesFileSize = outputFilename.fileSize();
 	}
 
+	if (m_project->m_outputFormat != Project::OF_CSV) {
+		IBK::IBK_Message( IBK::FormatString("Creating output file 'values.bin'.\n"),
+						  IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+		// same columns as in values.csv
+		m_binaryColumns.clear();
+		m_binaryColumns.push_back(BinaryResultColumn(BinaryResultColumn::CT_TIME, "Time", m_project->m_outputTimeUnit.name()));
+		m_binaryColumns.insert(m_binaryColumns.end(), boolColumns.begin(), boolColumns.end());
+		m_binaryColumns.insert(m_binaryColumns.end(), intColumns.begin(), intColumns.end());
+		m_binaryColumns.insert(m_binaryColumns.end(), realColumns.begin(), realColumns.end());
+		m_binaryOutputs = new BinaryResultWriter;
+		if (reopen)
+			m_binaryOutputs->reopen(m_resultsDir / "values.bin", m_binaryColumns);
+		else
+			m_binaryOutputs->create(m_resultsDir / "values.bin", m_binaryColumns);
+	}
+
+
+	// aggregation statistics, when restarting they have been restored from the checkpoint already
+	unsigned int aggregatedVars = m_aggregationModes.empty() ? 0 : (unsigned int)m_realOutputMapping.size();
+	if (!reopen)
+		m_aggregator.resize(aggregatedVars);
+	else if (m_aggregator.size() != aggregatedVars)
+		throw IBK::Exception("Output aggregation settings do not match the checkpoint, cannot restart simulation.", FUNC_ID);
+	m_aggregationSample.resize(aggregatedVars);
+
+	// row buffer: time in output unit, booleans, integers, reals (same order as columns) and strings
+	m_row.m_t = 0;
+	m_row.m_values.assign(1 + outputVars, 0);
+	m_row.m_strings.assign(m_stringOutputMapping.size(), std::string());
+
 
 	// finally, also create the "synonymous variables" file
 
@@ -231,7 +347,27 @@ void OutputWriter::setupProgressReport() {
 void OutputWriter::appendOutputs(double t) {
 	// skip output writing, if last output was written within minimum output
 	// time step size; mind rounding errors here!
-	if (m_tEarliestOutputTime >= 0 && m_tEarliestOutputTime > t) {
+	bool outputDue = !(m_tEarliestOutputTime >= 0 && m_tEarliestOutputTime > t);
+
+	// outputs not needed for connections are only retrieved from the slaves when they are written
+	// (or aggregated, which needs the values of every step)
+	if (outputDue || m_aggregator.size() != 0) {
+		for (AbstractSlave * slave : m_slaves)
+			slave->cacheRecordedOutputs();
+	}
+
+	// update statistics of aggregated outputs with values of every step
+	if (m_aggregator.size() != 0) {
+		double * values = &m_aggregationSample[0];
+		for (std::vector< std::pair<const AbstractSlave*, unsigned int> >::const_iterator it = m_realOutputMapping.begin();
+			 it != m_realOutputMapping.end(); ++it)
+		{
+			*values++ = it->first->m_doubleOutputs[it->second];
+		}
+		m_aggregator.addSample(t, &m_aggregationSample[0]);
+	}
+
+	if (!outputDue) {
 		m_progressFeedback.writeFeedbackFromF(t);
 		return;
 	}
@@ -251,42 +387,131 @@ void OutputWriter::appendOutputs(double t) {
 	m_progressFeedback.writeFeedback(t, false);
 	m_tLastOutput = t; // remember this output time
 
-	// 1. dump state of master to output files
+	// perform time unit conversion
+	double tOut = t;
+	IBK::UnitList::instance().convert(IBK::Unit("s"), IBK::Unit(m_project->m_outputTimeUnit), tOut);
 
-	// string outputs
-	if (m_stringOutputs != NULL) {
-		*m_stringOutputs << t;
-		for (std::vector< std::pair<const AbstractSlave*, unsigned int> >::const_iterator it = m_stringOutputMapping.begin(); it != m_stringOutputMapping.end(); ++it) {
-			*m_stringOutputs << '\t' << it->first->m_stringOutputs[it->second];
-			// gather all data in output file
+	// compression is always done in the output thread
+	if (!m_project->m_outputThread && m_compressedOutputs == NULL) {
+		collectRow(m_row, t, tOut);
+		writeRow(m_row);
+	}
+	else {
+		// copy output values into queue, output thread does the rest
+		if (!m_outputThread.joinable())
+			startOutputThread();
+		else
+			rethrowOutputThreadError();
+		OutputRow * row = m_outputQueue.beginPush();
+		// row is NULL if queue is full and the row is dropped
+		if (row != NULL) {
+			collectRow(*row, t, tOut);
+			m_outputQueue.endPush();
 		}
-		*m_stringOutputs << std::endl;
 	}
 
-	// value outputs
+	// next aggregation interval starts with this output
+	m_aggregator.restart();
+}
 
-	// perform time unit conversion
-	double tOut = t;
-	IBK::UnitList::instance().convert(IBK::Unit("s"), IBK::Unit(m_project->m_outputTimeUnit), tOut);
-	*m_valueOutputs << tOut;
 
-	// booleans
+void OutputWriter::finishOutputs() {
+	const char * const FUNC_ID = "[OutputWriter::finishOutputs]";
+	if (m_outputThread.joinable()) {
+		m_outputQueue.shutdown();
+		m_outputThread.join();
+		m_outputQueue.restart();
+		if (m_outputQueue.droppedRows() > 0)
+			IBK::IBK_Message(IBK::FormatString("Output queue was full, %1 output rows have been dropped.\n").arg(m_outputQueue.droppedRows()),
+							 IBK::MSG_WARNING, FUNC_ID, IBK::VL_STANDARD);
+		if (m_outputQueue.maxOverflowRows() > 0)
+			IBK::IBK_Message(IBK::FormatString("Output queue was full, up to %1 additional output rows were held in memory.\n").arg(m_outputQueue.maxOverflowRows()),
+							 IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_INFO);
+	}
+	rethrowOutputThreadError();
+	if (m_binaryOutputs != NULL)
+		m_binaryOutputs->flush();
+	if (m_compressedOutputs != NULL)
+		m_compressedOutputs->finish();
+	if (m_valueOutputs != NULL)
+		m_valueOutputs->flush();
+	if (m_stringOutputs != NULL)
+		m_stringOutputs->flush();
+}
+
+
+void OutputWriter::collectRow(OutputRow & row, double t, double tOut) const {
+	row.m_t = t;
+	row.m_marker.reset();
+	double * values = &row.m_values[0];
+	*values++ = tOut;
 	for (std::vector< std::pair<const AbstractSlave*, unsigned int> >::const_iterator it = m_boolOutputMapping.begin();
 		 it != m_boolOutputMapping.end(); ++it)
 	{
-		*m_valueOutputs << '\t' << it->first->m_boolOutputs[it->second];
+		*values++ = it->first->m_boolOutputs[it->second];
 	}
-	// integer
 	for (std::vector< std::pair<const AbstractSlave*, unsigned int> >::const_iterator it = m_intOutputMapping.begin();
 		 it != m_intOutputMapping.end(); ++it)
 	{
-		*m_valueOutputs << '\t' << it->first->m_intOutputs[it->second];
+		*values++ = it->first->m_intOutputs[it->second];
+	}
+	if (m_aggregationModes.empty()) {
+		for (std::vector< std::pair<const AbstractSlave*, unsigned int> >::const_iterator it = m_realOutputMapping.begin();
+			 it != m_realOutputMapping.end(); ++it)
+		{
+			*values++ = it->first->m_doubleOutputs[it->second];
+		}
+	}
+	else {
+		m_aggregator.result(m_aggregationModes, values);
+	}
+	// Note: assignment re-uses the memory of the strings in the row
+	for (unsigned int i=0; i<m_stringOutputMapping.size(); ++i)
+		row.m_strings[i] = m_stringOutputMapping[i].first->m_stringOutputs[m_stringOutputMapping[i].second];
+}
+
+
+void OutputWriter::writeRow(const OutputRow & row) {
+
+	// 1. dump state of master to output files
+
+	// string outputs
+	if (m_stringOutputs != NULL) {
+		m_rowFormatter.clear();
+		m_rowFormatter.appendDouble(row.m_t, 14);
+		for (std::vector<std::string>::const_iterator it = row.m_strings.begin(); it != row.m_strings.end(); ++it) {
+			m_rowFormatter.appendChar('\t');
+			m_rowFormatter.appendString(*it);
+			// gather all data in output file
+		}
+		m_rowFormatter.appendChar('\n');
+		m_rowFormatter.writeTo(*m_stringOutputs);
+		m_stringsFileSize += (int64_t)m_rowFormatter.size();
+	}
+
+	// value outputs
+
+	if (m_binaryOutputs != NULL)
+		m_binaryOutputs->appendRow(&row.m_values[0]);
+
+	if (m_valueOutputs == NULL && m_compressedOutputs == NULL)
+		return;
+
+	m_rowFormatter.clear();
+	const double * values = &row.m_values[0];
+	m_rowFormatter.appendDouble(*values++, 14);
+
+	// booleans and integers
+	const double * intValuesEnd = values + m_boolOutputMapping.size() + m_intOutputMapping.size();
+	for (; values != intValuesEnd; ++values) {
+		m_rowFormatter.appendChar('\t');
+		m_rowFormatter.appendInt((int)*values);
 	}
 	// real
-	for (std::vector< std::pair<const AbstractSlave*, unsigned int> >::const_iterator it = m_realOutputMapping.begin();
-		 it != m_realOutputMapping.end(); ++it)
-	{
-		*m_valueOutputs << '\t' << it->first->m_doubleOutputs[it->second];
+	const double * valuesEnd = &row.m_values[0] + row.m_values.size();
+	for (; values != valuesEnd; ++values) {
+		m_rowFormatter.appendChar('\t');
+		m_rowFormatter.appendDouble(*values, 14);
 	}
 
 #ifdef DUMP_PARAMETERS
@@ -302,14 +527,22 @@ void OutputWriter::appendOutputs(double t) {
 					std::string value = var.m_startValue;
 					if (value.empty())
 						value = "0.0";
-					*m_valueOutputs << '\t' << value;
+					m_rowFormatter.appendChar('\t');
+					m_rowFormatter.appendString(value);
 				}
 			}
 		}
 	} // for - slaves
 #endif // DUMP_PARAMETERS
 
-	*m_valueOutputs << std::endl;
+	// Note: rows are not flushed individually, files are flushed when taking checkpoints and at the end
+	m_rowFormatter.appendChar('\n');
+	if (m_compressedOutputs != NULL)
+		m_compressedOutputs->appendRow(row.m_values[0], m_rowFormatter.data(), m_rowFormatter.size());
+	else {
+		m_rowFormatter.writeTo(*m_valueOutputs);
+		m_valuesFileSize += (int64_t)m_rowFormatter.size();
+	}
 
 
 	// 2. statistics of master / counter variables
@@ -317,5 +550,194 @@ void OutputWriter::appendOutputs(double t) {
 }
 
 
+void OutputWriter::startOutputThread() {
+	// the queue holds copies of the output values, so that the slaves may continue
+	// with the next steps while the rows are being written
+	const unsigned int QUEUE_CAPACITY = 256;
+	OutputQueue::QueueMode mode = OutputQueue::QM_BLOCK;
+	switch (m_project->m_outputQueueMode) {
+		case Project::OQ_BLOCK	: mode = OutputQueue::QM_BLOCK; break;
+		case Project::OQ_DROP	: mode = OutputQueue::QM_DROP; break;
+		case Project::OQ_GROW	: mode = OutputQueue::QM_GROW; break;
+	}
+	m_outputQueue.setup(QUEUE_CAPACITY, mode, m_row);
+	m_outputThread = std::thread(&OutputWriter::outputThreadLoop, this);
+}
+
+
+void OutputWriter::waitForOutputThread() {
+	if (m_outputThread.joinable())
+		m_outputQueue.waitUntilEmpty();
+	rethrowOutputThreadError();
+}
+
+
+void OutputWriter::rethrowOutputThreadError() {
+	if (!m_outputThreadFailed || m_outputThreadError == nullptr)
+		return;
+	std::exception_ptr ex = m_outputThreadError;
+	m_outputThreadError = nullptr;
+	std::rethrow_exception(ex);
+}
+
+
+void OutputWriter::outputThreadLoop() {
+	OutputRow * row;
+	while ((row = m_outputQueue.beginPop()) != NULL) {
+		// after an error, rows are only removed from queue so that the simulation thread does not block
+		if (row->m_marker) {
+			recordFileSizes(*row->m_marker);
+			row->m_marker.reset();
+		}
+		else if (!m_outputThreadFailed) {
+			try {
+				writeRow(*row);
+			}
+			catch (...) {
+				m_outputThreadError = std::current_exception();
+				m_outputThreadFailed = true;
+			}
+		}
+		m_outputQueue.endPop();
+	}
+}
+
+
+std::shared_ptr<OutputFileSizeMarker> OutputWriter::addFileSizeMarker(bool flush) {
+	std::shared_ptr<OutputFileSizeMarker> marker = std::make_shared<OutputFileSizeMarker>(flush);
+	if (m_outputThread.joinable()) {
+		rethrowOutputThreadError();
+		// marker rows are never dropped
+		OutputRow * row = m_outputQueue.beginPush(false);
+		row->m_marker = marker;
+		m_outputQueue.endPush();
+	}
+	else {
+		// all rows have been written already
+		recordFileSizes(*marker);
+	}
+	return marker;
+}
+
+
+void OutputWriter::recordFileSizes(OutputFileSizeMarker & marker) {
+	if (m_outputThreadFailed) {
+		marker.fail();
+		return;
+	}
+	try {
+		if (marker.m_flush) {
+			if (m_binaryOutputs != NULL)
+				m_binaryOutputs->flush();
+			if (m_compressedOutputs != NULL)
+				m_compressedOutputs->flush();
+			if (m_valueOutputs != NULL)
+				m_valueOutputs->flush();
+			if (m_stringOutputs != NULL)
+				m_stringOutputs->flush();
+		}
+	}
+	catch (...) {
+		m_outputThreadError = std::current_exception();
+		m_outputThreadFailed = true;
+		marker.fail();
+		return;
+	}
+	CompressedResultFrame pendingRows;
+	int64_t valuesSize = 0;
+	if (m_compressedOutputs != NULL) {
+		pendingRows = m_compressedOutputs->pendingRows();
+		valuesSize = (int64_t)pendingRows.m_offset;
+	}
+	else if (m_valueOutputs != NULL) {
+		valuesSize = m_valuesFileSize;
+	}
+	marker.record(valuesSize, m_stringOutputs != NULL ? m_stringsFileSize : 0,
+				  m_binaryOutputs != NULL ? m_binaryOutputs->fileSize() : 0, pendingRows);
+}
+
+
+/*! Truncates the file to the given size in place. */
+static void truncateFile(const IBK::Path & fname, int64_t size) {
+	const char * const FUNC_ID = "[OutputWriter::truncateOutputFiles]";
+	if (!fname.exists())
+		throw IBK::Exception(IBK::FormatString("Output file '%1' is missing, cannot restart simulation.").arg(fname), FUNC_ID);
+	int64_t currentSize = fname.fileSize();
+	if (currentSize < size)
+		throw IBK::Exception(IBK::FormatString("Output file '%1' is shorter than at time of checkpoint, cannot restart simulation.").arg(fname), FUNC_ID);
+	if (currentSize == size)
+		return;
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileW(fname.wstrOS().c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		throw IBK::Exception(IBK::FormatString("Cannot open output file '%1'.").arg(fname), FUNC_ID);
+	LARGE_INTEGER pos;
+	pos.QuadPart = size;
+	bool success = SetFilePointerEx(file, pos, NULL, FILE_BEGIN) && SetEndOfFile(file);
+	CloseHandle(file);
+#else
+	bool success = (::truncate(fname.str().c_str(), (off_t)size) == 0);
+#endif
+	if (!success)
+		throw IBK::Exception(IBK::FormatString("Cannot truncate output file '%1'.").arg(fname), FUNC_ID);
+}
+
+
+void OutputWriter::truncateOutputFiles(int64_t valuesSize, int64_t stringsSize, int64_t binarySize) {
+	if (m_project->m_outputFormat != Project::OF_BINARY)
+		truncateFile(m_resultsDir / (m_project->m_outputCompression == Project::OC_DEFLATE ? "values.csv.gz" : "values.csv"), valuesSize);
+	if (stringsSize > 0)
+		truncateFile(m_resultsDir / "strings.csv", stringsSize);
+	if (m_project->m_outputFormat != Project::OF_CSV)
+		truncateFile(m_resultsDir / "values.bin", binarySize);
+}
+
+
+void OutputWriter::rewindOutputFiles(const OutputFileSizeMarker & sizes) {
+	const char * const FUNC_ID = "[OutputWriter::rewindOutputFiles]";
+	// rows still queued belong to the discarded part of the simulation, but must be processed before the files are closed
+	waitForOutputThread();
+	// close files, truncate them and re-open them for appending
+	if (m_valueOutputs != NULL) {
+		delete m_valueOutputs;
+		m_valueOutputs = NULL;
+		IBK::Path outputFilename = m_resultsDir / "values.csv";
+		truncateFile(outputFilename, sizes.m_valuesSize);
+		m_valueOutputs = IBK::create_ofstream(outputFilename, std::ios_base::app);
+		if (m_valueOutputs == NULL)
+			throw IBK::Exception(IBK::FormatString("Cannot re-open output file '%1'.").arg(outputFilename), FUNC_ID);
+		m_valueOutputs->precision(14);
+		m_valuesFileSize = sizes.m_valuesSize;
+	}
+	if (m_stringOutputs != NULL) {
+		delete m_stringOutputs;
+		m_stringOutputs = NULL;
+		IBK::Path outputFilename = m_resultsDir / "strings.csv";
+		truncateFile(outputFilename, sizes.m_stringsSize);
+		m_stringOutputs = IBK::create_ofstream(outputFilename, std::ios_base::app);
+		if (m_stringOutputs == NULL)
+			throw IBK::Exception(IBK::FormatString("Cannot re-open output file '%1'.").arg(outputFilename), FUNC_ID);
+		m_stringOutputs->precision(14);
+		m_stringsFileSize = sizes.m_stringsSize;
+	}
+	if (m_binaryOutputs != NULL) {
+		m_binaryOutputs->close();
+		IBK::Path outputFilename = m_resultsDir / "values.bin";
+		truncateFile(outputFilename, sizes.m_binarySize);
+		m_binaryOutputs->reopen(outputFilename, m_binaryColumns);
+	}
+	if (m_compressedOutputs != NULL) {
+		// rows not yet compressed at the marker are kept in memory or have been compressed into the frame
+		// starting at the marker position
+		std::vector<char> pendingText;
+		m_compressedOutputs->pendingText(sizes.m_pendingRows, pendingText);
+		m_compressedOutputs->close();
+		IBK::Path outputFilename = m_resultsDir / "values.csv.gz";
+		truncateFile(outputFilename, sizes.m_valuesSize);
+		m_compressedOutputs->reopen(outputFilename, sizes.m_pendingRows, pendingText);
+	}
+}
+
 
 } // namespace MASTER_SIM
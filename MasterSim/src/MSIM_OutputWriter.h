@@ -4,17 +4,34 @@
 #include <vector>
 #include <iosfwd>
 #include <utility>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <memory>
 
 #include <IBK_Path.h>
 
 #include "MSIM_ProgressFeedback.h"
+#include "MSIM_BinaryResults.h"
+#include "MSIM_CompressedResults.h"
+#include "MSIM_OutputQueue.h"
+#include "MSIM_RowFormatter.h"
+#include "MSIM_OutputAggregator.h"
 
 namespace MASTER_SIM {
 
 class Project;
 class AbstractSlave;
 
-/*! Handles creation and writing of master outputs (output variables of slaves). */
+/*! Handles creation and writing of master outputs (output variables of slaves).
+
+	If enabled in the project, output files are written by a background thread. In this case appendOutputs()
+	only copies the output values into an OutputQueue and returns, formatting and file output is done by
+	the output thread. The thread is started with the first output and stopped in finishOutputs().
+	When compressed outputs are written, the output thread is always used, so that compression does not
+	slow down the simulation. Output file sizes needed for checkpoints and snapshots are recorded by the
+	output thread as well, via marker rows in the queue (see addFileSizeMarker()).
+*/
 class OutputWriter {
 public:
 
@@ -37,6 +54,33 @@ public:
 	*/
 	void appendOutputs(double t);
 
+	/*! Waits until all queued outputs have been written, stops the output thread and flushes all output files.
+		Must be called at the end of the simulation. Throws an exception if writing of outputs has failed.
+		Further calls to appendOutputs() restart the output thread.
+	*/
+	void finishOutputs();
+
+	/*! Requests the sizes of the output files after all outputs appended so far (used for checkpoints and snapshots).
+		The function does not wait for the output thread, instead a marker is added to the output queue and the output
+		thread records the sizes once it reaches the marker. When outputs are written without output thread,
+		the sizes are recorded immediately.
+		\param flush If true, output files are flushed and pending rows of 'values.csv.gz' are compressed into a
+			frame, so that the sizes are valid also after the simulation has been aborted (checkpoints).
+		\return Returns the marker, use OutputFileSizeMarker::wait() before accessing the sizes.
+	*/
+	std::shared_ptr<OutputFileSizeMarker> addFileSizeMarker(bool flush);
+
+	/*! Truncates existing output files to the given sizes, so that all outputs written after a checkpoint are discarded.
+		Call this function before openOutputFiles() when restarting a simulation.
+	*/
+	void truncateOutputFiles(int64_t valuesSize, int64_t stringsSize, int64_t binarySize);
+
+	/*! Truncates the open output files to the recorded sizes and continues writing at the end of the truncated files.
+		Rows of 'values.csv.gz' that were pending at the marker are restored. Used when rewinding a running simulation
+		to an in-memory snapshot.
+	*/
+	void rewindOutputFiles(const OutputFileSizeMarker & sizes);
+
 
 	/*! Directory where to write result files to. */
 	IBK::Path				m_resultsDir;
@@ -85,9 +129,59 @@ public:
 	*/
 	std::vector< std::pair<const AbstractSlave*, unsigned int> >	m_stringOutputMapping;
 
+	/*! Holds number output values in binary format (only if enabled in project, same columns as m_valueOutputs). */
+	BinaryResultWriter												*m_binaryOutputs;
+	/*! Holds number output values in compressed csv format (only if enabled in project, replaces m_valueOutputs). */
+	CompressedResultWriter											*m_compressedOutputs;
+	/*! Column definitions of binary output file (time column first). */
+	std::vector<BinaryResultColumn>									m_binaryColumns;
+
 	/*! Holds progress output. */
 	std::ofstream													*m_progressOutputs;
 
+	/*! Statistics of real outputs since last output (only used if output aggregation is enabled in project). */
+	OutputAggregator												m_aggregator;
+
+private:
+	/*! Copies current output values of all slaves into row. */
+	void collectRow(OutputRow & row, double t, double tOut) const;
+	/*! Writes row to all output files. */
+	void writeRow(const OutputRow & row);
+
+	/*! Sets up the queue and starts the output thread. */
+	void startOutputThread();
+	/*! Waits until all queued outputs have been written (output thread keeps running).
+		Throws an exception if writing of outputs has failed.
+	*/
+	void waitForOutputThread();
+	/*! Re-throws an exception caught in the output thread (only once). */
+	void rethrowOutputThreadError();
+	/*! Main loop of output thread. */
+	void outputThreadLoop();
+	/*! Records the current file sizes in the marker (flushes files first, if requested by the marker). */
+	void recordFileSizes(OutputFileSizeMarker & marker);
+
+	/*! Statistics written for each real output (empty if instantaneous values are written). */
+	std::vector<OutputAggregator::AggregationMode>					m_aggregationModes;
+	/*! Buffer for collecting real outputs passed to the aggregator. */
+	std::vector<double>												m_aggregationSample;
+
+	/*! Buffer for composing a row when outputs are written without output thread, also prototype for queue slots. */
+	OutputRow														m_row;
+	/*! Number of bytes written to 'values.csv' (including buffered data). */
+	int64_t															m_valuesFileSize;
+	/*! Number of bytes written to 'strings.csv' (including buffered data). */
+	int64_t															m_stringsFileSize;
+	/*! Buffer for formatting rows of csv files (used in writeRow() only). */
+	RowFormatter													m_rowFormatter;
+	/*! Queue of rows to be written by the output thread. */
+	OutputQueue														m_outputQueue;
+	/*! Output thread. */
+	std::thread														m_outputThread;
+	/*! Exception caught in output thread, only written by output thread before m_outputThreadFailed is set. */
+	std::exception_ptr												m_outputThreadError;
+	/*! Set when writing of outputs in output thread has failed (further rows are discarded). */
+	std::atomic<bool>												m_outputThreadFailed;
 };
 
 } // namespace MASTER_SIM
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib> // for std::rand()
+#include <algorithm>
 
 #include <IBK_StringUtils.h>
 #include <IBK_FileUtils.h>
@@ -170,13 +171,33 @@ void Project::read(const IBK::Path & prjFile, bool /* headerOnly */) {
 				continue;
 			}
 
-			/// \todo Implement support for output filter
+			if (line.find("stateless") == 0 || line.find("parallelStates") == 0) {
+				std::string flag = line.find("stateless") == 0 ? "stateless" : "parallelStates";
+				std::string slaveName = line.substr(flag.size());
+				IBK::trim(slaveName);
+				if (slaveName.empty())
+					throw IBK::Exception(IBK::FormatString("Expected format '%1 <slave name>', got '%2'").arg(flag).arg(line), FUNC_ID);
+				unsigned int s=0;
+				for (; s<m_simulators.size(); ++s) {
+					if (m_simulators[s].m_name == slaveName) {
+						if (flag == "stateless")
+							m_simulators[s].m_stateless = true;
+						else
+							m_simulators[s].m_parallelStates = true;
+						break;
+					}
+				}
+				if (s == m_simulators.size())
+					throw IBK::Exception(IBK::FormatString("Unknown slave referenced in line '%1'").arg(line), FUNC_ID);
+				continue;
+			}
+
 			if (line.find("outputOnly") == 0) {
-				std::string outputVarString = line.substr(6);
+				std::string outputVarString = line.substr(10);
 				IBK::trim(outputVarString);
 				if (outputVarString.empty())
-					throw IBK::Exception(IBK::FormatString("Expected format 'outputOnly <flat variable name>', got '%1'").arg(line), FUNC_ID);
-				m_outputFilter.insert(outputVarString);
+					throw IBK::Exception(IBK::FormatString("Expected format 'outputOnly <variable name pattern>', got '%1'").arg(line), FUNC_ID);
+				m_outputFilter.push_back(outputVarString);
 				continue;
 			}
 
@@ -201,6 +222,10 @@ void Project::read(const IBK::Path & prjFile, bool /* headerOnly */) {
 				if (!m_hStart.set(keyword, value)) throw IBK::Exception( IBK::FormatString("Invalid format of parameter in line '%1'.").arg(line), FUNC_ID);
 			} else if (keyword == "hOutputMin") {
 				if (!m_hOutputMin.set(keyword, value)) throw IBK::Exception( IBK::FormatString("Invalid format of parameter in line '%1'.").arg(line), FUNC_ID);
+			} else if (keyword == "checkpointInterval") {
+				if (!m_checkpointInterval.set(keyword, value)) throw IBK::Exception( IBK::FormatString("Invalid format of parameter in line '%1'.").arg(line), FUNC_ID);
+				if (m_checkpointInterval.value < 0)
+					throw IBK::Exception("Parameter 'checkpointInterval' must be >= 0.", FUNC_ID);
 			} else if (keyword == "outputTimeUnit") {
 				try {
 					m_outputTimeUnit = IBK::Unit(value);
@@ -240,6 +265,84 @@ void Project::read(const IBK::Path & prjFile, bool /* headerOnly */) {
 			}
 			else if (keyword == "maxIterations")
 				m_maxIterations = IBK::string2val<unsigned int>(value);
+			else if (keyword == "threadCount") {
+				m_threadCount = IBK::string2val<unsigned int>(value);
+				if (m_threadCount == 0)
+					throw IBK::Exception("Parameter 'threadCount' must be > 0.", FUNC_ID);
+			}
+			else if (keyword == "automaticCycleDetection")
+				m_automaticCycleDetection = (value == "true" || value == "yes" || value == "1");
+			else if (keyword == "skipUnchangedInputs")
+				m_skipUnchangedInputs = (value == "true" || value == "yes" || value == "1");
+			else if (keyword == "inputChangeTolerance") {
+				m_inputChangeTolerance = IBK::string2val<double>(value);
+				if (m_inputChangeTolerance < 0)
+					throw IBK::Exception("Parameter 'inputChangeTolerance' must be >= 0.", FUNC_ID);
+			}
+			else if (keyword == "reuseJacobian")
+				m_reuseJacobian = (value == "true" || value == "yes" || value == "1");
+			else if (keyword == "useDirectionalDerivatives")
+				m_useDirectionalDerivatives = (value == "true" || value == "yes" || value == "1");
+			else if (keyword == "jacobianSlaveCopies")
+				m_jacobianSlaveCopies = IBK::string2val<unsigned int>(value);
+			else if (keyword == "snapshotStepInterval")
+				m_snapshotStepInterval = IBK::string2val<unsigned int>(value);
+			else if (keyword == "snapshotMemoryLimit") {
+				m_snapshotMemoryLimit = IBK::string2val<unsigned int>(value);
+				if (m_snapshotMemoryLimit == 0)
+					throw IBK::Exception("Parameter 'snapshotMemoryLimit' must be > 0.", FUNC_ID);
+			}
+			else if (keyword == "outputFormat") {
+				if (value == "CSV")
+					m_outputFormat = OF_CSV;
+				else if (value == "BINARY")
+					m_outputFormat = OF_BINARY;
+				else if (value == "CSV_AND_BINARY")
+					m_outputFormat = OF_CSV_AND_BINARY;
+				else
+					throw IBK::Exception(IBK::FormatString("Unknown/undefined output format '%1'.").arg(value), FUNC_ID);
+			}
+			else if (keyword == "outputCompression") {
+				if (value == "NONE")
+					m_outputCompression = OC_NONE;
+				else if (value == "DEFLATE")
+					m_outputCompression = OC_DEFLATE;
+				else
+					throw IBK::Exception(IBK::FormatString("Unknown/undefined output compression '%1'.").arg(value), FUNC_ID);
+			}
+			else if (keyword == "outputAggregation") {
+				std::vector<std::string> tokens;
+				IBK::explode(value, tokens, " \t", IBK::EF_TrimTokens);
+				m_outputAggregation.clear();
+				for (unsigned int i=0; i<tokens.size(); ++i) {
+					OutputAggregation aggregation;
+					if (tokens[i] == "MEAN")
+						aggregation = OA_MEAN;
+					else if (tokens[i] == "MIN")
+						aggregation = OA_MIN;
+					else if (tokens[i] == "MAX")
+						aggregation = OA_MAX;
+					else if (tokens[i] == "INTEGRAL")
+						aggregation = OA_INTEGRAL;
+					else
+						throw IBK::Exception(IBK::FormatString("Unknown/undefined output aggregation '%1'.").arg(tokens[i]), FUNC_ID);
+					if (std::find(m_outputAggregation.begin(), m_outputAggregation.end(), aggregation) != m_outputAggregation.end())
+						throw IBK::Exception(IBK::FormatString("Duplicate output aggregation '%1'.").arg(tokens[i]), FUNC_ID);
+					m_outputAggregation.push_back(aggregation);
+				}
+			}
+			else if (keyword == "outputThread")
+				m_outputThread = (value == "true" || value == "yes" || value == "1");
+			else if (keyword == "outputQueueFullMode") {
+				if (value == "BLOCK")
+					m_outputQueueMode = OQ_BLOCK;
+				else if (value == "DROP")
+					m_outputQueueMode = OQ_DROP;
+				else if (value == "GROW")
+					m_outputQueueMode = OQ_GROW;
+				else
+					throw IBK::Exception(IBK::FormatString("Unknown/undefined output queue mode '%1'.").arg(value), FUNC_ID);
+			}
 			else if (keyword == "writeInternalVariables")
 				m_writeInternalVariables = (value == "true" || value == "yes" || value == "1");
 			else if (keyword == "writeUnconnectedFileReaderVars")
@@ -251,6 +354,19 @@ void Project::read(const IBK::Path & prjFile, bool /* headerOnly */) {
 			throw IBK::Exception(ex, IBK::FormatString("Error in line #%1: '%2'.").arg(lineNr).arg(line), FUNC_ID);
 		}
 	}
+
+	// concurrent calls are only safe if all instances of an FMU allow them
+	for (unsigned int i=0; i<m_simulators.size(); ++i) {
+		for (unsigned int j=i+1; j<m_simulators.size(); ++j) {
+			if (m_simulators[i].m_pathToFMU == m_simulators[j].m_pathToFMU &&
+				m_simulators[i].m_parallelStates != m_simulators[j].m_parallelStates)
+			{
+				throw IBK::Exception(IBK::FormatString("Slaves '%1' and '%2' use the same FMU '%3', 'parallelStates' must be set "
+													   "for either all or none of its slaves.")
+									 .arg(m_simulators[i].m_name).arg(m_simulators[j].m_name).arg(m_simulators[i].m_pathToFMU), FUNC_ID);
+			}
+		}
+	}
 }
 
 
@@ -313,6 +429,67 @@ void Project::write(const IBK::Path & prjFile) const {
 	}
 	out << std::endl;
 	out << std::setw(KEYWORD_WIDTH) << std::left << "maxIterations" << " " << m_maxIterations << std::endl;
+	// only write when parallel evaluation is enabled, so that projects remain readable by older versions
+	if (m_threadCount != 1)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "threadCount" << " " << m_threadCount << std::endl;
+	if (m_automaticCycleDetection)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "automaticCycleDetection" << " " << "yes" << std::endl;
+	if (m_skipUnchangedInputs)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "skipUnchangedInputs" << " " << "yes" << std::endl;
+	if (m_inputChangeTolerance != 0)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "inputChangeTolerance" << " " << m_inputChangeTolerance << std::endl;
+	if (m_reuseJacobian)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "reuseJacobian" << " " << "yes" << std::endl;
+	if (m_useDirectionalDerivatives)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "useDirectionalDerivatives" << " " << "yes" << std::endl;
+	if (m_jacobianSlaveCopies != 0)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "jacobianSlaveCopies" << " " << m_jacobianSlaveCopies << std::endl;
+	if (!m_checkpointInterval.empty() && m_checkpointInterval.value != 0)
+		writeParameter(m_checkpointInterval, out, KEYWORD_INDENTATION, KEYWORD_WIDTH);
+	if (m_snapshotStepInterval != 0)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "snapshotStepInterval" << " " << m_snapshotStepInterval << std::endl;
+	if (m_snapshotMemoryLimit != 1024)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "snapshotMemoryLimit" << " " << m_snapshotMemoryLimit << std::endl;
+	if (m_outputFormat != OF_CSV) {
+		out << std::setw(KEYWORD_WIDTH) << std::left << "outputFormat" << " ";
+		switch (m_outputFormat) {
+			case OF_CSV : out << "CSV"; break;
+			case OF_BINARY : out << "BINARY"; break;
+			case OF_CSV_AND_BINARY : out << "CSV_AND_BINARY"; break;
+		}
+		out << std::endl;
+	}
+	if (m_outputCompression != OC_NONE) {
+		out << std::setw(KEYWORD_WIDTH) << std::left << "outputCompression" << " ";
+		switch (m_outputCompression) {
+			case OC_NONE : out << "NONE"; break;
+			case OC_DEFLATE : out << "DEFLATE"; break;
+		}
+		out << std::endl;
+	}
+	if (!m_outputAggregation.empty()) {
+		out << std::setw(KEYWORD_WIDTH) << std::left << "outputAggregation";
+		for (unsigned int i=0; i<m_outputAggregation.size(); ++i) {
+			switch (m_outputAggregation[i]) {
+				case OA_MEAN : out << " MEAN"; break;
+				case OA_MIN : out << " MIN"; break;
+				case OA_MAX : out << " MAX"; break;
+				case OA_INTEGRAL : out << " INTEGRAL"; break;
+			}
+		}
+		out << std::endl;
+	}
+	if (m_outputThread)
+		out << std::setw(KEYWORD_WIDTH) << std::left << "outputThread" << " " << "yes" << std::endl;
+	if (m_outputQueueMode != OQ_BLOCK) {
+		out << std::setw(KEYWORD_WIDTH) << std::left << "outputQueueFullMode" << " ";
+		switch (m_outputQueueMode) {
+			case OQ_BLOCK : out << "BLOCK"; break;
+			case OQ_DROP : out << "DROP"; break;
+			case OQ_GROW : out << "GROW"; break;
+		}
+		out << std::endl;
+	}
 	out << std::setw(KEYWORD_WIDTH) << std::left << "writeInternalVariables" << " " << (m_writeInternalVariables ? "yes" : "no") << std::endl;
 	out << std::setw(KEYWORD_WIDTH) << std::left << "writeUnconnectedFileReaderVars" << " " << (m_writeUnconnectedFileReaderVars ? "yes" : "no") << std::endl;
 	out << std::endl;
@@ -361,6 +538,20 @@ void Project::write(const IBK::Path & prjFile) const {
 			out << "parameter " << simDef.m_name << "." << it->first << "   " << para << std::endl;
 		}
 	}
+
+	// write stateless and parallel state access flags
+	for (unsigned int i=0; i<m_simulators.size(); ++i) {
+		if (m_simulators[i].m_stateless)
+			out << "stateless " << m_simulators[i].m_name << std::endl;
+	}
+	for (unsigned int i=0; i<m_simulators.size(); ++i) {
+		if (m_simulators[i].m_parallelStates)
+			out << "parallelStates " << m_simulators[i].m_name << std::endl;
+	}
+
+	// write output filter patterns, order matters
+	for (unsigned int i=0; i<m_outputFilter.size(); ++i)
+		out << "outputOnly " << m_outputFilter[i] << std::endl;
 	out << std::endl;
 }
 
@@ -448,7 +639,9 @@ void Project::checkGraphs(const std::map<IBK::Path, MASTER_SIM::ModelDescription
 
 
 Project::SimulatorDef::SimulatorDef() :
-	m_cycle(0)
+	m_cycle(0),
+	m_stateless(false),
+	m_parallelStates(false)
 {
 	m_color = IBK::Color::fromHtml(SIMULATOR_COLORS[rand() % COLOR_COUNT]);
 }
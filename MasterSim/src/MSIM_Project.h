@@ -50,6 +50,46 @@ public:
 		EM_STEP_DOUBLING
 	};
 
+	/*! File formats for value outputs (booleans, integers and reals). */
+	enum OutputFormat {
+		/*! Tab-separated text file 'values.csv' (compatible with PostProc). */
+		OF_CSV,
+		/*! Binary columnar file 'values.bin' (see BinaryResultWriter), can be converted to 'values.csv'. */
+		OF_BINARY,
+		/*! Both 'values.csv' and 'values.bin'. */
+		OF_CSV_AND_BINARY
+	};
+
+	/*! Compression of value output file 'values.csv'. */
+	enum OutputCompression {
+		/*! Plain text file 'values.csv'. */
+		OC_NONE,
+		/*! File 'values.csv.gz', independently compressed frames with frame index (see CompressedResultWriter). */
+		OC_DEFLATE
+	};
+
+	/*! Statistics written instead of instantaneous values of real outputs (see OutputAggregator). */
+	enum OutputAggregation {
+		/*! Time-weighted mean value over output interval. */
+		OA_MEAN,
+		/*! Minimum value within output interval. */
+		OA_MIN,
+		/*! Maximum value within output interval. */
+		OA_MAX,
+		/*! Integral over output interval. */
+		OA_INTEGRAL
+	};
+
+	/*! Behavior of the output thread queue when the simulation produces rows faster than they are written. */
+	enum OutputQueueMode {
+		/*! Simulation waits until rows have been written. */
+		OQ_BLOCK,
+		/*! Rows not fitting into the queue are discarded (a warning with the number of dropped rows is issued). */
+		OQ_DROP,
+		/*! Queue grows beyond its default size, memory usage is not limited. */
+		OQ_GROW
+	};
+
 	/*! Holds all information that define a simulator. */
 	struct SimulatorDef {
 		SimulatorDef();
@@ -72,6 +112,17 @@ public:
 		*/
 		std::map<std::string, std::string>	m_parameters;
 
+		/*! If true, the slave has no time-dependent internal state and its state is never stored/restored
+			(roll-back only resets the slave time).
+		*/
+		bool			m_stateless;
+
+		/*! If true, the slave state may be retrieved/restored concurrently with other slaves (requires threadCount > 1).
+			Only set for FMUs that support concurrent calls to different instances, must be the same for all slaves
+			of an FMU (checked in read()).
+		*/
+		bool			m_parallelStates;
+
 		/*! Comparison operator to find slaves by name. */
 		bool operator==(const std::string & slaveName) const { return m_name == slaveName; }
 	};
@@ -220,6 +271,66 @@ public:
 	/*! Maximum number of iterations per communication step (within each priority/cycle). */
 	unsigned int				m_maxIterations = 1;
 
+	/*! Number of threads used to evaluate independent slaves concurrently (1 = sequential evaluation).
+		Used by the Gauss-Jacobi algorithm (all slaves) and by Gauss-Seidel and Newton algorithms (independent cycles).
+	*/
+	unsigned int				m_threadCount = 1;
+
+	/*! If true, cycles and evaluation order of slaves are determined from the connection graph (strongly connected
+		components in topological order) and the cycle numbers in the simulator definitions are ignored.
+		If false (the default), the user-defined cycles are used and the derived cycles are only reported
+		in the log as proposal.
+	*/
+	bool						m_automaticCycleDetection = false;
+
+	/*! If true, MasterSim remembers the input values last passed to each slave and only sets those inputs
+		whose values have changed (see m_inputChangeTolerance).
+	*/
+	bool						m_skipUnchangedInputs = false;
+
+	/*! Tolerance for detecting changed real inputs when m_skipUnchangedInputs is enabled.
+		A real input is only set again when it differs from the last value passed to the slave by more
+		than this (absolute) tolerance. 0 means that any bitwise change of the value is transmitted.
+		Slaves in iterated cycles always use tolerance 0.
+	*/
+	double						m_inputChangeTolerance = 0;
+
+	/*! If true, the Newton algorithm keeps the factorized Jacobian across master steps and improves it with
+		Broyden updates. The Jacobian is only regenerated when the convergence rate degrades or the
+		step size changes significantly.
+	*/
+	bool						m_reuseJacobian = false;
+
+	/*! If true, the Newton algorithm computes the Jacobian blocks of slaves that provide directional derivatives
+		with fmi2GetDirectionalDerivative instead of difference-quotients. Mind that for co-simulation slaves the
+		directional derivatives describe the immediate dependency of outputs on inputs at the end of the
+		step, not the change of the step result.
+	*/
+	bool						m_useDirectionalDerivatives = false;
+
+	/*! Number of additional instances of each slave in a Newton cycle, used to compute the difference-quotient
+		columns of the Jacobian concurrently (0 = disabled, columns are computed with the original slaves).
+		The copies are synchronized with the original slaves via serialized FMU states, hence the FMUs must
+		support serialization and must not be restricted to one instance per process.
+	*/
+	unsigned int				m_jacobianSlaveCopies = 0;
+
+	/*! Simulation time interval between checkpoints (empty or 0 = no checkpoints).
+		At each checkpoint the serialized states of all slaves and the state of the master are written to
+		the checkpoint file, so that the simulation can be resumed with the --restart command line option.
+		All FMUs must support serialization of their states.
+	*/
+	IBK::Parameter				m_checkpointInterval;
+
+	/*! Number of master steps between in-memory snapshots (0 = no snapshots).
+		Snapshots hold the same data as checkpoints and are kept in a ring buffer limited by m_snapshotMemoryLimit,
+		see MasterSim::restoreSnapshot(). All FMUs must support serialization of their states.
+	*/
+	unsigned int				m_snapshotStepInterval = 0;
+
+	/*! Memory budget for in-memory snapshots in MB, the oldest snapshots are discarded when the budget is exceeded. */
+	unsigned int				m_snapshotMemoryLimit = 1024;
+
 	/*! Absolute tolerance - used for convergence check and for time integration error control. */
 	double						m_absTol = 1e-6;
 	/*! Relative tolerance - used for convergence check and for time integration error control. */
@@ -231,6 +342,23 @@ public:
 	/*! Unit defined as output time for output files. */
 	IBK::Unit					m_outputTimeUnit;
 
+	/*! File format of value outputs. */
+	OutputFormat				m_outputFormat = OF_CSV;
+
+	/*! Compression of csv value output file, if enabled, outputs are always written by the output thread. */
+	OutputCompression			m_outputCompression = OC_NONE;
+
+	/*! Statistics to be written for each real output over each output interval (hOutputMin).
+		If empty (the default), instantaneous values are written.
+	*/
+	std::vector<OutputAggregation>	m_outputAggregation;
+
+	/*! If true, output files are written by a background thread. */
+	bool						m_outputThread = false;
+
+	/*! Behavior when output thread queue is full. */
+	OutputQueueMode				m_outputQueueMode = OQ_BLOCK;
+
 	/*! If true, internal variables are handled just as regular output variables. */
 	bool						m_writeInternalVariables = false;
 
@@ -243,8 +371,11 @@ public:
 	/*! Defines the connection graph. */
 	std::vector<GraphEdge>		m_graph;
 
-	/*! If not empty, only the values in the filter are dumped to file. */
-	std::set<std::string>		m_outputFilter;
+	/*! Output filter patterns (glob or regular expressions, see OutputFilter), in order of definition.
+		If not empty, only the selected variables are retrieved from the slaves and written to file
+		(variables needed for connections are retrieved nonetheless).
+	*/
+	std::vector<std::string>	m_outputFilter;
 };
 
 } // namespace MASTER_SIM
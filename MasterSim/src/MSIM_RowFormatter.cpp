@@ -0,0 +1,154 @@
+#include "MSIM_RowFormatter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <ostream>
+
+namespace MASTER_SIM {
+
+/*! Powers of 10 that are exactly representable as double. */
+static const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+RowFormatter::RowFormatter() :
+	m_buffer(256),
+	m_size(0)
+{
+}
+
+
+void RowFormatter::appendInt(long long value) {
+	char digits[24];
+	char * p = digits + sizeof(digits);
+	unsigned long long v = value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value;
+	do {
+		*--p = (char)('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+	if (value < 0)
+		*--p = '-';
+	size_t n = digits + sizeof(digits) - p;
+	reserve(n);
+	std::memcpy(&m_buffer[m_size], p, n);
+	m_size += n;
+}
+
+
+void RowFormatter::appendDouble(double value, int precision) {
+	// The value is scaled by 10^k, so that the integral part holds the requested number of significant digits.
+	// The product is computed exactly as sum hi + lo (using fma), so that rounding to the nearest integer
+	// gives the same digits as the exact decimal conversion done by printf. Values that cannot be handled
+	// this way (exponent out of range of exact powers of 10, rounding ties, inf/nan) are passed to snprintf.
+	if (precision < 1 || precision > 15 || !std::isfinite(value)) {
+		appendDoubleSlow(value, precision);
+		return;
+	}
+	if (value == 0) {
+		if (std::signbit(value))
+			appendChar('-');
+		appendChar('0');
+		return;
+	}
+	double a = std::fabs(value);
+	int binExp;
+	std::frexp(a, &binExp);
+	// decimal exponent estimate, may be one too small
+	int e = (int)std::floor((binExp - 1)*0.30102999566398120);
+	uint64_t significand = 0;
+	for (int attempt = 0; ; ++attempt) {
+		int k = precision - 1 - e;
+		if (attempt == 2 || k < 0 || k > 22) {
+			appendDoubleSlow(value, precision);
+			return;
+		}
+		double hi = a*POW10[k];
+		double lo = std::fma(a, POW10[k], -hi);
+		double r = std::floor(hi);
+		double frac = (hi - r) + lo;
+		// exact ties are rounded half-to-even by printf, leave these (rare) cases to snprintf
+		if (std::fabs(frac - 0.5) < 1e-9) {
+			appendDoubleSlow(value, precision);
+			return;
+		}
+		if (frac > 0.5)
+			r += 1;
+		if (r >= POW10[precision]) {
+			++e; // estimate was too small, or rounding yields next power of 10
+			continue;
+		}
+		significand = (uint64_t)r;
+		break;
+	}
+
+	// significant digits, without trailing zeros
+	char digits[16];
+	for (int i = precision - 1; i >= 0; --i) {
+		digits[i] = (char)('0' + significand % 10);
+		significand /= 10;
+	}
+	int nDigits = precision;
+	while (nDigits > 1 && digits[nDigits-1] == '0')
+		--nDigits;
+
+	reserve(precision + 8);
+	char * p = &m_buffer[m_size];
+	if (value < 0)
+		*p++ = '-';
+	if (e >= -4 && e < precision) {
+		// fixed notation
+		if (e >= 0) {
+			for (int i = 0; i <= e; ++i)
+				*p++ = digits[i];
+			if (nDigits > e + 1) {
+				*p++ = '.';
+				for (int i = e + 1; i < nDigits; ++i)
+					*p++ = digits[i];
+			}
+		}
+		else {
+			*p++ = '0';
+			*p++ = '.';
+			for (int i = -1; i > e; --i)
+				*p++ = '0';
+			for (int i = 0; i < nDigits; ++i)
+				*p++ = digits[i];
+		}
+	}
+	else {
+		// exponential notation with at least two exponent digits
+		*p++ = digits[0];
+		if (nDigits > 1) {
+			*p++ = '.';
+			for (int i = 1; i < nDigits; ++i)
+				*p++ = digits[i];
+		}
+		*p++ = 'e';
+		*p++ = e < 0 ? '-' : '+';
+		int absExp = e < 0 ? -e : e;
+		if (absExp >= 100)
+			*p++ = (char)('0' + absExp/100);
+		*p++ = (char)('0' + (absExp/10) % 10);
+		*p++ = (char)('0' + absExp % 10);
+	}
+	m_size = p - &m_buffer[0];
+}
+
+
+void RowFormatter::appendDoubleSlow(double value, int precision) {
+	char buf[64];
+	int n = std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+	reserve(n);
+	std::memcpy(&m_buffer[m_size], buf, n);
+	m_size += n;
+}
+
+
+void RowFormatter::writeTo(std::ostream & out) const {
+	out.write(&m_buffer[0], m_size);
+}
+
+} // namespace MASTER_SIM
@@ -0,0 +1,95 @@
+#ifndef MSIM_ROWFORMATTER_H
+#define MSIM_ROWFORMATTER_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <iosfwd>
+
+namespace MASTER_SIM {
+
+/*! Composes a line of text output (e.g. a row of 'values.csv') in a re-usable character buffer.
+
+	Numbers are formatted without iostreams, so that no locale handling and virtual calls are needed per value.
+	The output is identical to what a std::ostream with default float field and classic locale produces
+	(same as printf "%.<precision>g"). Once the buffer has reached the size of the longest row,
+	formatting does not allocate memory anymore.
+
+	\code
+	RowFormatter row;
+	row.clear();
+	row.appendDouble(t, 14);
+	row.appendChar('\t');
+	row.appendInt(counter);
+	row.appendChar('\n');
+	row.writeTo(out); // single write call per row
+	\endcode
+*/
+class RowFormatter {
+public:
+	/*! Constructor. */
+	RowFormatter();
+
+	/*! Clears buffer content (memory is kept). */
+	void clear() { m_size = 0; }
+
+	/*! Appends a single character. */
+	void appendChar(char c) {
+		reserve(1);
+		m_buffer[m_size++] = c;
+	}
+
+	/*! Appends a string. */
+	void appendString(const std::string & str) {
+		reserve(str.size());
+		std::memcpy(&m_buffer[m_size], str.data(), str.size());
+		m_size += str.size();
+	}
+
+	/*! Appends an integer value. */
+	void appendInt(long long value);
+
+	/*! Appends a floating point value with the given number of significant digits (1..17).
+		Produces the same result as printf("%.<precision>g") in the "C" locale.
+	*/
+	void appendDouble(double value, int precision);
+
+	/*! Appends spaces until the text starting at position fieldStart has the given width.
+		Same as std::setw(width) << std::left for the text appended since fieldStart.
+	*/
+	void padTo(size_t fieldStart, size_t width) {
+		if (m_size - fieldStart >= width)
+			return;
+		size_t n = width - (m_size - fieldStart);
+		reserve(n);
+		std::memset(&m_buffer[m_size], ' ', n);
+		m_size += n;
+	}
+
+	/*! Current size of buffer content in bytes. */
+	size_t size() const { return m_size; }
+	/*! Buffer content (not null-terminated). */
+	const char * data() const { return &m_buffer[0]; }
+
+	/*! Writes buffer content to stream with a single write call. */
+	void writeTo(std::ostream & out) const;
+
+private:
+	/*! Ensures that n more characters fit into the buffer. */
+	void reserve(size_t n) {
+		if (m_size + n > m_buffer.size())
+			m_buffer.resize(2*(m_size + n));
+	}
+
+	/*! Formats value with snprintf, used for values the fast algorithm does not handle exactly. */
+	void appendDoubleSlow(double value, int precision);
+
+	/*! Character buffer, only grows. */
+	std::vector<char>	m_buffer;
+	/*! Number of used characters in buffer. */
+	size_t				m_size;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_ROWFORMATTER_H
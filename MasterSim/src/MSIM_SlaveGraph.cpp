@@ -0,0 +1,177 @@
+#include "MSIM_SlaveGraph.h"
+
+#include <set>
+#include <algorithm>
+#include <limits>
+
+#include <IBK_assert.h>
+
+namespace MASTER_SIM {
+
+SlaveGraph::SlaveGraph(unsigned int nSlaves) :
+	m_successors(nSlaves),
+	m_predecessors(nSlaves)
+{
+}
+
+
+void SlaveGraph::addEdge(unsigned int outputSlave, unsigned int inputSlave) {
+	IBK_ASSERT(outputSlave < size() && inputSlave < size());
+	if (outputSlave == inputSlave)
+		return;
+	++m_successors[outputSlave][inputSlave];
+	++m_predecessors[inputSlave][outputSlave];
+}
+
+
+void SlaveGraph::computeCycles(std::vector< std::vector<unsigned int> > & cycles) const {
+	const unsigned int n = size();
+	const unsigned int UNVISITED = std::numeric_limits<unsigned int>::max();
+
+	// *** Tarjan's algorithm (iterative formulation) ***
+
+	std::vector<unsigned int> index(n, UNVISITED);
+	std::vector<unsigned int> lowLink(n, 0);
+	std::vector<unsigned int> componentOf(n, UNVISITED);
+	std::vector<bool> onStack(n, false);
+	std::vector<unsigned int> stack;
+	std::vector< std::vector<unsigned int> > components;
+	unsigned int counter = 0;
+
+	// call stack entries: node and iterator to next successor to visit
+	typedef std::pair<unsigned int, std::map<unsigned int, unsigned int>::const_iterator> Frame;
+	std::vector<Frame> callStack;
+
+	for (unsigned int root=0; root<n; ++root) {
+		if (index[root] != UNVISITED)
+			continue;
+		index[root] = lowLink[root] = counter++;
+		stack.push_back(root);
+		onStack[root] = true;
+		callStack.push_back(Frame(root, m_successors[root].begin()));
+
+		while (!callStack.empty()) {
+			unsigned int v = callStack.back().first;
+			if (callStack.back().second != m_successors[v].end()) {
+				unsigned int w = callStack.back().second->first;
+				++callStack.back().second;
+				if (index[w] == UNVISITED) {
+					// descend into w
+					index[w] = lowLink[w] = counter++;
+					stack.push_back(w);
+					onStack[w] = true;
+					callStack.push_back(Frame(w, m_successors[w].begin()));
+				}
+				else if (onStack[w]) {
+					lowLink[v] = std::min(lowLink[v], index[w]);
+				}
+				continue;
+			}
+
+			// all successors of v processed
+			callStack.pop_back();
+			if (!callStack.empty()) {
+				unsigned int parent = callStack.back().first;
+				lowLink[parent] = std::min(lowLink[parent], lowLink[v]);
+			}
+			// v is root of a strongly connected component?
+			if (lowLink[v] == index[v]) {
+				std::vector<unsigned int> component;
+				unsigned int w;
+				do {
+					w = stack.back();
+					stack.pop_back();
+					onStack[w] = false;
+					componentOf[w] = (unsigned int)components.size();
+					component.push_back(w);
+				} while (w != v);
+				std::sort(component.begin(), component.end());
+				components.push_back(component);
+			}
+		}
+	}
+
+	// *** topological ordering of components (Kahn's algorithm) ***
+
+	const unsigned int nComponents = (unsigned int)components.size();
+	std::vector< std::set<unsigned int> > componentSuccessors(nComponents);
+	std::vector<unsigned int> inDegree(nComponents, 0);
+	for (unsigned int v=0; v<n; ++v) {
+		for (std::map<unsigned int, unsigned int>::const_iterator it = m_successors[v].begin(); it != m_successors[v].end(); ++it) {
+			unsigned int from = componentOf[v];
+			unsigned int to = componentOf[it->first];
+			if (from != to && componentSuccessors[from].insert(to).second)
+				++inDegree[to];
+		}
+	}
+
+	// components without unprocessed dependencies, sorted by their lowest slave index
+	std::set< std::pair<unsigned int, unsigned int> > ready;
+	for (unsigned int c=0; c<nComponents; ++c)
+		if (inDegree[c] == 0)
+			ready.insert(std::make_pair(components[c].front(), c));
+
+	cycles.clear();
+	while (!ready.empty()) {
+		unsigned int c = ready.begin()->second;
+		ready.erase(ready.begin());
+		cycles.push_back(components[c]);
+		orderComponent(cycles.back());
+		for (std::set<unsigned int>::const_iterator it = componentSuccessors[c].begin(); it != componentSuccessors[c].end(); ++it) {
+			if (--inDegree[*it] == 0)
+				ready.insert(std::make_pair(components[*it].front(), *it));
+		}
+	}
+	IBK_ASSERT(cycles.size() == nComponents);
+}
+
+
+unsigned int SlaveGraph::backEdgeCount(const std::vector< std::vector<unsigned int> > & cycles) const {
+	// evaluation position of each slave
+	const unsigned int UNUSED = std::numeric_limits<unsigned int>::max();
+	std::vector<unsigned int> position(size(), UNUSED);
+	unsigned int pos = 0;
+	for (unsigned int c=0; c<cycles.size(); ++c)
+		for (unsigned int s=0; s<cycles[c].size(); ++s)
+			position[cycles[c][s]] = pos++;
+
+	unsigned int count = 0;
+	for (unsigned int v=0; v<size(); ++v) {
+		if (position[v] == UNUSED)
+			continue;
+		for (std::map<unsigned int, unsigned int>::const_iterator it = m_successors[v].begin(); it != m_successors[v].end(); ++it) {
+			if (position[it->first] != UNUSED && position[it->first] < position[v])
+				count += it->second;
+		}
+	}
+	return count;
+}
+
+
+void SlaveGraph::orderComponent(std::vector<unsigned int> & component) const {
+	if (component.size() < 2)
+		return;
+
+	std::set<unsigned int> remaining(component.begin(), component.end());
+	component.clear();
+	while (!remaining.empty()) {
+		// select slave with fewest connections from slaves not yet scheduled, first slave wins in case of ties
+		unsigned int best = *remaining.begin();
+		unsigned int bestWeight = std::numeric_limits<unsigned int>::max();
+		for (std::set<unsigned int>::const_iterator it = remaining.begin(); it != remaining.end(); ++it) {
+			unsigned int weight = 0;
+			const std::map<unsigned int, unsigned int> & preds = m_predecessors[*it];
+			for (std::map<unsigned int, unsigned int>::const_iterator pit = preds.begin(); pit != preds.end(); ++pit)
+				if (remaining.find(pit->first) != remaining.end())
+					weight += pit->second;
+			if (weight < bestWeight) {
+				bestWeight = weight;
+				best = *it;
+			}
+		}
+		component.push_back(best);
+		remaining.erase(best);
+	}
+}
+
+} // namespace MASTER_SIM
@@ -0,0 +1,67 @@
+#ifndef MSIM_SLAVEGRAPH_H
+#define MSIM_SLAVEGRAPH_H
+
+#include <vector>
+#include <map>
+
+namespace MASTER_SIM {
+
+/*! Directed dependency graph between slaves, generated from the connection graph of a project.
+	An edge from slave A to slave B means that an output of A is connected to an input of B,
+	i.e. B depends on A. The edge weight is the number of such connections.
+
+	The graph is used to determine the cycles (strongly connected components) and their
+	evaluation order from the connections, instead of relying on user-defined cycle numbers.
+
+	\code
+	SlaveGraph g(3);
+	g.addEdge(0, 1);
+	g.addEdge(1, 2);
+	g.addEdge(2, 1);
+	std::vector< std::vector<unsigned int> > cycles;
+	g.computeCycles(cycles); // cycles = { {0}, {1, 2} }
+	\endcode
+*/
+class SlaveGraph {
+public:
+	/*! Constructor, creates a graph with nSlaves nodes and no edges. */
+	explicit SlaveGraph(unsigned int nSlaves);
+
+	/*! Adds a connection from an output of slave 'outputSlave' to an input of slave 'inputSlave'.
+		Connections of a slave to itself are ignored, since they do not affect the evaluation order.
+	*/
+	void addEdge(unsigned int outputSlave, unsigned int inputSlave);
+
+	/*! Number of slaves (nodes) in graph. */
+	unsigned int size() const { return (unsigned int)m_successors.size(); }
+
+	/*! Determines the minimal cycles (strongly connected components, using Tarjan's algorithm)
+		and returns them in topological order, so that a cycle only depends on cycles before it.
+		Among independent cycles, the one with the lowest slave index comes first.
+		Within each cycle, the slaves are ordered such that the number of back edges (connections
+		from a slave to a slave that is evaluated earlier in the same cycle) is small.
+		\param cycles Vector with slave indexes for each cycle (resized in function).
+	*/
+	void computeCycles(std::vector< std::vector<unsigned int> > & cycles) const;
+
+	/*! Counts the number of connections that cannot be resolved by sequential evaluation in the given
+		order of cycles, i.e. connections to slaves evaluated earlier (or in an earlier cycle).
+		These are connections where Gauss-Seidel uses values of the previous iteration or time level.
+	*/
+	unsigned int backEdgeCount(const std::vector< std::vector<unsigned int> > & cycles) const;
+
+private:
+	/*! Orders the slaves of a single strongly connected component to minimize back edges (greedy heuristic).
+		Repeatedly selects the slave with the fewest inputs from slaves that have not been scheduled, yet.
+	*/
+	void orderComponent(std::vector<unsigned int> & component) const;
+
+	/*! Successors of each slave, key is index of slave depending on this slave, value is number of connections. */
+	std::vector< std::map<unsigned int, unsigned int> >	m_successors;
+	/*! Predecessors of each slave, key is index of slave this slave depends on, value is number of connections. */
+	std::vector< std::map<unsigned int, unsigned int> >	m_predecessors;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_SLAVEGRAPH_H
@@ -0,0 +1,56 @@
+#include "MSIM_SnapshotBuffer.h"
+
+#include <IBK_assert.h>
+
+namespace MASTER_SIM {
+
+void SnapshotBuffer::add(double t, const std::vector<char> & data, const std::shared_ptr<const OutputFileSizeMarker> & outputFileSizes) {
+	IBK_ASSERT(m_snapshots.empty() || m_snapshots.back().m_t < t);
+
+	m_snapshots.push_back(Snapshot());
+	Snapshot & snapshot = m_snapshots.back();
+	snapshot.m_t = t;
+	snapshot.m_size = data.size();
+	snapshot.m_outputFileSizes = outputFileSizes;
+	// only chunks not yet contained in other snapshots are copied
+	m_store.add(data, snapshot.m_recipe);
+	m_dataSize += data.size();
+
+	// discard oldest snapshots until we are within the memory budget, but keep the newest snapshot
+	while (m_memoryLimit != 0 && m_store.memoryUsage() > m_memoryLimit && m_snapshots.size() > 1)
+		discardOldest();
+}
+
+
+const SnapshotBuffer::Snapshot * SnapshotBuffer::latestSnapshot(double t) const {
+	for (std::deque<Snapshot>::const_reverse_iterator it = m_snapshots.rbegin(); it != m_snapshots.rend(); ++it) {
+		if (it->m_t <= t)
+			return &(*it);
+	}
+	return nullptr;
+}
+
+
+void SnapshotBuffer::discardAfter(double t) {
+	while (!m_snapshots.empty() && m_snapshots.back().m_t > t) {
+		m_store.release(m_snapshots.back().m_recipe);
+		m_dataSize -= m_snapshots.back().m_size;
+		m_snapshots.pop_back();
+	}
+}
+
+
+void SnapshotBuffer::clear() {
+	m_snapshots.clear();
+	m_store.clear();
+	m_dataSize = 0;
+}
+
+
+void SnapshotBuffer::discardOldest() {
+	m_store.release(m_snapshots.front().m_recipe);
+	m_dataSize -= m_snapshots.front().m_size;
+	m_snapshots.pop_front();
+}
+
+} // namespace MASTER_SIM
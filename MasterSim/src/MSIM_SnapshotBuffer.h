@@ -0,0 +1,87 @@
+#ifndef MSIM_SNAPSHOTBUFFER_H
+#define MSIM_SNAPSHOTBUFFER_H
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <memory>
+
+#include "MSIM_ChunkStore.h"
+
+namespace MASTER_SIM {
+
+class OutputFileSizeMarker;
+
+/*! Ring buffer of in-memory simulation snapshots.
+
+	Each snapshot holds the serialized master state, the simulation time it was taken at and the
+	sizes of the output files at this time. Snapshots are ordered by time. The data is kept in a ChunkStore,
+	so that chunks that are identical in several snapshots (e.g. constant parts of FMU states) are stored only once.
+	When the size of all stored chunks exceeds the memory budget, the oldest snapshots are discarded (the newest
+	snapshot is always kept).
+*/
+class SnapshotBuffer {
+public:
+	/*! Data of a single snapshot. */
+	struct Snapshot {
+		/*! Simulation time of snapshot. */
+		double					m_t;
+		/*! Ids of chunks holding the serialized master state. */
+		std::vector<ChunkId>	m_recipe;
+		/*! Size of serialized master state in bytes. */
+		size_t					m_size;
+		/*! Sizes of output files at time of snapshot (recorded by output thread). */
+		std::shared_ptr<const OutputFileSizeMarker>	m_outputFileSizes;
+	};
+
+	/*! Constructor. */
+	SnapshotBuffer() : m_memoryLimit(0), m_dataSize(0) {}
+
+	/*! Sets the memory budget in bytes (0 = no limit). */
+	void setMemoryLimit(size_t memoryLimit) { m_memoryLimit = memoryLimit; }
+
+	/*! Adds a snapshot, the time must be larger than the time of all snapshots in the buffer.
+		\param t Simulation time of snapshot.
+		\param data Serialized state.
+		\param outputFileSizes Sizes of output files at time of snapshot.
+	*/
+	void add(double t, const std::vector<char> & data, const std::shared_ptr<const OutputFileSizeMarker> & outputFileSizes);
+
+	/*! Returns the latest snapshot taken at or before time t, or nullptr if there is none. */
+	const Snapshot * latestSnapshot(double t) const;
+
+	/*! Re-assembles the serialized state of a snapshot. */
+	void snapshotData(const Snapshot & snapshot, std::vector<char> & data) const { m_store.assemble(snapshot.m_recipe, data); }
+
+	/*! Discards all snapshots taken after time t. */
+	void discardAfter(double t);
+
+	/*! Discards all snapshots. */
+	void clear();
+
+	/*! Number of snapshots in buffer. */
+	size_t size() const { return m_snapshots.size(); }
+
+	/*! Memory used by all snapshots (size of stored chunks) in bytes. */
+	size_t memoryUsage() const { return m_store.memoryUsage(); }
+
+	/*! Total size of serialized data of all snapshots in bytes (memory needed without de-duplication). */
+	size_t dataSize() const { return m_dataSize; }
+
+private:
+	/*! Removes the oldest snapshot. */
+	void discardOldest();
+
+	/*! Snapshots ordered by time (oldest first). */
+	std::deque<Snapshot>	m_snapshots;
+	/*! Holds the data of all snapshots. */
+	ChunkStore				m_store;
+	/*! Memory budget in bytes. */
+	size_t					m_memoryLimit;
+	/*! Total size of serialized data of all snapshots in bytes. */
+	size_t					m_dataSize;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_SNAPSHOTBUFFER_H
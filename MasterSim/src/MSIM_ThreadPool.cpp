@@ -0,0 +1,219 @@
+#include "MSIM_ThreadPool.h"
+
+#include <IBK_assert.h>
+
+namespace MASTER_SIM {
+
+ThreadPool::ThreadPool() :
+	m_task(nullptr),
+	m_taskCount(0),
+	m_nextTask(0),
+	m_batchFunction(nullptr),
+	m_successors(nullptr),
+	m_runningTasks(0),
+	m_completedTasks(0),
+	m_graphAborted(false),
+	m_batchCounter(0),
+	m_busyWorkers(0),
+	m_shutdown(false),
+	m_exceptionTask(0)
+{
+}
+
+
+ThreadPool::~ThreadPool() {
+	stop();
+}
+
+
+void ThreadPool::start(unsigned int threadCount) {
+	stop();
+	if (threadCount < 2)
+		return; // sequential execution
+	m_shutdown = false;
+	for (unsigned int i=1; i<threadCount; ++i)
+		m_workers.push_back( std::thread(&ThreadPool::workerLoop, this, m_batchCounter) );
+}
+
+
+void ThreadPool::stop() {
+	if (m_workers.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_shutdown = true;
+	}
+	m_wakeUp.notify_all();
+	for (std::thread & t : m_workers)
+		t.join();
+	m_workers.clear();
+}
+
+
+void ThreadPool::parallelFor(unsigned int taskCount, const std::function<void(unsigned int)> & task) {
+	if (taskCount == 0)
+		return;
+
+	// without workers or with only one task, we simply run everything in the calling thread
+	if (m_workers.empty() || taskCount == 1) {
+		for (unsigned int i=0; i<taskCount; ++i)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		IBK_ASSERT(m_task == nullptr); // no nested calls allowed
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_nextTask = 0;
+	}
+	runBatch(&ThreadPool::processTasks);
+}
+
+
+void ThreadPool::runTaskGraph(const std::vector< std::vector<unsigned int> > & successors,
+							  const std::function<void(unsigned int)> & task)
+{
+	unsigned int taskCount = (unsigned int)successors.size();
+	if (taskCount == 0)
+		return;
+
+	// without workers, we simply run everything in index order, which respects all dependencies
+	if (m_workers.empty() || taskCount == 1) {
+		for (unsigned int i=0; i<taskCount; ++i)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		IBK_ASSERT(m_task == nullptr); // no nested calls allowed
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_successors = &successors;
+		m_pendingPredecessors.assign(taskCount, 0);
+		for (unsigned int i=0; i<taskCount; ++i) {
+			for (unsigned int j=0; j<successors[i].size(); ++j) {
+				IBK_ASSERT(successors[i][j] > i && successors[i][j] < taskCount);
+				++m_pendingPredecessors[successors[i][j]];
+			}
+		}
+		m_readyTasks.clear();
+		for (unsigned int i=0; i<taskCount; ++i)
+			if (m_pendingPredecessors[i] == 0)
+				m_readyTasks.insert(i);
+		m_runningTasks = 0;
+		m_completedTasks = 0;
+		m_graphAborted = false;
+	}
+	runBatch(&ThreadPool::processGraphTasks);
+}
+
+
+void ThreadPool::runBatch(void (ThreadPool::*batchFunction)()) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_batchFunction = batchFunction;
+		m_exception = nullptr;
+		m_busyWorkers = (unsigned int)m_workers.size();
+		++m_batchCounter;
+	}
+	m_wakeUp.notify_all();
+
+	// calling thread works as well
+	(this->*batchFunction)();
+
+	// barrier: wait until all workers have finished their last task
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_batchDone.wait(lock, [this]() { return m_busyWorkers == 0; });
+	m_task = nullptr;
+
+	if (m_exception != nullptr) {
+		std::exception_ptr ex = m_exception;
+		m_exception = nullptr;
+		lock.unlock();
+		std::rethrow_exception(ex);
+	}
+}
+
+
+void ThreadPool::workerLoop(unsigned int lastBatch) {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [this, lastBatch]() { return m_shutdown || m_batchCounter != lastBatch; });
+			if (m_shutdown)
+				return;
+			lastBatch = m_batchCounter;
+		}
+
+		(this->*m_batchFunction)();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_busyWorkers;
+		}
+		m_batchDone.notify_one();
+	}
+}
+
+
+void ThreadPool::processTasks() {
+	while (true) {
+		unsigned int i = m_nextTask++;
+		if (i >= m_taskCount)
+			return;
+		runTask(i);
+	}
+}
+
+
+void ThreadPool::processGraphTasks() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		if (m_completedTasks == m_taskCount || (m_graphAborted && m_runningTasks == 0))
+			break; // all done
+		if (m_readyTasks.empty() || m_graphAborted) {
+			// wait for running tasks to complete
+			m_taskDone.wait(lock);
+			continue;
+		}
+
+		// take ready task with lowest index
+		unsigned int i = *m_readyTasks.begin();
+		m_readyTasks.erase(m_readyTasks.begin());
+		++m_runningTasks;
+		lock.unlock();
+		bool success = runTask(i);
+		lock.lock();
+		--m_runningTasks;
+		++m_completedTasks;
+		if (!success)
+			m_graphAborted = true;
+		// release all successors whose dependencies are now fulfilled
+		const std::vector<unsigned int> & succ = (*m_successors)[i];
+		for (unsigned int j=0; j<succ.size(); ++j)
+			if (--m_pendingPredecessors[succ[j]] == 0)
+				m_readyTasks.insert(succ[j]);
+		m_taskDone.notify_all();
+	}
+}
+
+
+bool ThreadPool::runTask(unsigned int i) {
+	try {
+		(*m_task)(i);
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_exception == nullptr || i < m_exceptionTask) {
+			m_exception = std::current_exception();
+			m_exceptionTask = i;
+		}
+		return false;
+	}
+	return true;
+}
+
+} // namespace MASTER_SIM
@@ -0,0 +1,136 @@
+#ifndef MSIM_THREADPOOL_H
+#define MSIM_THREADPOOL_H
+
+#include <vector>
+#include <set>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace MASTER_SIM {
+
+/*! A persistent pool of worker threads used by the master algorithms to evaluate
+	independent slaves concurrently.
+
+	Worker threads are created once in start() and sleep between calls to parallelFor().
+	The calling thread takes part in the work as well, so a pool with thread count n
+	creates n-1 worker threads.
+
+	\code
+	ThreadPool pool;
+	pool.start(4);
+	pool.parallelFor(slaves.size(), [&](unsigned int i) {
+		slaves[i]->doStep(h, true);
+	});
+	// all tasks are completed here
+	\endcode
+*/
+class ThreadPool {
+public:
+	/*! Constructor, creates an inactive pool (all work is done by the calling thread). */
+	ThreadPool();
+	/*! Destructor, stops and joins all worker threads. */
+	~ThreadPool();
+
+	/*! Creates threadCount-1 worker threads.
+		Calling start() on an already running pool restarts the pool with the new thread count.
+		\param threadCount Total number of threads including the calling thread, 0 and 1 disable parallel execution.
+	*/
+	void start(unsigned int threadCount);
+
+	/*! Stops and joins all worker threads. */
+	void stop();
+
+	/*! Total number of threads working on tasks (including calling thread), at least 1. */
+	unsigned int threadCount() const { return (unsigned int)m_workers.size() + 1; }
+
+	/*! Executes task(i) for all i in [0, taskCount) and returns once all tasks have completed.
+		Tasks are handed out in ascending index order, but may complete in any order.
+		If any task throws an exception, remaining tasks are still processed and the
+		exception of the task with the lowest index is re-thrown in the calling thread.
+		\note Must not be called from within a task.
+	*/
+	void parallelFor(unsigned int taskCount, const std::function<void(unsigned int)> & task);
+
+	/*! Executes task(i) for all nodes i of a task graph and returns once all tasks have completed.
+		A task is started once all tasks it depends on have completed. Among all ready tasks, the one with
+		the lowest index is started first.
+		\param successors Successor lists of all tasks (size defines task count), successors[i] holds the indexes
+			of all tasks that must not start before task i has completed. Successor indexes must be larger than i,
+			so that sequential execution in index order respects all dependencies.
+		\param task Task function, called with task index.
+		If any task throws an exception, no further tasks are started, and the exception of the task with the
+		lowest index is re-thrown in the calling thread after all running tasks have completed.
+		\note Must not be called from within a task.
+	*/
+	void runTaskGraph(const std::vector< std::vector<unsigned int> > & successors,
+					  const std::function<void(unsigned int)> & task);
+
+private:
+	/*! Main loop of worker threads.
+		\param lastBatch Batch counter at time of thread creation (batches up to this one are ignored).
+	*/
+	void workerLoop(unsigned int lastBatch);
+	/*! Grabs and executes tasks of the current batch until all have been handed out. */
+	void processTasks();
+	/*! Grabs and executes ready tasks of the current task graph until all are completed (or graph execution is aborted). */
+	void processGraphTasks();
+	/*! Executes m_task for task index i and stores exception, if any.
+		\return Returns false if task has thrown an exception.
+	*/
+	bool runTask(unsigned int i);
+	/*! Starts a new batch processed by all workers via the given member function and waits for completion. */
+	void runBatch(void (ThreadPool::*batchFunction)());
+
+	/*! Worker threads. */
+	std::vector<std::thread>					m_workers;
+
+	/*! Mutex guarding all members below. */
+	std::mutex									m_mutex;
+	/*! Signals workers that a new batch is available (or that the pool shuts down). */
+	std::condition_variable						m_wakeUp;
+	/*! Signals calling thread that all workers are done with the current batch. */
+	std::condition_variable						m_batchDone;
+
+	/*! Task of current batch (not owned, only valid during parallelFor()). */
+	const std::function<void(unsigned int)>		*m_task;
+	/*! Number of tasks in current batch. */
+	unsigned int								m_taskCount;
+	/*! Next task index to be handed out. */
+	std::atomic<unsigned int>					m_nextTask;
+	/*! Function executed by all threads to process current batch. */
+	void (ThreadPool::*m_batchFunction)();
+
+	/*! Successor lists of current task graph (not owned, only valid during runTaskGraph()). */
+	const std::vector< std::vector<unsigned int> >	*m_successors;
+	/*! Number of not yet completed predecessors for each task of current task graph. */
+	std::vector<unsigned int>					m_pendingPredecessors;
+	/*! Tasks of current task graph that are ready to be started, lowest index is started first. */
+	std::set<unsigned int>						m_readyTasks;
+	/*! Number of tasks of current task graph that are currently running. */
+	unsigned int								m_runningTasks;
+	/*! Number of completed tasks of current task graph. */
+	unsigned int								m_completedTasks;
+	/*! Set when a task of the current task graph has thrown an exception, no more tasks are started. */
+	bool										m_graphAborted;
+	/*! Signals waiting threads that a graph task has completed. */
+	std::condition_variable						m_taskDone;
+	/*! Incremented with each new batch, so that workers can tell batches apart. */
+	unsigned int								m_batchCounter;
+	/*! Number of workers still busy with current batch. */
+	unsigned int								m_busyWorkers;
+	/*! Set to true to let all workers exit their loop. */
+	bool										m_shutdown;
+
+	/*! Exception caught in task with lowest index of current batch (nullptr if none). */
+	std::exception_ptr							m_exception;
+	/*! Index of task that has thrown m_exception. */
+	unsigned int								m_exceptionTask;
+};
+
+} // namespace MASTER_SIM
+
+#endif // MSIM_THREADPOOL_H
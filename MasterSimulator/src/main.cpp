@@ -7,11 +7,14 @@
 #include <IBK_SolverArgsParser.h>
 #include <IBK_Exception.h>
 #include <IBK_messages.h>
+#include <IBK_StringUtils.h>
 
 #include <MSIM_MasterSim.h>
 #include <MSIM_Project.h>
 #include <MSIM_ArgParser.h>
 #include <MSIM_Constants.h>
+#include <MSIM_BinaryResults.h>
+#include <MSIM_CompressedResults.h>
 
 void setupLogFile(const MASTER_SIM::ArgParser & parser);
 
@@ -40,6 +43,25 @@ int main(int argc, char * argv[]) {
 			return EXIT_SUCCESS;
 		}
 
+		if (parser.hasOption("convert-results")) {
+			IBK::Path resultFile(parser.option("convert-results"));
+			bool compressed = (resultFile.extension() == "gz");
+			// 'values.csv.gz' -> 'values.csv', 'values.bin' -> 'values.csv'
+			IBK::Path csvFile(compressed ? resultFile.withoutExtension().str() : resultFile.withoutExtension().str() + ".csv");
+			std::cout << "Converting '" << resultFile.str() << "' to '" << csvFile.str() << "'" << std::endl;
+			if (compressed) {
+				MASTER_SIM::CompressedResultReader reader;
+				reader.open(resultFile);
+				reader.writeCSV(csvFile);
+			}
+			else {
+				MASTER_SIM::BinaryResultReader reader;
+				reader.open(resultFile);
+				reader.writeCSV(csvFile);
+			}
+			return EXIT_SUCCESS;
+		}
+
 		if (!parser.m_projectFile.isValid()) {
 			std::cerr << "Missing project file argument. Use --help for syntax." << std::endl;
 			return EXIT_FAILURE;
@@ -66,20 +88,20 @@ int main(int argc, char * argv[]) {
 		// initialize all FMUs (e.g. load dlls/shared libs, parse ModelDescription, do error checking
 		masterSim.importFMUs(parser, project);
 
-#ifdef HAVE_SERIALIZATION_CODE
-		// set master and all FMUs to start time point
-		double tStart = masterSim.tStart(); // override with command line argument
-		masterSim.restoreState(tStart, stateDir);
-		// (re-)open output file
-		masterSim.openOutputFile(true);
-#else
-		// run master for entire simulation
+		// initialize all slaves and the master (enter and exit initialization mode)
 		masterSim.initialize();
-		// (re-)create output file
-		masterSim.openOutputFiles(false);
-		// and write initial conditions
-		masterSim.appendOutputs();
-#endif
+		if (parser.flagEnabled("restart")) {
+			// set master and all FMUs to state of last checkpoint, outputs written after checkpoint are discarded
+			masterSim.restoreState(masterSim.checkpointDirectory());
+			// re-open output files and append to existing outputs
+			masterSim.openOutputFiles(true);
+		}
+		else {
+			// (re-)create output file
+			masterSim.openOutputFiles(false);
+			// and write initial conditions
+			masterSim.appendOutputs();
+		}
 
 		if (parser.flagEnabled("test-init")) {
 			IBK::IBK_Message("Stopping after successful initialization.\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
@@ -92,9 +114,24 @@ int main(int argc, char * argv[]) {
 		IBK::MessageHandlerRegistry::instance().messageHandler()->setConsoleVerbosityLevel( std::max<int>(IBK::VL_STANDARD, (int)parser.m_verbosityLevel));
 		IBK::MessageHandlerRegistry::instance().messageHandler()->setLogfileVerbosityLevel( std::max<int>(IBK::VL_STANDARD, (int)parser.m_verbosityLevel));
 
+		if (parser.hasOption("test-stop")) {
+			// stop the simulation at the given time like an interrupted run, it can be resumed with --restart
+			masterSim.simulate(IBK::string2val<double>(parser.option("test-stop")));
+			IBK::IBK_Message("Stopping simulation before end time.\n", IBK::MSG_PROGRESS, FUNC_ID, IBK::VL_STANDARD);
+			masterSim.freeSlaves();
+			return EXIT_SUCCESS;
+		}
+
 		// let master run the simulation until end
 		masterSim.simulate();
 
+		if (parser.hasOption("test-rewind")) {
+			// rewind to an earlier snapshot and simulate the remaining time again, outputs written after the
+			// snapshot are replaced and must be identical to those of the first run
+			masterSim.restoreSnapshot(IBK::string2val<double>(parser.option("test-rewind")));
+			masterSim.simulate();
+		}
+
 		// print final statistics
 		masterSim.writeMetrics();
 
@@ -135,6 +135,30 @@ void FourRealInputVars::integrateTo(double tCommunicationIntervalEnd) {
 }
 
 
+bool FourRealInputVars::directionalDerivative(const unsigned int vUnknown_ref[], size_t nUnknown,
+											  const unsigned int vKnown_ref[], size_t nKnown,
+											  const double dvKnown[], double dvUnknown[])
+{
+	// partial derivatives of Result = V1 - V2 + V3*V4
+	double dResult = 0;
+	for (size_t j=0; j<nKnown; ++j) {
+		switch (vKnown_ref[j]) {
+			case FMI_INPUT_V1 : dResult += dvKnown[j]; break;
+			case FMI_INPUT_V2 : dResult -= dvKnown[j]; break;
+			case FMI_INPUT_V3 : dResult += m_realVar[FMI_INPUT_V4]*dvKnown[j]; break;
+			case FMI_INPUT_V4 : dResult += m_realVar[FMI_INPUT_V3]*dvKnown[j]; break;
+			default : return false; // not an input variable
+		}
+	}
+	for (size_t i=0; i<nUnknown; ++i) {
+		if (vUnknown_ref[i] != FMI_OUTPUT_Result)
+			return false;
+		dvUnknown[i] = dResult;
+	}
+	return true;
+}
+
+
 void FourRealInputVars::computeFMUStateSize() {
 	// store time, states and outputs
 	m_fmuStateSize = sizeof(double)*1;
@@ -61,6 +61,11 @@ public:
 	/*! Called from fmi2DoStep(). */
 	virtual void integrateTo(double tCommunicationIntervalEnd);
 
+	/*! Called from fmi2GetDirectionalDerivative(), derivatives of Result with respect to the inputs. */
+	virtual bool directionalDerivative(const unsigned int vUnknown_ref[], size_t nUnknown,
+									   const unsigned int vKnown_ref[], size_t nKnown,
+									   const double dvKnown[], double dvUnknown[]);
+
 	// Functions for getting/setting the state
 
 	/*! This function computes the size needed for full serizalization of
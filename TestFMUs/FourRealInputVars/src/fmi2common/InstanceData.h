@@ -186,6 +186,19 @@ public:
 	*/
 	virtual bool deserializeFMUstate(void * FMUstate) { (void)FMUstate; return true; }
 
+	/*! Called from fmi2GetDirectionalDerivative().
+		Re-implement with your own code, computes dvUnknown = J*dvKnown with J being the partial derivatives
+		of the unknowns (vUnknown_ref) with respect to the knowns (vKnown_ref) at the current state.
+		\return Returns false if directional derivatives are not supported (default implementation).
+	*/
+	virtual bool directionalDerivative(const unsigned int vUnknown_ref[], size_t nUnknown,
+									   const unsigned int vKnown_ref[], size_t nKnown,
+									   const double dvKnown[], double dvUnknown[])
+	{
+		(void)vUnknown_ref; (void)nUnknown; (void)vKnown_ref; (void)nKnown; (void)dvKnown; (void)dvUnknown;
+		return false;
+	}
+
 	/*! Called from either doStep() or terminate() in CoSimulation mode whenever
 		a communication interval has been completed and all related buffers can be cleared/output files can be
 		written.
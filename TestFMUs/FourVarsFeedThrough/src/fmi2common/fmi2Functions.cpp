@@ -491,18 +491,31 @@ fmi2Status fmi2SerializeFMUstate(fmi2Component c, fmi2FMUstate FMUstate, fmi2Byt
 
 
 fmi2Status fmi2DeSerializeFMUstate(void* c, const char serializedState[], size_t s, fmi2FMUstate*  FMUstate) {
-	(void)s;
 	InstanceData * modelInstance = static_cast<InstanceData*>(c);
 	FMI_ASSERT(modelInstance != NULL);
 
-	// check if FMUstate is in list of stored FMU states
-	if (modelInstance->m_fmuStates.find(FMUstate) == modelInstance->m_fmuStates.end()) {
-		modelInstance->logger(fmi2Error, "logStatusError", "fmi2FreeFMUstate is called with invalid FMUstate (unknown or already released pointer).");
+	// serialized state must have been created by an FMU instance with the same state size
+	if (modelInstance->m_fmuStateSize == 0 || modelInstance->m_fmuStateSize != s) {
+		modelInstance->logger(fmi2Error, "logStatusError", "fmi2DeSerializeFMUstate is called with serialized state of invalid size.");
 		return fmi2Error;
 	}
 
-	// if the state of stored previously, then we must have a valid fmu size
-	FMI_ASSERT(modelInstance->m_fmuStateSize == s);
+	// check if new alloc is needed
+	if (*FMUstate == NULL) {
+		// alloc new memory
+		fmi2FMUstate fmuMem = malloc(modelInstance->m_fmuStateSize);
+		// remember this memory array
+		modelInstance->m_fmuStates.insert(fmuMem);
+		// return newly created FMU mem
+		*FMUstate = fmuMem;
+	}
+	else {
+		// check if FMUstate is in list of stored FMU states
+		if (modelInstance->m_fmuStates.find(*FMUstate) == modelInstance->m_fmuStates.end()) {
+			modelInstance->logger(fmi2Error, "logStatusError", "fmi2DeSerializeFMUstate is called with invalid FMUstate (unknown or already released pointer).");
+			return fmi2Error;
+		}
+	}
 
 	// copy memory
 	std::memcpy(*FMUstate, serializedState, modelInstance->m_fmuStateSize);
@@ -23,6 +23,8 @@
 
 #define FMI_INPUT_X3 3
 #define FMI_OUTPUT_X4 4
+#define FMI_PARA_DISCARD_TIME 5
+#define FMI_PARA_DISCARD_STEP_SIZE 6
 
 
 
@@ -43,6 +45,10 @@ Math003Part3::Math003Part3() :
 	// initialize input variables
 	m_realInput[FMI_INPUT_X3] = 0;
 
+	// initialize parameters (by default, no steps are discarded)
+	m_realInput[FMI_PARA_DISCARD_TIME] = -1;
+	m_realInput[FMI_PARA_DISCARD_STEP_SIZE] = 0;
+
 	// initialize output variables
 	m_realOutput[FMI_OUTPUT_X4] = 0; // initial value
 }
@@ -116,6 +122,14 @@ void Math003Part3::integrateTo(double tCommunicationIntervalEnd) {
 }
 
 
+bool Math003Part3::acceptStep(double tCommunicationIntervalEnd) {
+	double discardTime = m_realInput[FMI_PARA_DISCARD_TIME];
+	if (m_currentTimePoint < discardTime && tCommunicationIntervalEnd > discardTime)
+		return tCommunicationIntervalEnd - m_currentTimePoint <= m_realInput[FMI_PARA_DISCARD_STEP_SIZE];
+	return true;
+}
+
+
 void Math003Part3::computeFMUStateSize() {
 	// distinguish between ModelExchange and CoSimulation
 	if (m_modelExchange) {
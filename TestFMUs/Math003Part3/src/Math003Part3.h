@@ -40,6 +40,11 @@ public:
 	/*! Called from fmi2DoStep(). */
 	virtual void integrateTo(double tCommunicationIntervalEnd);
 
+	/*! Called from fmi2DoStep(), discards steps longer than parameter discardStepSize that pass
+		over the time point given in parameter discardTime (used to test step repetition in the master).
+	*/
+	virtual bool acceptStep(double tCommunicationIntervalEnd);
+
 	// Functions for getting/setting the state
 
 	/*! This function computes the size needed for full serizalization of
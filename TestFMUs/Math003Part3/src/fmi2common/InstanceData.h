@@ -97,6 +97,13 @@ public:
 	*/
 	virtual void integrateTo(double tCommunicationIntervalEnd) { (void)tCommunicationIntervalEnd; }
 
+	/*! Called from fmi2DoStep() before integrateTo(). If this function returns false, the
+		step is discarded (fmi2DoStep() returns fmi2Discard) and the FMU remains at the start of
+		the communication interval.
+		Re-implement in models that reject some communication steps. Default implementation accepts all steps.
+	*/
+	virtual bool acceptStep(double tCommunicationIntervalEnd) { (void)tCommunicationIntervalEnd; return true; }
+
 	/*! Send a logging message to FMU environment if logger is present.*/
 	void logger(fmi2Status state, fmi2String category, fmi2String msg);
 
@@ -1,5 +1,6 @@
 import os
 import filecmp
+import gzip
 from print_funcs import *
 
 class SolverStats:
@@ -125,10 +126,25 @@ class SolverStats:
 			# skip files without extension
 			if len(fileParts) < 2:
 				continue
+			if fileParts[1] == ".gz":
+				# for compressed files we compare the uncompressed content (compressed bytes may depend on zlib version)
+				if not(os.path.exists(os.path.join(dir2,f))):
+					printError("Missing file '{}'".format(os.path.join(dir2,f)))
+					fail = True
+				else:
+					try:
+						with gzip.open(os.path.join(dir1,f), 'rb') as fobj1, gzip.open(os.path.join(dir2,f), 'rb') as fobj2:
+							if fobj1.read() != fobj2.read():
+								printError("Mismatching uncompressed content of file '{}'".format(f))
+								fail = True
+					except (OSError, EOFError) as e:
+						printError("Error decompressing file '{}'".format(f))
+						fail = True
+				continue
 			# skip geometry files
-			if fileParts[1] == ".d6o" or fileParts[1] == ".tsv":
-				if fileParts[1] == ".tsv":
-					# for tsv files we do binary comparison
+			if fileParts[1] == ".d6o" or fileParts[1] == ".tsv" or fileParts[1] == ".csv":
+				if fileParts[1] == ".tsv" or fileParts[1] == ".csv":
+					# for tsv and csv files we do binary comparison
 					# check if both files exist
 					if not(os.path.exists(os.path.join(dir1,f))):
 						printError("Missing file '{}'".format(os.path.join(dir1,f)))
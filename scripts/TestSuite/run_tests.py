@@ -316,19 +316,35 @@ for project in projects:
 		else:
 			skipResultCheck = True
 
+	# try to read commandline file, each line holds the command line addon for one solver run; the runs
+	# are executed in sequence (e.g. to test restarts) and the results of the last run are checked;
+	# ${WorkingDir} is replaced by the working directory of the project (e.g. to address result files)
+	cmdlineAddOns = [""]
+	cmdlineFilePath = project + ".cmdline"
+	if os.path.exists(cmdlineFilePath):
+		fobj = open(cmdlineFilePath)
+		cmdlineAddOns = [line.strip().replace("${WorkingDir}", resultsFolder) for line in fobj.readlines() if len(line.strip()) > 0]
+		del fobj
+
 	try:
-		# run solver 
-		FNULL = open(os.devnull, 'w')
-		if platform.system() == "Windows":
-			cmdline.append("-x")
-			cmdline.append("--verbosity-level=0")
-			retcode = subprocess.call(cmdline, creationflags=subprocess.CREATE_NEW_CONSOLE)
-		else:
-			if args.test_init:
-				# in test-init mode we want to see the output
-				retcode = subprocess.call(cmdline)
+		for cmdlineAddOn in cmdlineAddOns:
+			runCmdline = cmdline + cmdlineAddOn.split()
+			if len(cmdlineAddOn) > 0:
+				print("Applying cmdline addon: " + cmdlineAddOn)
+			# run solver 
+			FNULL = open(os.devnull, 'w')
+			if platform.system() == "Windows":
+				runCmdline.append("-x")
+				runCmdline.append("--verbosity-level=0")
+				retcode = subprocess.call(runCmdline, creationflags=subprocess.CREATE_NEW_CONSOLE)
 			else:
-				retcode = subprocess.call(cmdline, stdout=FNULL, stderr=subprocess.STDOUT)
+				if args.test_init:
+					# in test-init mode we want to see the output
+					retcode = subprocess.call(runCmdline)
+				else:
+					retcode = subprocess.call(runCmdline, stdout=FNULL, stderr=subprocess.STDOUT)
+			if retcode != 0:
+				break
 		# check return code
 		if retcode == 0:
 			# successful run